@@ -37,6 +37,8 @@ namespace lime {
 		value Value ();
 		value Value (value imageBuffer);
 
+		static bool CheckBounds (ArrayBufferView* data, int offset, int stride, int width, int height);
+
 	};
 
 
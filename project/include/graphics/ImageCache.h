@@ -0,0 +1,89 @@
+#ifndef LIME_GRAPHICS_IMAGE_CACHE_H
+#define LIME_GRAPHICS_IMAGE_CACHE_H
+
+
+#include <graphics/ImageBuffer.h>
+#include <graphics/PixelFormat.h>
+#include <utils/Bytes.h>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+
+namespace lime {
+
+
+	struct ImageCacheEntry {
+
+		ImageCacheEntry ();
+		~ImageCacheEntry ();
+
+		ImageBuffer* buffer;
+		bool decoding;
+		PixelFormat format;
+		int id;
+		std::string key;
+		std::list<ImageCacheEntry*>::iterator lru;
+		std::string path;
+		int pins;
+		bool premultiplied;
+		bool resident;
+		int size;
+		Bytes* source;
+
+	};
+
+
+	class ImageCache {
+
+
+		public:
+
+			ImageCache (int memoryBudget);
+			~ImageCache ();
+
+			int Add (Bytes* data, PixelFormat format, bool premultiplied);
+			int Add (const char* path, PixelFormat format, bool premultiplied);
+			int Add (ImageBuffer* buffer);
+			void Clear ();
+			int GetEvictions ();
+			int GetHits ();
+			int GetMemoryBudget ();
+			int GetMemoryUsage ();
+			int GetMisses ();
+			bool IsResident (int id);
+			ImageBuffer* Pin (int id);
+			bool Remove (int id);
+			void SetMemoryBudget (int memoryBudget);
+			void Unpin (int id);
+
+		private:
+
+			bool Evict (ImageCacheEntry* entry);
+			ImageCacheEntry* Find (int id);
+			int Insert (ImageCacheEntry* entry);
+			int Size (ImageCacheEntry* entry);
+			void Trim (ImageCacheEntry* keep);
+
+			std::condition_variable decoded;
+			std::map<int, ImageCacheEntry*> entries;
+			int evictions;
+			int hits;
+			std::map<std::string, int> keys;
+			std::list<ImageCacheEntry*> lru;
+			int memoryBudget;
+			int memoryUsage;
+			int misses;
+			std::mutex mutex;
+			int nextID;
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
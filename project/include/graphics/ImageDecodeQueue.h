@@ -0,0 +1,79 @@
+#ifndef LIME_GRAPHICS_IMAGE_DECODE_QUEUE_H
+#define LIME_GRAPHICS_IMAGE_DECODE_QUEUE_H
+
+
+#include <graphics/ImageBuffer.h>
+#include <graphics/PixelFormat.h>
+#include <utils/Bytes.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace lime {
+
+
+	struct ImageDecodeJob {
+
+		ImageDecodeJob ();
+		~ImageDecodeJob ();
+
+		ImageBuffer* buffer;
+		bool cancelled;
+		Bytes* data;
+		PixelFormat format;
+		int id;
+		std::string path;
+		bool premultiplied;
+		int priority;
+		int reserved;
+		bool success;
+
+	};
+
+
+	class ImageDecodeQueue {
+
+
+		public:
+
+			ImageDecodeQueue (int numThreads, int memoryBudget);
+			~ImageDecodeQueue ();
+
+			bool Cancel (int id);
+			int GetMemoryUsage ();
+			int GetPending ();
+			ImageDecodeJob* Poll ();
+			int Submit (Bytes* data, PixelFormat format, bool premultiplied, int priority);
+			int Submit (const char* path, PixelFormat format, bool premultiplied, int priority);
+
+		private:
+
+			int Enqueue (ImageDecodeJob* job, PixelFormat format, bool premultiplied, int priority);
+			void Release (ImageDecodeJob* job);
+			void Run ();
+
+			static void ThreadMain (ImageDecodeQueue* queue);
+
+			std::vector<ImageDecodeJob*> active;
+			std::condition_variable budgetCondition;
+			std::vector<ImageDecodeJob*> completed;
+			int memoryBudget;
+			int memoryUsage;
+			std::mutex mutex;
+			int nextID;
+			std::vector<ImageDecodeJob*> pending;
+			bool running;
+			std::vector<std::thread> threads;
+			std::condition_variable workCondition;
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
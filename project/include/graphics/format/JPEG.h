@@ -3,6 +3,7 @@
 
 
 #include <graphics/ImageBuffer.h>
+#include <graphics/PixelFormat.h>
 #include <utils/Bytes.h>
 #include <utils/Resource.h>
 
@@ -15,7 +16,8 @@ namespace lime {
 
 		public:
 
-			static bool Decode (Resource *resource, ImageBuffer *imageBuffer, bool decodeData = true);
+			static bool Decode (Resource *resource, ImageBuffer *imageBuffer, bool decodeData = true, PixelFormat format = RGBA32, bool premultiplied = false);
+			static bool DecodeInto (Resource *resource, ImageBuffer *imageBuffer, int offset, int stride, PixelFormat format = RGBA32, bool premultiplied = false);
 			static bool Encode (ImageBuffer *imageBuffer, Bytes *bytes, int quality);
 
 
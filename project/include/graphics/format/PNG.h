@@ -3,6 +3,7 @@
 
 
 #include <graphics/ImageBuffer.h>
+#include <graphics/PixelFormat.h>
 #include <utils/Bytes.h>
 #include <utils/Resource.h>
 
@@ -10,13 +11,54 @@
 namespace lime {
 
 
+	enum PNGFilterStrategy {
+
+		FILTER_NONE,
+		FILTER_SUB,
+		FILTER_UP,
+		FILTER_AVERAGE,
+		FILTER_PAETH,
+		FILTER_ADAPTIVE
+
+	};
+
+
 	class PNG {
 
 
 		public:
 
-			static bool Decode (Resource *resource, ImageBuffer *imageBuffer, bool decodeData = true);
-			static bool Encode (ImageBuffer *imageBuffer, Bytes *bytes);
+			static bool Decode (Resource *resource, ImageBuffer *imageBuffer, bool decodeData = true, PixelFormat format = RGBA32, bool premultiplied = false, int maxWidth = 0, int maxHeight = 0);
+			static bool DecodeInto (Resource *resource, ImageBuffer *imageBuffer, int offset, int stride, PixelFormat format = RGBA32, bool premultiplied = false, int maxWidth = 0, int maxHeight = 0);
+			static bool Encode (ImageBuffer *imageBuffer, Bytes *bytes, int compression = -1, PNGFilterStrategy filter = FILTER_ADAPTIVE, bool detectAlpha = false, int numThreads = 1);
+
+
+	};
+
+
+	class PNGStreamDecoder {
+
+
+		public:
+
+			PNGStreamDecoder ();
+			~PNGStreamDecoder ();
+
+			bool Append (const unsigned char* data, int length);
+			float GetProgress ();
+			int GetRows ();
+
+			ImageBuffer* buffer;
+			bool complete;
+			bool error;
+			int pass;
+			int passes;
+			int rows;
+
+		private:
+
+			void* png_ptr;
+			void* info_ptr;
 
 
 	};
@@ -0,0 +1,30 @@
+#ifndef LIME_GRAPHICS_FORMAT_QOI_H
+#define LIME_GRAPHICS_FORMAT_QOI_H
+
+
+#include <graphics/ImageBuffer.h>
+#include <graphics/PixelFormat.h>
+#include <utils/Bytes.h>
+#include <utils/Resource.h>
+
+
+namespace lime {
+
+
+	class QOI {
+
+
+		public:
+
+			static bool Decode (Resource *resource, ImageBuffer *imageBuffer, bool decodeData = true, PixelFormat format = RGBA32, bool premultiplied = false);
+			static bool DecodeInto (Resource *resource, ImageBuffer *imageBuffer, int offset, int stride, PixelFormat format = RGBA32, bool premultiplied = false);
+			static bool Encode (ImageBuffer *imageBuffer, Bytes *bytes);
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
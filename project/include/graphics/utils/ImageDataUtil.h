@@ -10,6 +10,7 @@
 #include <system/CFFI.h>
 #include <system/Endian.h>
 #include <system/System.h>
+#include <utils/ArrayBufferView.h>
 #include <utils/Bytes.h>
 #include <stdint.h>
 
@@ -17,20 +18,38 @@
 namespace lime {
 
 
+	struct ImageDiff {
+
+		int height;
+		int maxDelta;
+		int mismatches;
+		double psnr;
+		int width;
+		int x;
+		int y;
+
+	};
+
+
 	class ImageDataUtil {
 
 
 		public:
 
+			static void AlphaBleed (Image* image, Rectangle* rect, int radius);
 			static void ColorTransform (Image* image, Rectangle* rect, ColorMatrix* ColorMatrix);
 			static void CopyChannel (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, int srcChannel, int destChannel);
-			static void CopyPixels (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, Image* alphaImage, Vector2* alphaPoint, bool mergeAlpha);
+			static void CopyPixels (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, Image* alphaImage, Vector2* alphaPoint, bool mergeAlpha, bool linear = false);
+			static void Diff (Image* image, Image* otherImage, Rectangle* rect, int tolerance, ImageDiff* result);
+			static void DrawTriangles (Image* image, Image* texture, ArrayBufferView* vertices, ArrayBufferView* indices, ArrayBufferView* uvs, int culling, bool smooth, bool repeat);
+			static void Extrude (Image* image, Rectangle* rect, int padding);
 			static void FillRect (Image* image, Rectangle* rect, int32_t color);
 			static void FloodFill (Image* image, int x, int y, int32_t color);
 			static void GetPixels (Image* image, Rectangle* rect, PixelFormat format, Bytes* pixels);
+			static uint64_t Hash (Image* image, Rectangle* rect);
 			static void Merge (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, int redMultiplier, int greenMultiplier, int blueMultiplier, int alphaMultiplier);
 			static void MultiplyAlpha (Image* image);
-			static void Resize (Image* image, ImageBuffer* buffer, int width, int height);
+			static void Resize (Image* image, ImageBuffer* buffer, int width, int height, bool linear = false);
 			static void SetFormat (Image* image, PixelFormat format);
 			static void SetPixels (Image* image, Rectangle* rect, Bytes* bytes, int offset, PixelFormat format, Endian endian);
 			static int Threshold (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, int operation, int32_t threshold, int32_t color, int32_t mask, bool copySource);
@@ -0,0 +1,25 @@
+#ifndef LIME_MATH_POLYGON_H
+#define LIME_MATH_POLYGON_H
+
+
+#include <vector>
+
+
+namespace lime {
+
+
+	class Polygon {
+
+
+		public:
+
+			static void Triangulate (const float* points, const int* rings, int numRings, std::vector<int>* triangles);
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef LIME_SYSTEM_PARALLEL_H
+#define LIME_SYSTEM_PARALLEL_H
+
+
+namespace lime {
+
+
+	typedef void (*ParallelTask) (int index, void* userData);
+
+
+	class Parallel {
+
+
+		public:
+
+			static void For (int count, int numThreads, ParallelTask task, void* userData);
+			static int GetConcurrency ();
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
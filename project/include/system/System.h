@@ -28,6 +28,7 @@ namespace lime {
 
 			static void GCEnterBlocking ();
 			static void GCExitBlocking ();
+			static void GCIgnoreThread ();
 			static void GCTryEnterBlocking ();
 			static void GCTryExitBlocking ();
 			static bool GetAllowScreenTimeout ();
@@ -57,6 +58,7 @@ namespace lime {
 		private:
 
 			static bool _isHL;
+			static thread_local bool _isUnmanagedThread;
 
 
 	};
@@ -5,6 +5,7 @@
 #include <graphics/ImageBuffer.h>
 #include <system/CFFI.h>
 #include <system/System.h>
+#include <text/FontMemory.h>
 #include <utils/Resource.h>
 
 #ifdef HX_WINDOWS
@@ -37,6 +38,16 @@ namespace lime {
 	} GlyphImage;
 
 
+	enum GlyphRenderMode {
+
+		GLYPH_RENDER_LCD,
+		GLYPH_RENDER_A8,
+		GLYPH_RENDER_MONO,
+		GLYPH_RENDER_SDF
+
+	};
+
+
 	class Font {
 
 
@@ -46,27 +57,65 @@ namespace lime {
 			~Font ();
 
 			void* Decompose (bool useCFFIValue, int em);
+			int DecomposeGlyphs (int em, const int* indices, int count, Bytes *output);
 			int GetAscender ();
 			int GetDescender ();
 			wchar_t *GetFamilyName ();
 			int GetGlyphIndex (const char* character);
 			void* GetGlyphIndices (bool useCFFIValue, const char* characters);
+			int GetGlyphIndices (const char* characters, Bytes *indices);
 			void* GetGlyphMetrics (bool useCFFIValue, int index);
+			int GetGlyphMetrics (const int* indices, int count, int* metrics);
 			int GetHeight ();
+			unsigned long long GetID ();
 			int GetNumGlyphs ();
+			GlyphRenderMode GetRenderMode ();
+			int GetSDFSpread ();
 			int GetUnderlinePosition ();
 			int GetUnderlineThickness ();
 			int GetUnitsPerEM ();
+			void* NewFace ();
 			int RenderGlyph (int index, Bytes *bytes, int offset = 0);
 			int RenderGlyphs (value indices, Bytes *bytes);
+			int RenderGlyphs (const int* indices, int count, Bytes *bytes, int numThreads);
+			void* RetainFace ();
+			void SetRenderMode (GlyphRenderMode mode);
+			void SetSDFSpread (int spread);
 			void SetSize (size_t size, size_t dpi);
+			int TriangulateGlyphs (int em, const int* indices, int count, float tolerance, Bytes *output);
+
+			static void ReleaseFace (void* face);
+			static void SetCacheBudget (int bytes);
 
 			void* library;
 			void* face;
-			void* faceMemory;
+			FontMemory* faceMemory;
 
 		private:
 
+			int DecomposeOutlines (int em, const int* indices, int count, float tolerance, Bytes *output);
+			bool GetCacheScaler (void* scaler);
+			int GetGlyphIndices (const char* characters, int length, int* indices);
+			unsigned short* GetGlyphTable ();
+			void* GetMetricsCache ();
+			void* LoadGlyph (int index, int flags, void* renderFace);
+			bool LoadGlyphMetrics (int index, void* metrics, void* metricsCache);
+			int RenderGlyphFace (int index, Bytes *bytes, int offset, void* renderFace);
+			int RenderGlyphLCD (int index, Bytes *bytes, int offset, void* renderFace);
+			int RenderGlyphMask (int index, Bytes *bytes, int offset, void* renderFace);
+			int RenderGlyphSDF (int index, Bytes *bytes, int offset, void* renderFace);
+
+			static void RenderGlyphsTask (int index, void* userData);
+
+			int faceIndex;
+			int mCharHeight;
+			int mDPI;
+			unsigned long long mID;
+			unsigned short* mGlyphTable;
+			void* mMetrics;
+			GlyphRenderMode mRenderMode;
+			long mScale;
+			int mSDFSpread;
 			size_t mSize;
 
 	};
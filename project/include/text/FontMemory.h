@@ -0,0 +1,42 @@
+#ifndef LIME_TEXT_FONT_MEMORY_H
+#define LIME_TEXT_FONT_MEMORY_H
+
+
+#include <stddef.h>
+#include <string>
+
+
+namespace lime {
+
+
+	class FontMemory {
+
+
+		public:
+
+			static FontMemory* Create (const unsigned char* data, size_t size);
+			static FontMemory* Open (const char* path);
+
+			void Release ();
+			FontMemory* Retain ();
+
+			const unsigned char* data;
+			size_t size;
+
+		private:
+
+			FontMemory ();
+			~FontMemory ();
+
+			bool mapped;
+			std::string path;
+			int refs;
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
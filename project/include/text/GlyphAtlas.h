@@ -0,0 +1,123 @@
+#ifndef LIME_TEXT_GLYPH_ATLAS_H
+#define LIME_TEXT_GLYPH_ATLAS_H
+
+
+#include <graphics/ImageBuffer.h>
+#include <text/Font.h>
+#include <utils/ArrayBufferView.h>
+#include <utils/Bytes.h>
+#include <unordered_map>
+#include <vector>
+
+
+namespace lime {
+
+
+	struct GlyphAtlasKey {
+
+		unsigned long long font;
+		int index;
+		int mode;
+		long scale;
+
+		bool operator== (const GlyphAtlasKey& other) const;
+
+	};
+
+
+	struct GlyphAtlasKeyHash {
+
+		size_t operator() (const GlyphAtlasKey& key) const;
+
+	};
+
+
+	struct GlyphAtlasEntry {
+
+		int height;
+		int offsetX;
+		int offsetY;
+		int page;
+		int width;
+		int x;
+		int y;
+
+	};
+
+
+	struct GlyphAtlasNode {
+
+		int width;
+		int x;
+		int y;
+
+	};
+
+
+	struct GlyphAtlasRect {
+
+		int height;
+		int page;
+		int width;
+		int x;
+		int y;
+
+	};
+
+
+	struct GlyphAtlasPage {
+
+		GlyphAtlasPage (int width, int height, int bitsPerPixel);
+		~GlyphAtlasPage ();
+
+		ImageBuffer* buffer;
+		GlyphAtlasRect dirty;
+		std::vector<GlyphAtlasKey> keys;
+		int lastFrame;
+		std::vector<GlyphAtlasNode> skyline;
+
+	};
+
+
+	class GlyphAtlas {
+
+
+		public:
+
+			GlyphAtlas (int pageWidth, int pageHeight, int maxPages, int bitsPerPixel, int padding);
+			~GlyphAtlas ();
+
+			GlyphAtlasEntry* AddGlyph (Font* font, int index);
+			int AddGlyphs (Font* font, ArrayBufferView* indices, ArrayBufferView* rects);
+			void Clear ();
+			void Flush (std::vector<GlyphAtlasRect>* dirty);
+			int GetEvictions ();
+			ImageBuffer* GetPage (int page);
+			int GetPageCount ();
+			void RemoveFont (Font* font);
+
+		private:
+
+			void Blit (GlyphAtlasPage* page, int x, int y, GlyphImage* image, GlyphRenderMode mode);
+			bool Pack (GlyphAtlasPage* page, int width, int height, int* x, int* y);
+			void Reset (GlyphAtlasPage* page);
+
+			int bitsPerPixel;
+			std::unordered_map<GlyphAtlasKey, GlyphAtlasEntry, GlyphAtlasKeyHash> entries;
+			int evictions;
+			int frame;
+			int maxPages;
+			int padding;
+			int pageHeight;
+			std::vector<GlyphAtlasPage*> pages;
+			int pageWidth;
+			Bytes* scratch;
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef LIME_TEXT_SHAPE_CACHE_H
+#define LIME_TEXT_SHAPE_CACHE_H
+
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace lime {
+
+
+	struct ShapeCacheEntry {
+
+		std::string glyphs;
+		std::string key;
+		int length;
+		std::list<ShapeCacheEntry*>::iterator lru;
+		int size;
+
+	};
+
+
+	class ShapeCache {
+
+
+		public:
+
+			ShapeCache (int memoryBudget);
+			~ShapeCache ();
+
+			void Clear ();
+			int GetEntries ();
+			int GetEvictions ();
+			int GetHits ();
+			int GetMemoryBudget ();
+			int GetMemoryUsage ();
+			int GetMisses ();
+			void SetMemoryBudget (int memoryBudget);
+			bool Shape (void* font, void* buffer, const void* features, int numFeatures);
+
+		private:
+
+			void Trim ();
+
+			std::unordered_map<std::string, ShapeCacheEntry*> entries;
+			int evictions;
+			int hits;
+			std::list<ShapeCacheEntry*> lru;
+			int memoryBudget;
+			int memoryUsage;
+			int misses;
+			std::mutex mutex;
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef LIME_TEXT_TEXT_LAYOUT_H
+#define LIME_TEXT_TEXT_LAYOUT_H
+
+
+#include <text/Font.h>
+#include <utils/Bytes.h>
+#include <vector>
+
+
+namespace lime {
+
+
+	enum TextLayoutAlign {
+
+		TEXT_ALIGN_LEFT,
+		TEXT_ALIGN_RIGHT,
+		TEXT_ALIGN_CENTER,
+		TEXT_ALIGN_JUSTIFY,
+		TEXT_ALIGN_START,
+		TEXT_ALIGN_END
+
+	};
+
+
+	struct TextLayoutChar {
+
+		int breakClass;
+		bool breakBefore;
+		unsigned int codepoint;
+		int font;
+		int level;
+		int offset;
+		int script;
+		int utf16;
+
+	};
+
+
+	struct TextLayoutGlyph {
+
+		int advance;
+		int character;
+		int cluster;
+		int font;
+		int index;
+		int offsetX;
+		int offsetY;
+		int run;
+
+	};
+
+
+	struct TextLayoutLine {
+
+		int ascent;
+		int descent;
+		int glyphEnd;
+		int glyphStart;
+		int height;
+		bool paragraphEnd;
+		bool rtl;
+		int textEnd;
+		int textStart;
+		int width;
+
+	};
+
+
+	struct TextLayoutRun {
+
+		int end;
+		int font;
+		int glyphEnd;
+		int glyphStart;
+		int level;
+		int script;
+		int start;
+
+	};
+
+
+	class TextLayout {
+
+
+		public:
+
+			TextLayout ();
+			~TextLayout ();
+
+			void AddFont (Font* font);
+			void ClearFonts ();
+			int Layout (const char* text, int size, int width, TextLayoutAlign align, Bytes* output);
+
+		private:
+
+			void BreakLines (int glyphStart, int width, bool rtl, int textStart, int textEnd);
+			void Itemize (int charStart, int charEnd, bool* rtl);
+			void Shape (const char* text, int length, int runStart);
+			int Write (int width, TextLayoutAlign align, Bytes* output);
+
+			void* buffer;
+			std::vector<TextLayoutChar> chars;
+			std::vector<void*> faces;
+			std::vector<TextLayoutGlyph> glyphs;
+			std::vector<void*> hbFonts;
+			std::vector<TextLayoutLine> lines;
+			std::vector<TextLayoutRun> runs;
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef LIME_UTILS_BUFFER_POOL_H
+#define LIME_UTILS_BUFFER_POOL_H
+
+
+#include <stddef.h>
+
+
+namespace lime {
+
+
+	class BufferPool {
+
+
+		public:
+
+			static void* Allocate (size_t size);
+			static void Clear ();
+			static size_t GetBytesRetained ();
+			static size_t GetCapacity (const void* data);
+			static int GetHits ();
+			static int GetMisses ();
+			static size_t GetRetention ();
+			static bool Release (void* data);
+			static void SetRetention (size_t bytes);
+
+
+	};
+
+
+}
+
+
+#endif
\ No newline at end of file
@@ -12,9 +12,12 @@
 #include <app/ApplicationEvent.h>
 #include <graphics/format/JPEG.h>
 #include <graphics/format/PNG.h>
+#include <graphics/format/QOI.h>
 #include <graphics/utils/ImageDataUtil.h>
 #include <graphics/Image.h>
 #include <graphics/ImageBuffer.h>
+#include <graphics/ImageCache.h>
+#include <graphics/ImageDecodeQueue.h>
 #include <graphics/RenderEvent.h>
 #include <media/containers/OGG.h>
 #include <media/containers/WAV.h>
@@ -29,6 +32,7 @@
 #include <system/SensorEvent.h>
 #include <system/System.h>
 #include <text/Font.h>
+#include <text/GlyphAtlas.h>
 #include <ui/Cursor.h>
 #include <ui/DropEvent.h>
 #include <ui/FileDialog.h>
@@ -44,6 +48,7 @@
 #include <ui/TouchEvent.h>
 #include <ui/Window.h>
 #include <ui/WindowEvent.h>
+#include <utils/BufferPool.h>
 #include <utils/compress/LZMA.h>
 #include <utils/compress/Zlib.h>
 #include <vm/NekoVM.h>
@@ -63,6 +68,45 @@ DEFINE_KIND (k_finalizer);
 namespace lime {
 
 
+	static int id_bitsPerPixel;
+	static int id_format;
+	static int id_height;
+	static int id_maxDelta;
+	static int id_mismatches;
+	static int id_page;
+	static int id_premultiplied;
+	static int id_psnr;
+	static int id_transparent;
+	static int id_width;
+	static int id_x;
+	static int id_y;
+	static bool init = false;
+
+
+	static void initialize () {
+
+		if (!init) {
+
+			id_bitsPerPixel = val_id ("bitsPerPixel");
+			id_format = val_id ("format");
+			id_height = val_id ("height");
+			id_maxDelta = val_id ("maxDelta");
+			id_mismatches = val_id ("mismatches");
+			id_page = val_id ("page");
+			id_premultiplied = val_id ("premultiplied");
+			id_psnr = val_id ("psnr");
+			id_transparent = val_id ("transparent");
+			id_width = val_id ("width");
+			id_x = val_id ("x");
+			id_y = val_id ("y");
+
+			init = true;
+
+		}
+
+	}
+
+
 	void gc_application (value handle) {
 
 		Application* application = (Application*)val_data (handle);
@@ -119,6 +163,74 @@ namespace lime {
 	}
 
 
+	void gc_glyph_atlas (value handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)val_data (handle);
+		delete atlas;
+
+	}
+
+
+	void hl_gc_glyph_atlas (HL_CFFIPointer* handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)handle->ptr;
+		delete atlas;
+
+	}
+
+
+	void gc_image_cache (value handle) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		delete cache;
+
+	}
+
+
+	void hl_gc_image_cache (HL_CFFIPointer* handle) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		delete cache;
+
+	}
+
+
+	void gc_image_decode_queue (value handle) {
+
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)val_data (handle);
+		delete queue;
+
+	}
+
+
+	void hl_gc_image_decode_queue (HL_CFFIPointer* handle) {
+
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)handle->ptr;
+		delete queue;
+
+	}
+
+
+	void gc_png_stream_decoder (value handle) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)val_data (handle);
+		delete decoder;
+		#endif
+
+	}
+
+
+	void hl_gc_png_stream_decoder (HL_CFFIPointer* handle) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)handle->ptr;
+		delete decoder;
+		#endif
+
+	}
+
+
 	void gc_window (value handle) {
 
 		Window* window = (Window*)val_data (handle);
@@ -493,6 +605,76 @@ namespace lime {
 	}
 
 
+	void lime_buffer_pool_clear () {
+
+		BufferPool::Clear ();
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_buffer_pool_clear) () {
+
+		BufferPool::Clear ();
+
+	}
+
+
+	int lime_buffer_pool_get_bytes_retained () {
+
+		return (int)BufferPool::GetBytesRetained ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_buffer_pool_get_bytes_retained) () {
+
+		return (int)BufferPool::GetBytesRetained ();
+
+	}
+
+
+	int lime_buffer_pool_get_hits () {
+
+		return BufferPool::GetHits ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_buffer_pool_get_hits) () {
+
+		return BufferPool::GetHits ();
+
+	}
+
+
+	int lime_buffer_pool_get_misses () {
+
+		return BufferPool::GetMisses ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_buffer_pool_get_misses) () {
+
+		return BufferPool::GetMisses ();
+
+	}
+
+
+	void lime_buffer_pool_set_retention (int bytes) {
+
+		BufferPool::SetRetention (bytes < 0 ? 0 : bytes);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_buffer_pool_set_retention) (int bytes) {
+
+		BufferPool::SetRetention (bytes < 0 ? 0 : bytes);
+
+	}
+
+
 	value lime_bytes_from_data_pointer (double data, int length, value _bytes) {
 
 		uintptr_t ptr = (uintptr_t)data;
@@ -1242,6 +1424,33 @@ namespace lime {
 	}
 
 
+	value lime_font_get_glyph_indices_packed (value fontHandle, HxString characters, value data) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)val_data (fontHandle);
+		Bytes bytes (data);
+		font->GetGlyphIndices (hxs_utf8 (characters, nullptr), &bytes);
+		return bytes.Value (data);
+		#else
+		return alloc_null ();
+		#endif
+
+	}
+
+
+	HL_PRIM Bytes* HL_NAME(hl_font_get_glyph_indices_packed) (HL_CFFIPointer* fontHandle, hl_vstring* characters, Bytes* data) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)fontHandle->ptr;
+		font->GetGlyphIndices (characters ? (char*)hl_to_utf8 ((const uchar*)characters->bytes) : NULL, data);
+		return data;
+		#else
+		return NULL;
+		#endif
+
+	}
+
+
 	value lime_font_get_glyph_metrics (value fontHandle, int index) {
 
 		#ifdef LIME_FREETYPE
@@ -1266,6 +1475,44 @@ namespace lime {
 	}
 
 
+	int lime_font_get_glyph_metrics_batch (value fontHandle, value indices, value metrics) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)val_data (fontHandle);
+		ArrayBufferView _indices = ArrayBufferView (indices);
+		ArrayBufferView _metrics = ArrayBufferView (metrics);
+
+		if (_indices.buffer && _metrics.buffer) {
+
+			int count = _indices.byteLength / 4 < _metrics.byteLength / 32 ? _indices.byteLength / 4 : _metrics.byteLength / 32;
+			return font->GetGlyphMetrics ((const int*)_indices.buffer->b, count, (int*)_metrics.buffer->b);
+
+		}
+		#endif
+
+		return 0;
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_font_get_glyph_metrics_batch) (HL_CFFIPointer* fontHandle, ArrayBufferView* indices, ArrayBufferView* metrics) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)fontHandle->ptr;
+
+		if (indices && metrics && indices->buffer && metrics->buffer) {
+
+			int count = indices->byteLength / 4 < metrics->byteLength / 32 ? indices->byteLength / 4 : metrics->byteLength / 32;
+			return font->GetGlyphMetrics ((const int*)indices->buffer->b, count, (int*)metrics->buffer->b);
+
+		}
+		#endif
+
+		return 0;
+
+	}
+
+
 	int lime_font_get_height (value fontHandle) {
 
 		#ifdef LIME_FREETYPE
@@ -1537,6 +1784,64 @@ namespace lime {
 	}
 
 
+	value lime_font_outline_decompose_packed (value fontHandle, int size, value indices, value data) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)val_data (fontHandle);
+		ArrayBufferView _indices = ArrayBufferView (indices);
+		Bytes bytes (data);
+		font->DecomposeGlyphs (size, _indices.byteLength > 0 ? (const int*)_indices.buffer->b : NULL, _indices.byteLength / 4, &bytes);
+		return bytes.Value (data);
+		#else
+		return alloc_null ();
+		#endif
+
+	}
+
+
+	HL_PRIM Bytes* HL_NAME(hl_font_outline_decompose_packed) (HL_CFFIPointer* fontHandle, int size, ArrayBufferView* indices, Bytes* data) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)fontHandle->ptr;
+		bool hasIndices = indices && indices->buffer && indices->byteLength > 0;
+		font->DecomposeGlyphs (size, hasIndices ? (const int*)indices->buffer->b : NULL, hasIndices ? indices->byteLength / 4 : 0, data);
+		return data;
+		#else
+		return NULL;
+		#endif
+
+	}
+
+
+	value lime_font_outline_triangulate (value fontHandle, int size, value indices, double tolerance, value data) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)val_data (fontHandle);
+		ArrayBufferView _indices = ArrayBufferView (indices);
+		Bytes bytes (data);
+		font->TriangulateGlyphs (size, _indices.byteLength > 0 ? (const int*)_indices.buffer->b : NULL, _indices.byteLength / 4, tolerance, &bytes);
+		return bytes.Value (data);
+		#else
+		return alloc_null ();
+		#endif
+
+	}
+
+
+	HL_PRIM Bytes* HL_NAME(hl_font_outline_triangulate) (HL_CFFIPointer* fontHandle, int size, ArrayBufferView* indices, double tolerance, Bytes* data) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)fontHandle->ptr;
+		bool hasIndices = indices && indices->buffer && indices->byteLength > 0;
+		font->TriangulateGlyphs (size, hasIndices ? (const int*)indices->buffer->b : NULL, hasIndices ? indices->byteLength / 4 : 0, tolerance, data);
+		return data;
+		#else
+		return NULL;
+		#endif
+
+	}
+
+
 	value lime_font_render_glyph (value fontHandle, int index, value data) {
 
 		#ifdef LIME_FREETYPE
@@ -1602,84 +1907,178 @@ namespace lime {
 	}
 
 
-	void lime_font_set_size (value fontHandle, int fontSize, int dpi) {
+	value lime_font_render_glyphs_parallel (value fontHandle, value indices, value data, int numThreads) {
 
 		#ifdef LIME_FREETYPE
 		Font *font = (Font*)val_data (fontHandle);
-		font->SetSize (fontSize, dpi);
-		#endif
-
-	}
+		ArrayBufferView _indices = ArrayBufferView (indices);
+		Bytes bytes (data);
 
+		if (_indices.buffer && font->RenderGlyphs ((const int*)_indices.buffer->b, _indices.byteLength / 4, &bytes, numThreads)) {
 
-	HL_PRIM void HL_NAME(hl_font_set_size) (HL_CFFIPointer* fontHandle, int fontSize, int dpi) {
+			return bytes.Value (data);
 
-		#ifdef LIME_FREETYPE
-		Font *font = (Font*)fontHandle->ptr;
-		font->SetSize (fontSize, dpi);
+		}
 		#endif
 
+		return alloc_null ();
+
 	}
 
 
-	void lime_gamepad_add_mappings (value mappings) {
+	HL_PRIM Bytes* HL_NAME(hl_font_render_glyphs_parallel) (HL_CFFIPointer* fontHandle, ArrayBufferView* indices, Bytes* data, int numThreads) {
 
-		int length = val_array_size (mappings);
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)fontHandle->ptr;
 
-		for (int i = 0; i < length; i++) {
+		if (indices && indices->buffer && font->RenderGlyphs ((const int*)indices->buffer->b, indices->byteLength / 4, data, numThreads)) {
 
-			Gamepad::AddMapping (val_string (val_array_i (mappings, i)));
+			return data;
 
 		}
+		#endif
+
+		return NULL;
 
 	}
 
 
-	HL_PRIM void HL_NAME(hl_gamepad_add_mappings) (hl_varray* mappings) {
+	void lime_font_set_cache_budget (int bytes) {
 
-		int length = mappings->size;
-		hl_vstring** mappingsData = hl_aptr (mappings, hl_vstring*);
+		#ifdef LIME_FREETYPE
+		Font::SetCacheBudget (bytes);
+		#endif
 
-		for (int i = 0; i < length; i++) {
+	}
 
-			Gamepad::AddMapping (hl_to_utf8 ((const uchar*)((*mappingsData++)->bytes)));
 
-		}
+	HL_PRIM void HL_NAME(hl_font_set_cache_budget) (int bytes) {
+
+		#ifdef LIME_FREETYPE
+		Font::SetCacheBudget (bytes);
+		#endif
 
 	}
 
 
-	void lime_gamepad_event_manager_register (value callback, value eventObject) {
+	void lime_font_set_render_mode (value fontHandle, int mode) {
 
-		GamepadEvent::callback = new ValuePointer (callback);
-		GamepadEvent::eventObject = new ValuePointer (eventObject);
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)val_data (fontHandle);
+		font->SetRenderMode ((GlyphRenderMode)mode);
+		#endif
 
 	}
 
 
-	HL_PRIM void HL_NAME(hl_gamepad_event_manager_register) (vclosure* callback, GamepadEvent* eventObject) {
+	HL_PRIM void HL_NAME(hl_font_set_render_mode) (HL_CFFIPointer* fontHandle, int mode) {
 
-		GamepadEvent::callback = new ValuePointer (callback);
-		GamepadEvent::eventObject = new ValuePointer ((vobj*)eventObject);
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)fontHandle->ptr;
+		font->SetRenderMode ((GlyphRenderMode)mode);
+		#endif
 
 	}
 
 
-	value lime_gamepad_get_device_guid (int id) {
-
-		const char* guid = Gamepad::GetDeviceGUID (id);
+	void lime_font_set_sdf_spread (value fontHandle, int spread) {
 
-		if (guid) {
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)val_data (fontHandle);
+		font->SetSDFSpread (spread);
+		#endif
 
-			value result = alloc_string (guid);
-			delete guid;
-			return result;
+	}
 
-		} else {
 
-			return alloc_null ();
+	HL_PRIM void HL_NAME(hl_font_set_sdf_spread) (HL_CFFIPointer* fontHandle, int spread) {
 
-		}
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)fontHandle->ptr;
+		font->SetSDFSpread (spread);
+		#endif
+
+	}
+
+
+	void lime_font_set_size (value fontHandle, int fontSize, int dpi) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)val_data (fontHandle);
+		font->SetSize (fontSize, dpi);
+		#endif
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_font_set_size) (HL_CFFIPointer* fontHandle, int fontSize, int dpi) {
+
+		#ifdef LIME_FREETYPE
+		Font *font = (Font*)fontHandle->ptr;
+		font->SetSize (fontSize, dpi);
+		#endif
+
+	}
+
+
+	void lime_gamepad_add_mappings (value mappings) {
+
+		int length = val_array_size (mappings);
+
+		for (int i = 0; i < length; i++) {
+
+			Gamepad::AddMapping (val_string (val_array_i (mappings, i)));
+
+		}
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_gamepad_add_mappings) (hl_varray* mappings) {
+
+		int length = mappings->size;
+		hl_vstring** mappingsData = hl_aptr (mappings, hl_vstring*);
+
+		for (int i = 0; i < length; i++) {
+
+			Gamepad::AddMapping (hl_to_utf8 ((const uchar*)((*mappingsData++)->bytes)));
+
+		}
+
+	}
+
+
+	void lime_gamepad_event_manager_register (value callback, value eventObject) {
+
+		GamepadEvent::callback = new ValuePointer (callback);
+		GamepadEvent::eventObject = new ValuePointer (eventObject);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_gamepad_event_manager_register) (vclosure* callback, GamepadEvent* eventObject) {
+
+		GamepadEvent::callback = new ValuePointer (callback);
+		GamepadEvent::eventObject = new ValuePointer ((vobj*)eventObject);
+
+	}
+
+
+	value lime_gamepad_get_device_guid (int id) {
+
+		const char* guid = Gamepad::GetDeviceGUID (id);
+
+		if (guid) {
+
+			value result = alloc_string (guid);
+			delete guid;
+			return result;
+
+		} else {
+
+			return alloc_null ();
+
+		}
 
 	}
 
@@ -1716,6 +2115,234 @@ namespace lime {
 	}
 
 
+	int lime_glyph_atlas_add_glyphs (value handle, value fontHandle, value indices, value rects) {
+
+		#ifdef LIME_FREETYPE
+		GlyphAtlas* atlas = (GlyphAtlas*)val_data (handle);
+		Font* font = (Font*)val_data (fontHandle);
+		ArrayBufferView _indices = ArrayBufferView (indices);
+		ArrayBufferView _rects = ArrayBufferView (rects);
+		return atlas->AddGlyphs (font, &_indices, &_rects);
+		#else
+		return 0;
+		#endif
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_glyph_atlas_add_glyphs) (HL_CFFIPointer* handle, HL_CFFIPointer* fontHandle, ArrayBufferView* indices, ArrayBufferView* rects) {
+
+		#ifdef LIME_FREETYPE
+		GlyphAtlas* atlas = (GlyphAtlas*)handle->ptr;
+		Font* font = (Font*)fontHandle->ptr;
+		return atlas->AddGlyphs (font, indices, rects);
+		#else
+		return 0;
+		#endif
+
+	}
+
+
+	void lime_glyph_atlas_clear (value handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)val_data (handle);
+		atlas->Clear ();
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_glyph_atlas_clear) (HL_CFFIPointer* handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)handle->ptr;
+		atlas->Clear ();
+
+	}
+
+
+	value lime_glyph_atlas_create (int pageWidth, int pageHeight, int maxPages, int bitsPerPixel, int padding) {
+
+		GlyphAtlas* atlas = new GlyphAtlas (pageWidth, pageHeight, maxPages, bitsPerPixel, padding);
+		return CFFIPointer (atlas, gc_glyph_atlas);
+
+	}
+
+
+	HL_PRIM HL_CFFIPointer* HL_NAME(hl_glyph_atlas_create) (int pageWidth, int pageHeight, int maxPages, int bitsPerPixel, int padding) {
+
+		GlyphAtlas* atlas = new GlyphAtlas (pageWidth, pageHeight, maxPages, bitsPerPixel, padding);
+		return HLCFFIPointer (atlas, (hl_finalizer)hl_gc_glyph_atlas);
+
+	}
+
+
+	value lime_glyph_atlas_flush (value handle) {
+
+		// the regions written since the last flush, one per page, to upload before drawing
+
+		GlyphAtlas* atlas = (GlyphAtlas*)val_data (handle);
+
+		std::vector<GlyphAtlasRect> dirty;
+		atlas->Flush (&dirty);
+
+		initialize ();
+
+		value result = alloc_array (dirty.size ());
+
+		for (size_t i = 0; i < dirty.size (); i++) {
+
+			value rect = alloc_empty_object ();
+			alloc_field (rect, id_page, alloc_int (dirty[i].page));
+			alloc_field (rect, id_x, alloc_int (dirty[i].x));
+			alloc_field (rect, id_y, alloc_int (dirty[i].y));
+			alloc_field (rect, id_width, alloc_int (dirty[i].width));
+			alloc_field (rect, id_height, alloc_int (dirty[i].height));
+			val_array_set_i (result, i, rect);
+
+		}
+
+		return result;
+
+	}
+
+
+	HL_PRIM hl_varray* HL_NAME(hl_glyph_atlas_flush) (HL_CFFIPointer* handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)handle->ptr;
+
+		std::vector<GlyphAtlasRect> dirty;
+		atlas->Flush (&dirty);
+
+		hl_varray* result = (hl_varray*)hl_alloc_array (&hlt_dynobj, dirty.size ());
+		vdynamic** resultData = hl_aptr (result, vdynamic*);
+
+		for (size_t i = 0; i < dirty.size (); i++) {
+
+			vdynamic* rect = (vdynamic*)hl_alloc_dynobj ();
+			hl_dyn_seti (rect, hl_hash_utf8 ("page"), &hlt_i32, dirty[i].page);
+			hl_dyn_seti (rect, hl_hash_utf8 ("x"), &hlt_i32, dirty[i].x);
+			hl_dyn_seti (rect, hl_hash_utf8 ("y"), &hlt_i32, dirty[i].y);
+			hl_dyn_seti (rect, hl_hash_utf8 ("width"), &hlt_i32, dirty[i].width);
+			hl_dyn_seti (rect, hl_hash_utf8 ("height"), &hlt_i32, dirty[i].height);
+			*resultData++ = rect;
+
+		}
+
+		return result;
+
+	}
+
+
+	int lime_glyph_atlas_get_evictions (value handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)val_data (handle);
+		return atlas->GetEvictions ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_glyph_atlas_get_evictions) (HL_CFFIPointer* handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)handle->ptr;
+		return atlas->GetEvictions ();
+
+	}
+
+
+	double lime_glyph_atlas_get_page (value handle, int page, value buffer) {
+
+		// returns the address of the page pixels, which live as long as the atlas, so only the
+		// rects from flush need to be read out. buffer receives the size and format only
+
+		GlyphAtlas* atlas = (GlyphAtlas*)val_data (handle);
+		ImageBuffer* source = atlas->GetPage (page);
+
+		if (!source) {
+
+			return 0;
+
+		}
+
+		if (!val_is_null (buffer)) {
+
+			initialize ();
+
+			alloc_field (buffer, id_width, alloc_int (source->width));
+			alloc_field (buffer, id_height, alloc_int (source->height));
+			alloc_field (buffer, id_bitsPerPixel, alloc_int (source->bitsPerPixel));
+			alloc_field (buffer, id_format, alloc_int (source->format));
+			alloc_field (buffer, id_premultiplied, alloc_bool (source->premultiplied));
+			alloc_field (buffer, id_transparent, alloc_bool (source->transparent));
+
+		}
+
+		return (uintptr_t)source->data->buffer->b;
+
+	}
+
+
+	HL_PRIM double HL_NAME(hl_glyph_atlas_get_page) (HL_CFFIPointer* handle, int page, ImageBuffer* buffer) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)handle->ptr;
+		ImageBuffer* source = atlas->GetPage (page);
+
+		if (!source) {
+
+			return 0;
+
+		}
+
+		if (buffer) {
+
+			buffer->width = source->width;
+			buffer->height = source->height;
+			buffer->bitsPerPixel = source->bitsPerPixel;
+			buffer->format = source->format;
+			buffer->premultiplied = source->premultiplied;
+			buffer->transparent = source->transparent;
+
+		}
+
+		return (uintptr_t)source->data->buffer->b;
+
+	}
+
+
+	int lime_glyph_atlas_get_page_count (value handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)val_data (handle);
+		return atlas->GetPageCount ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_glyph_atlas_get_page_count) (HL_CFFIPointer* handle) {
+
+		GlyphAtlas* atlas = (GlyphAtlas*)handle->ptr;
+		return atlas->GetPageCount ();
+
+	}
+
+
+	void lime_glyph_atlas_remove_font (value handle, value fontHandle) {
+
+		#ifdef LIME_FREETYPE
+		GlyphAtlas* atlas = (GlyphAtlas*)val_data (handle);
+		atlas->RemoveFont ((Font*)val_data (fontHandle));
+		#endif
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_glyph_atlas_remove_font) (HL_CFFIPointer* handle, HL_CFFIPointer* fontHandle) {
+
+		#ifdef LIME_FREETYPE
+		GlyphAtlas* atlas = (GlyphAtlas*)handle->ptr;
+		atlas->RemoveFont ((Font*)fontHandle->ptr);
+		#endif
+
+	}
+
+
 	value lime_gzip_compress (value buffer, value bytes) {
 
 		#ifdef LIME_ZLIB
@@ -1819,6 +2446,15 @@ namespace lime {
 				#endif
 				break;
 
+			case 2:
+
+				if (QOI::Encode (&imageBuffer, &data)) {
+
+					return data.Value (bytes);
+
+				}
+				break;
+
 			default: break;
 
 		}
@@ -1854,6 +2490,15 @@ namespace lime {
 				#endif
 				break;
 
+			case 2:
+
+				if (QOI::Encode (buffer, bytes)) {
+
+					return bytes;
+
+				}
+				break;
+
 			default: break;
 
 		}
@@ -1889,6 +2534,12 @@ namespace lime {
 		}
 		#endif
 
+		if (QOI::Decode (&resource, &imageBuffer)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+
 		return alloc_null ();
 
 	}
@@ -1914,18 +2565,29 @@ namespace lime {
 		}
 		#endif
 
+		if (QOI::Decode (&resource, buffer)) {
+
+			return buffer;
+
+		}
+
 		return 0;
 
 	}
 
 
-	value lime_image_load_file (value data, value buffer) {
+	value lime_image_load_bytes_format (value data, value buffer, int format, bool premultiplied) {
+
+		Resource resource;
+		Bytes bytes;
 
-		Resource resource = Resource (val_string (data));
 		ImageBuffer imageBuffer = ImageBuffer (buffer);
 
+		bytes.Set (data);
+		resource = Resource (&bytes);
+
 		#ifdef LIME_PNG
-		if (PNG::Decode (&resource, &imageBuffer)) {
+		if (PNG::Decode (&resource, &imageBuffer, true, (PixelFormat)format, premultiplied)) {
 
 			return imageBuffer.Value (buffer);
 
@@ -1933,24 +2595,30 @@ namespace lime {
 		#endif
 
 		#ifdef LIME_JPEG
-		if (JPEG::Decode (&resource, &imageBuffer)) {
+		if (JPEG::Decode (&resource, &imageBuffer, true, (PixelFormat)format, premultiplied)) {
 
 			return imageBuffer.Value (buffer);
 
 		}
 		#endif
 
+		if (QOI::Decode (&resource, &imageBuffer, true, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+
 		return alloc_null ();
 
 	}
 
 
-	HL_PRIM ImageBuffer* HL_NAME(hl_image_load_file) (hl_vstring* data, ImageBuffer* buffer) {
+	HL_PRIM ImageBuffer* HL_NAME(hl_image_load_bytes_format) (Bytes* data, ImageBuffer* buffer, PixelFormat format, bool premultiplied) {
 
 		Resource resource = Resource (data);
 
 		#ifdef LIME_PNG
-		if (PNG::Decode (&resource, buffer)) {
+		if (PNG::Decode (&resource, buffer, true, format, premultiplied)) {
 
 			return buffer;
 
@@ -1958,29 +2626,577 @@ namespace lime {
 		#endif
 
 		#ifdef LIME_JPEG
-		if (JPEG::Decode (&resource, buffer)) {
+		if (JPEG::Decode (&resource, buffer, true, format, premultiplied)) {
 
 			return buffer;
 
 		}
 		#endif
 
+		if (QOI::Decode (&resource, buffer, true, format, premultiplied)) {
+
+			return buffer;
+
+		}
+
+		return 0;
+
+	}
+
+
+	value lime_image_load_bytes_into (value data, value buffer, int offset, int stride, int format, bool premultiplied) {
+
+		Resource resource;
+		Bytes bytes;
+
+		ImageBuffer imageBuffer = ImageBuffer (buffer);
+
+		bytes.Set (data);
+		resource = Resource (&bytes);
+
+		#ifdef LIME_PNG
+		if (PNG::DecodeInto (&resource, &imageBuffer, offset, stride, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::DecodeInto (&resource, &imageBuffer, offset, stride, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		if (QOI::DecodeInto (&resource, &imageBuffer, offset, stride, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+
+		return alloc_null ();
+
+	}
+
+
+	HL_PRIM ImageBuffer* HL_NAME(hl_image_load_bytes_into) (Bytes* data, ImageBuffer* buffer, int offset, int stride, PixelFormat format, bool premultiplied) {
+
+		Resource resource = Resource (data);
+
+		#ifdef LIME_PNG
+		if (PNG::DecodeInto (&resource, buffer, offset, stride, format, premultiplied)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::DecodeInto (&resource, buffer, offset, stride, format, premultiplied)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		if (QOI::DecodeInto (&resource, buffer, offset, stride, format, premultiplied)) {
+
+			return buffer;
+
+		}
+
 		return 0;
 
 	}
 
 
-	value lime_image_load (value data, value buffer) {
+	value lime_image_load_file (value data, value buffer) {
+
+		Resource resource = Resource (val_string (data));
+		ImageBuffer imageBuffer = ImageBuffer (buffer);
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (&resource, &imageBuffer)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::Decode (&resource, &imageBuffer)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		if (QOI::Decode (&resource, &imageBuffer)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+
+		return alloc_null ();
+
+	}
+
+
+	HL_PRIM ImageBuffer* HL_NAME(hl_image_load_file) (hl_vstring* data, ImageBuffer* buffer) {
+
+		Resource resource = Resource (data);
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (&resource, buffer)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::Decode (&resource, buffer)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		if (QOI::Decode (&resource, buffer)) {
+
+			return buffer;
+
+		}
+
+		return 0;
+
+	}
+
+
+	value lime_image_load_file_format (value data, value buffer, int format, bool premultiplied) {
+
+		Resource resource = Resource (val_string (data));
+		ImageBuffer imageBuffer = ImageBuffer (buffer);
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (&resource, &imageBuffer, true, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::Decode (&resource, &imageBuffer, true, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		if (QOI::Decode (&resource, &imageBuffer, true, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+
+		return alloc_null ();
+
+	}
+
+
+	HL_PRIM ImageBuffer* HL_NAME(hl_image_load_file_format) (hl_vstring* data, ImageBuffer* buffer, PixelFormat format, bool premultiplied) {
+
+		Resource resource = Resource (data);
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (&resource, buffer, true, format, premultiplied)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::Decode (&resource, buffer, true, format, premultiplied)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		if (QOI::Decode (&resource, buffer, true, format, premultiplied)) {
+
+			return buffer;
+
+		}
+
+		return 0;
+
+	}
+
+
+	value lime_image_load_file_into (value data, value buffer, int offset, int stride, int format, bool premultiplied) {
+
+		Resource resource = Resource (val_string (data));
+		ImageBuffer imageBuffer = ImageBuffer (buffer);
+
+		#ifdef LIME_PNG
+		if (PNG::DecodeInto (&resource, &imageBuffer, offset, stride, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::DecodeInto (&resource, &imageBuffer, offset, stride, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		if (QOI::DecodeInto (&resource, &imageBuffer, offset, stride, (PixelFormat)format, premultiplied)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+
+		return alloc_null ();
+
+	}
+
+
+	HL_PRIM ImageBuffer* HL_NAME(hl_image_load_file_into) (hl_vstring* data, ImageBuffer* buffer, int offset, int stride, PixelFormat format, bool premultiplied) {
+
+		Resource resource = Resource (data);
+
+		#ifdef LIME_PNG
+		if (PNG::DecodeInto (&resource, buffer, offset, stride, format, premultiplied)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::DecodeInto (&resource, buffer, offset, stride, format, premultiplied)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		if (QOI::DecodeInto (&resource, buffer, offset, stride, format, premultiplied)) {
+
+			return buffer;
+
+		}
+
+		return 0;
+
+	}
+
+
+	value lime_image_load (value data, value buffer) {
+
+		if (val_is_string (data)) {
+
+			return lime_image_load_file (data, buffer);
+
+		} else {
+
+			return lime_image_load_bytes (data, buffer);
+
+		}
+
+	}
+
+
+	int lime_image_cache_add_bytes (value handle, value data, int format, bool premultiplied) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		Bytes bytes (data);
+		return cache->Add (&bytes, (PixelFormat)format, premultiplied);
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_cache_add_bytes) (HL_CFFIPointer* handle, Bytes* data, int format, bool premultiplied) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->Add (data, (PixelFormat)format, premultiplied);
+
+	}
+
+
+	int lime_image_cache_add_file (value handle, HxString path, int format, bool premultiplied) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		return cache->Add (hxs_utf8 (path, nullptr), (PixelFormat)format, premultiplied);
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_cache_add_file) (HL_CFFIPointer* handle, hl_vstring* path, int format, bool premultiplied) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->Add (path ? hl_to_utf8 ((const uchar*)path->bytes) : NULL, (PixelFormat)format, premultiplied);
+
+	}
+
+
+	int lime_image_cache_add_image (value handle, value buffer) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		ImageBuffer imageBuffer (buffer);
+		return cache->Add (&imageBuffer);
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_cache_add_image) (HL_CFFIPointer* handle, ImageBuffer* buffer) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->Add (buffer);
+
+	}
+
+
+	void lime_image_cache_clear (value handle) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		cache->Clear ();
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_cache_clear) (HL_CFFIPointer* handle) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		cache->Clear ();
+
+	}
+
+
+	value lime_image_cache_create (int memoryBudget) {
+
+		ImageCache* cache = new ImageCache (memoryBudget);
+		return CFFIPointer (cache, gc_image_cache);
+
+	}
+
+
+	HL_PRIM HL_CFFIPointer* HL_NAME(hl_image_cache_create) (int memoryBudget) {
+
+		ImageCache* cache = new ImageCache (memoryBudget);
+		return HLCFFIPointer (cache, (hl_finalizer)hl_gc_image_cache);
+
+	}
+
+
+	int lime_image_cache_get_evictions (value handle) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		return cache->GetEvictions ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_cache_get_evictions) (HL_CFFIPointer* handle) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->GetEvictions ();
+
+	}
+
+
+	int lime_image_cache_get_hits (value handle) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		return cache->GetHits ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_cache_get_hits) (HL_CFFIPointer* handle) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->GetHits ();
+
+	}
+
+
+	int lime_image_cache_get_memory_usage (value handle) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		return cache->GetMemoryUsage ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_cache_get_memory_usage) (HL_CFFIPointer* handle) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->GetMemoryUsage ();
+
+	}
+
+
+	int lime_image_cache_get_misses (value handle) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		return cache->GetMisses ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_cache_get_misses) (HL_CFFIPointer* handle) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->GetMisses ();
+
+	}
+
+
+	bool lime_image_cache_is_resident (value handle, int id) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		return cache->IsResident (id);
+
+	}
+
+
+	HL_PRIM bool HL_NAME(hl_image_cache_is_resident) (HL_CFFIPointer* handle, int id) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->IsResident (id);
+
+	}
+
+
+	double lime_image_cache_pin (value handle, int id, value buffer) {
+
+		// returns the address of the resident pixels, decoding them first if needed, valid until the entry is unpinned
+		// buffer receives the size and format only, the pixels are never copied out of the cache
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		ImageBuffer* source = cache->Pin (id);
+
+		if (!source) {
+
+			return 0;
+
+		}
+
+		if (!val_is_null (buffer)) {
+
+			initialize ();
+
+			alloc_field (buffer, id_width, alloc_int (source->width));
+			alloc_field (buffer, id_height, alloc_int (source->height));
+			alloc_field (buffer, id_bitsPerPixel, alloc_int (source->bitsPerPixel));
+			alloc_field (buffer, id_format, alloc_int (source->format));
+			alloc_field (buffer, id_premultiplied, alloc_bool (source->premultiplied));
+			alloc_field (buffer, id_transparent, alloc_bool (source->transparent));
+
+		}
+
+		return (uintptr_t)source->data->buffer->b;
+
+	}
+
+
+	HL_PRIM double HL_NAME(hl_image_cache_pin) (HL_CFFIPointer* handle, int id, ImageBuffer* buffer) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		ImageBuffer* source = cache->Pin (id);
+
+		if (!source) {
+
+			return 0;
+
+		}
+
+		if (buffer) {
+
+			buffer->width = source->width;
+			buffer->height = source->height;
+			buffer->bitsPerPixel = source->bitsPerPixel;
+			buffer->format = source->format;
+			buffer->premultiplied = source->premultiplied;
+			buffer->transparent = source->transparent;
+
+		}
+
+		return (uintptr_t)source->data->buffer->b;
+
+	}
+
+
+	bool lime_image_cache_remove (value handle, int id) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		return cache->Remove (id);
+
+	}
+
+
+	HL_PRIM bool HL_NAME(hl_image_cache_remove) (HL_CFFIPointer* handle, int id) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		return cache->Remove (id);
+
+	}
+
+
+	void lime_image_cache_set_memory_budget (value handle, int memoryBudget) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		cache->SetMemoryBudget (memoryBudget);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_cache_set_memory_budget) (HL_CFFIPointer* handle, int memoryBudget) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		cache->SetMemoryBudget (memoryBudget);
+
+	}
+
+
+	void lime_image_cache_unpin (value handle, int id) {
+
+		ImageCache* cache = (ImageCache*)val_data (handle);
+		cache->Unpin (id);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_cache_unpin) (HL_CFFIPointer* handle, int id) {
+
+		ImageCache* cache = (ImageCache*)handle->ptr;
+		cache->Unpin (id);
+
+	}
+
+
+	void lime_image_data_util_alpha_bleed (value image, value rect, int radius) {
 
-		if (val_is_string (data)) {
+		Image _image = Image (image);
+		Rectangle _rect = Rectangle (rect);
+		ImageDataUtil::AlphaBleed (&_image, &_rect, radius);
 
-			return lime_image_load_file (data, buffer);
+	}
 
-		} else {
 
-			return lime_image_load_bytes (data, buffer);
+	HL_PRIM void HL_NAME(hl_image_data_util_alpha_bleed) (Image* image, Rectangle* rect, int radius) {
 
-		}
+		ImageDataUtil::AlphaBleed (image, rect, radius);
 
 	}
 
@@ -2069,6 +3285,133 @@ namespace lime {
 	}
 
 
+	void lime_image_data_util_copy_pixels_linear (value image, value sourceImage, value sourceRect, value destPoint, value alphaImage, value alphaPoint, bool mergeAlpha) {
+
+		// blends in linear light instead of sRGB
+
+		Image _image = Image (image);
+		Image _sourceImage = Image (sourceImage);
+		Rectangle _sourceRect = Rectangle (sourceRect);
+		Vector2 _destPoint = Vector2 (destPoint);
+
+		if (val_is_null (alphaImage)) {
+
+			ImageDataUtil::CopyPixels (&_image, &_sourceImage, &_sourceRect, &_destPoint, 0, 0, mergeAlpha, true);
+
+		} else {
+
+			Image _alphaImage = Image (alphaImage);
+			Vector2 _alphaPoint = Vector2 (alphaPoint);
+
+			ImageDataUtil::CopyPixels (&_image, &_sourceImage, &_sourceRect, &_destPoint, &_alphaImage, &_alphaPoint, mergeAlpha, true);
+
+		}
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_data_util_copy_pixels_linear) (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, Image* alphaImage, Vector2* alphaPoint, bool mergeAlpha) {
+
+		if (!alphaImage) {
+
+			ImageDataUtil::CopyPixels (image, sourceImage, sourceRect, destPoint, NULL, NULL, mergeAlpha, true);
+
+		} else {
+
+			if (!alphaPoint) {
+
+				Vector2 _alphaPoint = Vector2 (0, 0);
+
+				ImageDataUtil::CopyPixels (image, sourceImage, sourceRect, destPoint, alphaImage, &_alphaPoint, mergeAlpha, true);
+
+			} else {
+
+				ImageDataUtil::CopyPixels (image, sourceImage, sourceRect, destPoint, alphaImage, alphaPoint, mergeAlpha, true);
+
+			}
+
+		}
+
+	}
+
+
+	value lime_image_data_util_diff (value image, value otherImage, value rect, int tolerance) {
+
+		Image _image = Image (image);
+		Image _otherImage = Image (otherImage);
+		Rectangle _rect = Rectangle (rect);
+
+		ImageDiff diff;
+		ImageDataUtil::Diff (&_image, &_otherImage, &_rect, tolerance, &diff);
+
+		initialize ();
+
+		value result = alloc_empty_object ();
+		alloc_field (result, id_mismatches, alloc_int (diff.mismatches));
+		alloc_field (result, id_maxDelta, alloc_int (diff.maxDelta));
+		alloc_field (result, id_psnr, alloc_float (diff.psnr));
+		alloc_field (result, id_x, alloc_int (diff.x));
+		alloc_field (result, id_y, alloc_int (diff.y));
+		alloc_field (result, id_width, alloc_int (diff.width));
+		alloc_field (result, id_height, alloc_int (diff.height));
+		return result;
+
+	}
+
+
+	HL_PRIM vdynamic* HL_NAME(hl_image_data_util_diff) (Image* image, Image* otherImage, Rectangle* rect, int tolerance) {
+
+		ImageDiff diff;
+		ImageDataUtil::Diff (image, otherImage, rect, tolerance, &diff);
+
+		vdynamic* result = (vdynamic*)hl_alloc_dynobj ();
+		hl_dyn_seti (result, hl_hash_utf8 ("mismatches"), &hlt_i32, diff.mismatches);
+		hl_dyn_seti (result, hl_hash_utf8 ("maxDelta"), &hlt_i32, diff.maxDelta);
+		hl_dyn_setd (result, hl_hash_utf8 ("psnr"), diff.psnr);
+		hl_dyn_seti (result, hl_hash_utf8 ("x"), &hlt_i32, diff.x);
+		hl_dyn_seti (result, hl_hash_utf8 ("y"), &hlt_i32, diff.y);
+		hl_dyn_seti (result, hl_hash_utf8 ("width"), &hlt_i32, diff.width);
+		hl_dyn_seti (result, hl_hash_utf8 ("height"), &hlt_i32, diff.height);
+		return result;
+
+	}
+
+
+	void lime_image_data_util_draw_triangles (value image, value texture, value vertices, value indices, value uvs, int culling, bool smooth, bool repeat) {
+
+		Image _image = Image (image);
+		Image _texture = Image (texture);
+		ArrayBufferView _vertices = ArrayBufferView (vertices);
+		ArrayBufferView _indices = ArrayBufferView (indices);
+		ArrayBufferView _uvs = ArrayBufferView (uvs);
+		ImageDataUtil::DrawTriangles (&_image, &_texture, &_vertices, &_indices, &_uvs, culling, smooth, repeat);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_data_util_draw_triangles) (Image* image, Image* texture, ArrayBufferView* vertices, ArrayBufferView* indices, ArrayBufferView* uvs, int culling, bool smooth, bool repeat) {
+
+		ImageDataUtil::DrawTriangles (image, texture, vertices, indices, uvs, culling, smooth, repeat);
+
+	}
+
+
+	void lime_image_data_util_extrude (value image, value rect, int padding) {
+
+		Image _image = Image (image);
+		Rectangle _rect = Rectangle (rect);
+		ImageDataUtil::Extrude (&_image, &_rect, padding);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_data_util_extrude) (Image* image, Rectangle* rect, int padding) {
+
+		ImageDataUtil::Extrude (image, rect, padding);
+
+	}
+
+
 	void lime_image_data_util_fill_rect (value image, value rect, int rg, int ba) {
 
 		Image _image = Image (image);
@@ -2122,6 +3465,29 @@ namespace lime {
 	}
 
 
+	value lime_image_data_util_hash (value image, value rect) {
+
+		// 64-bit hashes do not fit a Haxe Int, so they are returned as 16 hex digits
+
+		Image _image = Image (image);
+		Rectangle _rect = Rectangle (rect);
+
+		char hash[17];
+		snprintf (hash, sizeof (hash), "%016llx", (unsigned long long)ImageDataUtil::Hash (&_image, &_rect));
+		return alloc_string (hash);
+
+	}
+
+
+	HL_PRIM vbyte* HL_NAME(hl_image_data_util_hash) (Image* image, Rectangle* rect) {
+
+		char hash[17];
+		snprintf (hash, sizeof (hash), "%016llx", (unsigned long long)ImageDataUtil::Hash (image, rect));
+		return hl_copy_bytes ((vbyte*)hash, sizeof (hash));
+
+	}
+
+
 	void lime_image_data_util_merge (value image, value sourceImage, value sourceRect, value destPoint, int redMultiplier, int greenMultiplier, int blueMultiplier, int alphaMultiplier) {
 
 		Image _image = Image (image);
@@ -2148,99 +3514,280 @@ namespace lime {
 	}
 
 
-	HL_PRIM void HL_NAME(hl_image_data_util_multiply_alpha) (Image* image) {
+	HL_PRIM void HL_NAME(hl_image_data_util_multiply_alpha) (Image* image) {
+
+		ImageDataUtil::MultiplyAlpha (image);
+
+	}
+
+
+	void lime_image_data_util_resize (value image, value buffer, int width, int height) {
+
+		Image _image = Image (image);
+		ImageBuffer _buffer = ImageBuffer (buffer);
+		ImageDataUtil::Resize (&_image, &_buffer, width, height);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_data_util_resize) (Image* image, ImageBuffer* buffer, int width, int height) {
+
+		ImageDataUtil::Resize (image, buffer, width, height);
+
+	}
+
+
+	void lime_image_data_util_resize_linear (value image, value buffer, int width, int height) {
+
+		Image _image = Image (image);
+		ImageBuffer _buffer = ImageBuffer (buffer);
+		ImageDataUtil::Resize (&_image, &_buffer, width, height, true);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_data_util_resize_linear) (Image* image, ImageBuffer* buffer, int width, int height) {
+
+		ImageDataUtil::Resize (image, buffer, width, height, true);
+
+	}
+
+
+	void lime_image_data_util_set_format (value image, int format) {
+
+		Image _image = Image (image);
+		PixelFormat _format = (PixelFormat)format;
+		ImageDataUtil::SetFormat (&_image, _format);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_data_util_set_format) (Image* image, PixelFormat format) {
+
+		ImageDataUtil::SetFormat (image, format);
+
+	}
+
+
+	void lime_image_data_util_set_pixels (value image, value rect, value bytes, int offset, int format, int endian) {
+
+		Image _image = Image (image);
+		Rectangle _rect = Rectangle (rect);
+		Bytes _bytes (bytes);
+		PixelFormat _format = (PixelFormat)format;
+		Endian _endian = (Endian)endian;
+		ImageDataUtil::SetPixels (&_image, &_rect, &_bytes, offset, _format, _endian);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_data_util_set_pixels) (Image* image, Rectangle* rect, Bytes* bytes, int offset, PixelFormat format, Endian endian) {
+
+		ImageDataUtil::SetPixels (image, rect, bytes, offset, format, endian);
+
+	}
+
+
+	int lime_image_data_util_threshold (value image, value sourceImage, value sourceRect, value destPoint, int operation, int thresholdRG, int thresholdBA, int colorRG, int colorBA, int maskRG, int maskBA, bool copySource) {
+
+		Image _image = Image (image);
+		Image _sourceImage = Image (sourceImage);
+		Rectangle _sourceRect = Rectangle (sourceRect);
+		Vector2 _destPoint = Vector2 (destPoint);
+		int32_t threshold = (thresholdRG << 16) | thresholdBA;
+		int32_t color = (colorRG << 16) | colorBA;
+		int32_t mask = (maskRG << 16) | maskBA;
+		return ImageDataUtil::Threshold (&_image, &_sourceImage, &_sourceRect, &_destPoint, operation, threshold, color, mask, copySource);
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_data_util_threshold) (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, int operation, int thresholdRG, int thresholdBA, int colorRG, int colorBA, int maskRG, int maskBA, bool copySource) {
+
+		int32_t threshold = (thresholdRG << 16) | thresholdBA;
+		int32_t color = (colorRG << 16) | colorBA;
+		int32_t mask = (maskRG << 16) | maskBA;
+		return ImageDataUtil::Threshold (image, sourceImage, sourceRect, destPoint, operation, threshold, color, mask, copySource);
+
+	}
+
+
+	void lime_image_data_util_unmultiply_alpha (value image) {
+
+		Image _image = Image (image);
+		ImageDataUtil::UnmultiplyAlpha (&_image);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_image_data_util_unmultiply_alpha) (Image* image) {
+
+		ImageDataUtil::UnmultiplyAlpha (image);
+
+	}
+
+
+	bool lime_image_decode_queue_cancel (value handle, int id) {
+
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)val_data (handle);
+		return queue->Cancel (id);
+
+	}
+
+
+	HL_PRIM bool HL_NAME(hl_image_decode_queue_cancel) (HL_CFFIPointer* handle, int id) {
+
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)handle->ptr;
+		return queue->Cancel (id);
+
+	}
+
+
+	value lime_image_decode_queue_create (int numThreads, int memoryBudget) {
+
+		ImageDecodeQueue* queue = new ImageDecodeQueue (numThreads, memoryBudget);
+		return CFFIPointer (queue, gc_image_decode_queue);
+
+	}
+
+
+	HL_PRIM HL_CFFIPointer* HL_NAME(hl_image_decode_queue_create) (int numThreads, int memoryBudget) {
+
+		ImageDecodeQueue* queue = new ImageDecodeQueue (numThreads, memoryBudget);
+		return HLCFFIPointer (queue, (hl_finalizer)hl_gc_image_decode_queue);
+
+	}
+
+
+	int lime_image_decode_queue_get_memory_usage (value handle) {
+
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)val_data (handle);
+		return queue->GetMemoryUsage ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_decode_queue_get_memory_usage) (HL_CFFIPointer* handle) {
+
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)handle->ptr;
+		return queue->GetMemoryUsage ();
+
+	}
+
+
+	int lime_image_decode_queue_get_pending (value handle) {
+
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)val_data (handle);
+		return queue->GetPending ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_image_decode_queue_get_pending) (HL_CFFIPointer* handle) {
+
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)handle->ptr;
+		return queue->GetPending ();
+
+	}
+
 
-		ImageDataUtil::MultiplyAlpha (image);
+	int lime_image_decode_queue_poll (value handle, value buffer) {
 
-	}
+		// returns the id of a finished job (negated if it failed to decode), or 0 if none are ready
 
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)val_data (handle);
+		ImageDecodeJob* job = queue->Poll ();
 
-	void lime_image_data_util_resize (value image, value buffer, int width, int height) {
+		if (!job) {
 
-		Image _image = Image (image);
-		ImageBuffer _buffer = ImageBuffer (buffer);
-		ImageDataUtil::Resize (&_image, &_buffer, width, height);
+			return 0;
 
-	}
+		}
 
+		int id = job->success ? job->id : -job->id;
 
-	HL_PRIM void HL_NAME(hl_image_data_util_resize) (Image* image, ImageBuffer* buffer, int width, int height) {
+		if (job->success) {
 
-		ImageDataUtil::Resize (image, buffer, width, height);
+			ImageBuffer imageBuffer (buffer);
+			ArrayBufferView* data = imageBuffer.data;
 
-	}
+			imageBuffer.data = job->buffer->data;
+			imageBuffer.width = job->buffer->width;
+			imageBuffer.height = job->buffer->height;
+			imageBuffer.bitsPerPixel = job->buffer->bitsPerPixel;
+			imageBuffer.format = job->buffer->format;
+			imageBuffer.premultiplied = job->buffer->premultiplied;
+			job->buffer->data = data;
 
+			imageBuffer.Value (buffer);
 
-	void lime_image_data_util_set_format (value image, int format) {
+		}
 
-		Image _image = Image (image);
-		PixelFormat _format = (PixelFormat)format;
-		ImageDataUtil::SetFormat (&_image, _format);
+		delete job;
+		return id;
 
 	}
 
 
-	HL_PRIM void HL_NAME(hl_image_data_util_set_format) (Image* image, PixelFormat format) {
+	HL_PRIM int HL_NAME(hl_image_decode_queue_poll) (HL_CFFIPointer* handle, ImageBuffer* buffer) {
 
-		ImageDataUtil::SetFormat (image, format);
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)handle->ptr;
+		ImageDecodeJob* job = queue->Poll ();
 
-	}
+		if (!job) {
 
+			return 0;
 
-	void lime_image_data_util_set_pixels (value image, value rect, value bytes, int offset, int format, int endian) {
+		}
 
-		Image _image = Image (image);
-		Rectangle _rect = Rectangle (rect);
-		Bytes _bytes (bytes);
-		PixelFormat _format = (PixelFormat)format;
-		Endian _endian = (Endian)endian;
-		ImageDataUtil::SetPixels (&_image, &_rect, &_bytes, offset, _format, _endian);
+		int id = job->success ? job->id : -job->id;
 
-	}
+		if (job->success) {
 
+			ImageBuffer* source = job->buffer;
 
-	HL_PRIM void HL_NAME(hl_image_data_util_set_pixels) (Image* image, Rectangle* rect, Bytes* bytes, int offset, PixelFormat format, Endian endian) {
+			buffer->Resize (source->width, source->height, source->bitsPerPixel);
+			memcpy (buffer->data->buffer->b, source->data->buffer->b, source->data->byteLength);
+			buffer->format = source->format;
+			buffer->premultiplied = source->premultiplied;
 
-		ImageDataUtil::SetPixels (image, rect, bytes, offset, format, endian);
+		}
+
+		delete job;
+		return id;
 
 	}
 
 
-	int lime_image_data_util_threshold (value image, value sourceImage, value sourceRect, value destPoint, int operation, int thresholdRG, int thresholdBA, int colorRG, int colorBA, int maskRG, int maskBA, bool copySource) {
+	int lime_image_decode_queue_submit_bytes (value handle, value data, int format, bool premultiplied, int priority) {
 
-		Image _image = Image (image);
-		Image _sourceImage = Image (sourceImage);
-		Rectangle _sourceRect = Rectangle (sourceRect);
-		Vector2 _destPoint = Vector2 (destPoint);
-		int32_t threshold = (thresholdRG << 16) | thresholdBA;
-		int32_t color = (colorRG << 16) | colorBA;
-		int32_t mask = (maskRG << 16) | maskBA;
-		return ImageDataUtil::Threshold (&_image, &_sourceImage, &_sourceRect, &_destPoint, operation, threshold, color, mask, copySource);
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)val_data (handle);
+		Bytes bytes (data);
+		return queue->Submit (&bytes, (PixelFormat)format, premultiplied, priority);
 
 	}
 
 
-	HL_PRIM int HL_NAME(hl_image_data_util_threshold) (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, int operation, int thresholdRG, int thresholdBA, int colorRG, int colorBA, int maskRG, int maskBA, bool copySource) {
+	HL_PRIM int HL_NAME(hl_image_decode_queue_submit_bytes) (HL_CFFIPointer* handle, Bytes* data, int format, bool premultiplied, int priority) {
 
-		int32_t threshold = (thresholdRG << 16) | thresholdBA;
-		int32_t color = (colorRG << 16) | colorBA;
-		int32_t mask = (maskRG << 16) | maskBA;
-		return ImageDataUtil::Threshold (image, sourceImage, sourceRect, destPoint, operation, threshold, color, mask, copySource);
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)handle->ptr;
+		return queue->Submit (data, (PixelFormat)format, premultiplied, priority);
 
 	}
 
 
-	void lime_image_data_util_unmultiply_alpha (value image) {
+	int lime_image_decode_queue_submit_file (value handle, HxString path, int format, bool premultiplied, int priority) {
 
-		Image _image = Image (image);
-		ImageDataUtil::UnmultiplyAlpha (&_image);
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)val_data (handle);
+		return queue->Submit (hxs_utf8 (path, nullptr), (PixelFormat)format, premultiplied, priority);
 
 	}
 
 
-	HL_PRIM void HL_NAME(hl_image_data_util_unmultiply_alpha) (Image* image) {
+	HL_PRIM int HL_NAME(hl_image_decode_queue_submit_file) (HL_CFFIPointer* handle, hl_vstring* path, int format, bool premultiplied, int priority) {
 
-		ImageDataUtil::UnmultiplyAlpha (image);
+		ImageDecodeQueue* queue = (ImageDecodeQueue*)handle->ptr;
+		return queue->Submit (path ? hl_to_utf8 ((const uchar*)path->bytes) : NULL, (PixelFormat)format, premultiplied, priority);
 
 	}
 
@@ -2630,6 +4177,42 @@ namespace lime {
 	}
 
 
+	value lime_png_decode_bytes_scaled (value data, value buffer, int maxWidth, int maxHeight, int format, bool premultiplied) {
+
+		ImageBuffer imageBuffer (buffer);
+		Bytes bytes (data);
+		Resource resource = Resource (&bytes);
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (&resource, &imageBuffer, true, (PixelFormat)format, premultiplied, maxWidth, maxHeight)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		return alloc_null ();
+
+	}
+
+
+	HL_PRIM ImageBuffer* HL_NAME(hl_png_decode_bytes_scaled) (Bytes* data, ImageBuffer* buffer, int maxWidth, int maxHeight, PixelFormat format, bool premultiplied) {
+
+		Resource resource = Resource (data);
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (&resource, buffer, true, format, premultiplied, maxWidth, maxHeight)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		return 0;
+
+	}
+
+
 	value lime_png_decode_file (HxString path, bool decodeData, value buffer) {
 
 		ImageBuffer imageBuffer (buffer);
@@ -2665,6 +4248,226 @@ namespace lime {
 	}
 
 
+	value lime_png_decode_file_scaled (HxString path, value buffer, int maxWidth, int maxHeight, int format, bool premultiplied) {
+
+		ImageBuffer imageBuffer (buffer);
+		Resource resource = Resource (hxs_utf8 (path, nullptr));
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (&resource, &imageBuffer, true, (PixelFormat)format, premultiplied, maxWidth, maxHeight)) {
+
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		return alloc_null ();
+
+	}
+
+
+	HL_PRIM ImageBuffer* HL_NAME(hl_png_decode_file_scaled) (hl_vstring* path, ImageBuffer* buffer, int maxWidth, int maxHeight, PixelFormat format, bool premultiplied) {
+
+		Resource resource = Resource (path);
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (&resource, buffer, true, format, premultiplied, maxWidth, maxHeight)) {
+
+			return buffer;
+
+		}
+		#endif
+
+		return 0;
+
+	}
+
+
+	value lime_png_encode (value buffer, value bytes, int compression, int filter, bool detectAlpha, int numThreads) {
+
+		#ifdef LIME_PNG
+		ImageBuffer imageBuffer = ImageBuffer (buffer);
+		Bytes data = Bytes (bytes);
+
+		if (PNG::Encode (&imageBuffer, &data, compression, (PNGFilterStrategy)filter, detectAlpha, numThreads)) {
+
+			return data.Value (bytes);
+
+		}
+		#endif
+
+		return alloc_null ();
+
+	}
+
+
+	HL_PRIM Bytes* HL_NAME(hl_png_encode) (ImageBuffer* buffer, Bytes* bytes, int compression, int filter, bool detectAlpha, int numThreads) {
+
+		#ifdef LIME_PNG
+		if (PNG::Encode (buffer, bytes, compression, (PNGFilterStrategy)filter, detectAlpha, numThreads)) {
+
+			return bytes;
+
+		}
+		#endif
+
+		return 0;
+
+	}
+
+
+	bool lime_png_stream_decoder_append (value handle, value data, int offset, int length) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)val_data (handle);
+		Bytes bytes (data);
+
+		if (offset < 0 || length < 0 || offset + length > bytes.length) {
+
+			return false;
+
+		}
+
+		return decoder->Append (bytes.b + offset, length);
+		#else
+		return false;
+		#endif
+
+	}
+
+
+	HL_PRIM bool HL_NAME(hl_png_stream_decoder_append) (HL_CFFIPointer* handle, Bytes* data, int offset, int length) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)handle->ptr;
+
+		if (!data || offset < 0 || length < 0 || offset + length > data->length) {
+
+			return false;
+
+		}
+
+		return decoder->Append (data->b + offset, length);
+		#else
+		return false;
+		#endif
+
+	}
+
+
+	value lime_png_stream_decoder_create () {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = new PNGStreamDecoder ();
+		return CFFIPointer (decoder, gc_png_stream_decoder);
+		#else
+		return alloc_null ();
+		#endif
+
+	}
+
+
+	HL_PRIM HL_CFFIPointer* HL_NAME(hl_png_stream_decoder_create) () {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = new PNGStreamDecoder ();
+		return HLCFFIPointer (decoder, (hl_finalizer)hl_gc_png_stream_decoder);
+		#else
+		return 0;
+		#endif
+
+	}
+
+
+	float lime_png_stream_decoder_get_progress (value handle) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)val_data (handle);
+		return decoder->GetProgress ();
+		#else
+		return 0;
+		#endif
+
+	}
+
+
+	HL_PRIM float HL_NAME(hl_png_stream_decoder_get_progress) (HL_CFFIPointer* handle) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)handle->ptr;
+		return decoder->GetProgress ();
+		#else
+		return 0;
+		#endif
+
+	}
+
+
+	int lime_png_stream_decoder_get_rows (value handle) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)val_data (handle);
+		return decoder->GetRows ();
+		#else
+		return 0;
+		#endif
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_png_stream_decoder_get_rows) (HL_CFFIPointer* handle) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)handle->ptr;
+		return decoder->GetRows ();
+		#else
+		return 0;
+		#endif
+
+	}
+
+
+	value lime_png_stream_decoder_read (value handle, value buffer) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)val_data (handle);
+		ImageBuffer* source = decoder->buffer;
+
+		if (source->width > 0 && source->height > 0) {
+
+			ImageBuffer imageBuffer (buffer);
+			imageBuffer.Resize (source->width, source->height, 32);
+			memcpy (imageBuffer.data->buffer->b, source->data->buffer->b, source->data->byteLength);
+			return imageBuffer.Value (buffer);
+
+		}
+		#endif
+
+		return alloc_null ();
+
+	}
+
+
+	HL_PRIM ImageBuffer* HL_NAME(hl_png_stream_decoder_read) (HL_CFFIPointer* handle, ImageBuffer* buffer) {
+
+		#ifdef LIME_PNG
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)handle->ptr;
+		ImageBuffer* source = decoder->buffer;
+
+		if (source->width > 0 && source->height > 0) {
+
+			buffer->Resize (source->width, source->height, 32);
+			memcpy (buffer->data->buffer->b, source->data->buffer->b, source->data->byteLength);
+			return buffer;
+
+		}
+		#endif
+
+		return 0;
+
+	}
+
+
 	void lime_render_event_manager_register (value callback, value eventObject) {
 
 		RenderEvent::callback = new ValuePointer (callback);
@@ -3937,6 +5740,11 @@ namespace lime {
 	DEFINE_PRIME2 (lime_audio_load);
 	DEFINE_PRIME2 (lime_audio_load_bytes);
 	DEFINE_PRIME2 (lime_audio_load_file);
+	DEFINE_PRIME0v (lime_buffer_pool_clear);
+	DEFINE_PRIME0 (lime_buffer_pool_get_bytes_retained);
+	DEFINE_PRIME0 (lime_buffer_pool_get_hits);
+	DEFINE_PRIME0 (lime_buffer_pool_get_misses);
+	DEFINE_PRIME1v (lime_buffer_pool_set_retention);
 	DEFINE_PRIME3 (lime_bytes_from_data_pointer);
 	DEFINE_PRIME1 (lime_bytes_get_data_pointer);
 	DEFINE_PRIME2 (lime_bytes_get_data_pointer_offset);
@@ -3963,7 +5771,9 @@ namespace lime {
 	DEFINE_PRIME1 (lime_font_get_family_name);
 	DEFINE_PRIME2 (lime_font_get_glyph_index);
 	DEFINE_PRIME2 (lime_font_get_glyph_indices);
+	DEFINE_PRIME3 (lime_font_get_glyph_indices_packed);
 	DEFINE_PRIME2 (lime_font_get_glyph_metrics);
+	DEFINE_PRIME3 (lime_font_get_glyph_metrics_batch);
 	DEFINE_PRIME1 (lime_font_get_height);
 	DEFINE_PRIME1 (lime_font_get_num_glyphs);
 	DEFINE_PRIME1 (lime_font_get_underline_position);
@@ -3973,33 +5783,79 @@ namespace lime {
 	DEFINE_PRIME1 (lime_font_load_bytes);
 	DEFINE_PRIME1 (lime_font_load_file);
 	DEFINE_PRIME2 (lime_font_outline_decompose);
+	DEFINE_PRIME4 (lime_font_outline_decompose_packed);
+	DEFINE_PRIME5 (lime_font_outline_triangulate);
 	DEFINE_PRIME3 (lime_font_render_glyph);
 	DEFINE_PRIME3 (lime_font_render_glyphs);
+	DEFINE_PRIME4 (lime_font_render_glyphs_parallel);
+	DEFINE_PRIME1v (lime_font_set_cache_budget);
+	DEFINE_PRIME2v (lime_font_set_render_mode);
+	DEFINE_PRIME2v (lime_font_set_sdf_spread);
 	DEFINE_PRIME3v (lime_font_set_size);
 	DEFINE_PRIME1v (lime_gamepad_add_mappings);
 	DEFINE_PRIME2v (lime_gamepad_event_manager_register);
 	DEFINE_PRIME1 (lime_gamepad_get_device_guid);
 	DEFINE_PRIME1 (lime_gamepad_get_device_name);
+	DEFINE_PRIME4 (lime_glyph_atlas_add_glyphs);
+	DEFINE_PRIME1v (lime_glyph_atlas_clear);
+	DEFINE_PRIME5 (lime_glyph_atlas_create);
+	DEFINE_PRIME1 (lime_glyph_atlas_flush);
+	DEFINE_PRIME1 (lime_glyph_atlas_get_evictions);
+	DEFINE_PRIME3 (lime_glyph_atlas_get_page);
+	DEFINE_PRIME1 (lime_glyph_atlas_get_page_count);
+	DEFINE_PRIME2v (lime_glyph_atlas_remove_font);
 	DEFINE_PRIME2 (lime_gzip_compress);
 	DEFINE_PRIME2 (lime_gzip_decompress);
 	DEFINE_PRIME2v (lime_haptic_vibrate);
+	DEFINE_PRIME4 (lime_image_cache_add_bytes);
+	DEFINE_PRIME4 (lime_image_cache_add_file);
+	DEFINE_PRIME2 (lime_image_cache_add_image);
+	DEFINE_PRIME1v (lime_image_cache_clear);
+	DEFINE_PRIME1 (lime_image_cache_create);
+	DEFINE_PRIME1 (lime_image_cache_get_evictions);
+	DEFINE_PRIME1 (lime_image_cache_get_hits);
+	DEFINE_PRIME1 (lime_image_cache_get_memory_usage);
+	DEFINE_PRIME1 (lime_image_cache_get_misses);
+	DEFINE_PRIME2 (lime_image_cache_is_resident);
+	DEFINE_PRIME3 (lime_image_cache_pin);
+	DEFINE_PRIME2 (lime_image_cache_remove);
+	DEFINE_PRIME2v (lime_image_cache_set_memory_budget);
+	DEFINE_PRIME2v (lime_image_cache_unpin);
+	DEFINE_PRIME3v (lime_image_data_util_alpha_bleed);
 	DEFINE_PRIME3v (lime_image_data_util_color_transform);
 	DEFINE_PRIME6v (lime_image_data_util_copy_channel);
 	DEFINE_PRIME7v (lime_image_data_util_copy_pixels);
+	DEFINE_PRIME7v (lime_image_data_util_copy_pixels_linear);
+	DEFINE_PRIME4 (lime_image_data_util_diff);
+	DEFINE_PRIME8v (lime_image_data_util_draw_triangles);
+	DEFINE_PRIME3v (lime_image_data_util_extrude);
 	DEFINE_PRIME4v (lime_image_data_util_fill_rect);
 	DEFINE_PRIME5v (lime_image_data_util_flood_fill);
 	DEFINE_PRIME4v (lime_image_data_util_get_pixels);
+	DEFINE_PRIME2 (lime_image_data_util_hash);
 	DEFINE_PRIME8v (lime_image_data_util_merge);
 	DEFINE_PRIME1v (lime_image_data_util_multiply_alpha);
 	DEFINE_PRIME4v (lime_image_data_util_resize);
+	DEFINE_PRIME4v (lime_image_data_util_resize_linear);
 	DEFINE_PRIME2v (lime_image_data_util_set_format);
 	DEFINE_PRIME6v (lime_image_data_util_set_pixels);
 	DEFINE_PRIME12 (lime_image_data_util_threshold);
 	DEFINE_PRIME1v (lime_image_data_util_unmultiply_alpha);
+	DEFINE_PRIME2 (lime_image_decode_queue_cancel);
+	DEFINE_PRIME2 (lime_image_decode_queue_create);
+	DEFINE_PRIME1 (lime_image_decode_queue_get_memory_usage);
+	DEFINE_PRIME1 (lime_image_decode_queue_get_pending);
+	DEFINE_PRIME2 (lime_image_decode_queue_poll);
+	DEFINE_PRIME5 (lime_image_decode_queue_submit_bytes);
+	DEFINE_PRIME5 (lime_image_decode_queue_submit_file);
 	DEFINE_PRIME4 (lime_image_encode);
 	DEFINE_PRIME2 (lime_image_load);
 	DEFINE_PRIME2 (lime_image_load_bytes);
+	DEFINE_PRIME4 (lime_image_load_bytes_format);
+	DEFINE_PRIME6 (lime_image_load_bytes_into);
 	DEFINE_PRIME2 (lime_image_load_file);
+	DEFINE_PRIME4 (lime_image_load_file_format);
+	DEFINE_PRIME6 (lime_image_load_file_into);
 	DEFINE_PRIME0 (lime_jni_getenv);
 	DEFINE_PRIME2v (lime_joystick_event_manager_register);
 	DEFINE_PRIME1 (lime_joystick_get_device_guid);
@@ -4018,7 +5874,15 @@ namespace lime {
 	DEFINE_PRIME2v (lime_mouse_event_manager_register);
 	DEFINE_PRIME1v (lime_neko_execute);
 	DEFINE_PRIME3 (lime_png_decode_bytes);
+	DEFINE_PRIME6 (lime_png_decode_bytes_scaled);
 	DEFINE_PRIME3 (lime_png_decode_file);
+	DEFINE_PRIME6 (lime_png_decode_file_scaled);
+	DEFINE_PRIME6 (lime_png_encode);
+	DEFINE_PRIME4 (lime_png_stream_decoder_append);
+	DEFINE_PRIME0 (lime_png_stream_decoder_create);
+	DEFINE_PRIME1 (lime_png_stream_decoder_get_progress);
+	DEFINE_PRIME1 (lime_png_stream_decoder_get_rows);
+	DEFINE_PRIME2 (lime_png_stream_decoder_read);
 	DEFINE_PRIME2v (lime_render_event_manager_register);
 	DEFINE_PRIME2v (lime_sensor_event_manager_register);
 	DEFINE_PRIME0 (lime_system_get_allow_screen_timeout);
@@ -4125,6 +5989,11 @@ namespace lime {
 	DEFINE_HL_PRIM (_BOOL, hl_application_update, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_TAUDIOBUFFER, hl_audio_load_bytes, _TBYTES _TAUDIOBUFFER);
 	DEFINE_HL_PRIM (_TAUDIOBUFFER, hl_audio_load_file, _STRING _TAUDIOBUFFER);
+	DEFINE_HL_PRIM (_VOID, hl_buffer_pool_clear, _NO_ARG);
+	DEFINE_HL_PRIM (_I32, hl_buffer_pool_get_bytes_retained, _NO_ARG);
+	DEFINE_HL_PRIM (_I32, hl_buffer_pool_get_hits, _NO_ARG);
+	DEFINE_HL_PRIM (_I32, hl_buffer_pool_get_misses, _NO_ARG);
+	DEFINE_HL_PRIM (_VOID, hl_buffer_pool_set_retention, _I32);
 	DEFINE_HL_PRIM (_TBYTES, hl_bytes_from_data_pointer, _F64 _I32 _TBYTES);
 	DEFINE_HL_PRIM (_F64, hl_bytes_get_data_pointer, _TBYTES);
 	DEFINE_HL_PRIM (_F64, hl_bytes_get_data_pointer_offset, _TBYTES _I32);
@@ -4151,7 +6020,9 @@ namespace lime {
 	DEFINE_HL_PRIM (_BYTES, hl_font_get_family_name, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_I32, hl_font_get_glyph_index, _TCFFIPOINTER _STRING);
 	DEFINE_HL_PRIM (_ARR, hl_font_get_glyph_indices, _TCFFIPOINTER _STRING);
+	DEFINE_HL_PRIM (_TBYTES, hl_font_get_glyph_indices_packed, _TCFFIPOINTER _STRING _TBYTES);
 	DEFINE_HL_PRIM (_DYN, hl_font_get_glyph_metrics, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_I32, hl_font_get_glyph_metrics_batch, _TCFFIPOINTER _TARRAYBUFFERVIEW _TARRAYBUFFERVIEW);
 	DEFINE_HL_PRIM (_I32, hl_font_get_height, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_I32, hl_font_get_num_glyphs, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_I32, hl_font_get_underline_position, _TCFFIPOINTER);
@@ -4161,33 +6032,79 @@ namespace lime {
 	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_font_load_bytes, _TBYTES);
 	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_font_load_file, _STRING);
 	DEFINE_HL_PRIM (_DYN, hl_font_outline_decompose, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_TBYTES, hl_font_outline_decompose_packed, _TCFFIPOINTER _I32 _TARRAYBUFFERVIEW _TBYTES);
+	DEFINE_HL_PRIM (_TBYTES, hl_font_outline_triangulate, _TCFFIPOINTER _I32 _TARRAYBUFFERVIEW _F64 _TBYTES);
 	DEFINE_HL_PRIM (_TBYTES, hl_font_render_glyph, _TCFFIPOINTER _I32 _TBYTES);
 	DEFINE_HL_PRIM (_TBYTES, hl_font_render_glyphs, _TCFFIPOINTER _ARR _TBYTES);
+	DEFINE_HL_PRIM (_TBYTES, hl_font_render_glyphs_parallel, _TCFFIPOINTER _TARRAYBUFFERVIEW _TBYTES _I32);
+	DEFINE_HL_PRIM (_VOID, hl_font_set_cache_budget, _I32);
+	DEFINE_HL_PRIM (_VOID, hl_font_set_render_mode, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_VOID, hl_font_set_sdf_spread, _TCFFIPOINTER _I32);
 	DEFINE_HL_PRIM (_VOID, hl_font_set_size, _TCFFIPOINTER _I32 _I32);
 	DEFINE_HL_PRIM (_VOID, hl_gamepad_add_mappings, _ARR);
 	DEFINE_HL_PRIM (_VOID, hl_gamepad_event_manager_register, _FUN(_VOID, _NO_ARG) _TGAMEPAD_EVENT);
 	DEFINE_HL_PRIM (_BYTES, hl_gamepad_get_device_guid, _I32);
 	DEFINE_HL_PRIM (_BYTES, hl_gamepad_get_device_name, _I32);
+	DEFINE_HL_PRIM (_I32, hl_glyph_atlas_add_glyphs, _TCFFIPOINTER _TCFFIPOINTER _TARRAYBUFFERVIEW _TARRAYBUFFERVIEW);
+	DEFINE_HL_PRIM (_VOID, hl_glyph_atlas_clear, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_glyph_atlas_create, _I32 _I32 _I32 _I32 _I32);
+	DEFINE_HL_PRIM (_ARR, hl_glyph_atlas_flush, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_glyph_atlas_get_evictions, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_F64, hl_glyph_atlas_get_page, _TCFFIPOINTER _I32 _TIMAGEBUFFER);
+	DEFINE_HL_PRIM (_I32, hl_glyph_atlas_get_page_count, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_VOID, hl_glyph_atlas_remove_font, _TCFFIPOINTER _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_TBYTES, hl_gzip_compress, _TBYTES _TBYTES);
 	DEFINE_HL_PRIM (_TBYTES, hl_gzip_decompress, _TBYTES _TBYTES);
 	DEFINE_HL_PRIM (_VOID, hl_haptic_vibrate, _I32 _I32);
+	DEFINE_HL_PRIM (_I32, hl_image_cache_add_bytes, _TCFFIPOINTER _TBYTES _I32 _BOOL);
+	DEFINE_HL_PRIM (_I32, hl_image_cache_add_file, _TCFFIPOINTER _STRING _I32 _BOOL);
+	DEFINE_HL_PRIM (_I32, hl_image_cache_add_image, _TCFFIPOINTER _TIMAGEBUFFER);
+	DEFINE_HL_PRIM (_VOID, hl_image_cache_clear, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_image_cache_create, _I32);
+	DEFINE_HL_PRIM (_I32, hl_image_cache_get_evictions, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_image_cache_get_hits, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_image_cache_get_memory_usage, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_image_cache_get_misses, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_BOOL, hl_image_cache_is_resident, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_F64, hl_image_cache_pin, _TCFFIPOINTER _I32 _TIMAGEBUFFER);
+	DEFINE_HL_PRIM (_BOOL, hl_image_cache_remove, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_VOID, hl_image_cache_set_memory_budget, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_VOID, hl_image_cache_unpin, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_VOID, hl_image_data_util_alpha_bleed, _TIMAGE _TRECTANGLE _I32);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_color_transform, _TIMAGE _TRECTANGLE _TARRAYBUFFERVIEW);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_copy_channel, _TIMAGE _TIMAGE _TRECTANGLE _TVECTOR2 _I32 _I32);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_copy_pixels, _TIMAGE _TIMAGE _TRECTANGLE _TVECTOR2 _TIMAGE _TVECTOR2 _BOOL);
+	DEFINE_HL_PRIM (_VOID, hl_image_data_util_copy_pixels_linear, _TIMAGE _TIMAGE _TRECTANGLE _TVECTOR2 _TIMAGE _TVECTOR2 _BOOL);
+	DEFINE_HL_PRIM (_DYN, hl_image_data_util_diff, _TIMAGE _TIMAGE _TRECTANGLE _I32);
+	DEFINE_HL_PRIM (_VOID, hl_image_data_util_draw_triangles, _TIMAGE _TIMAGE _TARRAYBUFFERVIEW _TARRAYBUFFERVIEW _TARRAYBUFFERVIEW _I32 _BOOL _BOOL);
+	DEFINE_HL_PRIM (_VOID, hl_image_data_util_extrude, _TIMAGE _TRECTANGLE _I32);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_fill_rect, _TIMAGE _TRECTANGLE _I32 _I32);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_flood_fill, _TIMAGE _I32 _I32 _I32 _I32);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_get_pixels, _TIMAGE _TRECTANGLE _I32 _TBYTES);
+	DEFINE_HL_PRIM (_BYTES, hl_image_data_util_hash, _TIMAGE _TRECTANGLE);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_merge, _TIMAGE _TIMAGE _TRECTANGLE _TVECTOR2 _I32 _I32 _I32 _I32);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_multiply_alpha, _TIMAGE);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_resize, _TIMAGE _TIMAGEBUFFER _I32 _I32);
+	DEFINE_HL_PRIM (_VOID, hl_image_data_util_resize_linear, _TIMAGE _TIMAGEBUFFER _I32 _I32);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_set_format, _TIMAGE _I32);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_set_pixels, _TIMAGE _TRECTANGLE _TBYTES _I32 _I32 _I32);
 	DEFINE_HL_PRIM (_I32, hl_image_data_util_threshold, _TIMAGE _TIMAGE _TRECTANGLE _TVECTOR2 _I32 _I32 _I32 _I32 _I32 _I32 _I32 _BOOL);
 	DEFINE_HL_PRIM (_VOID, hl_image_data_util_unmultiply_alpha, _TIMAGE);
+	DEFINE_HL_PRIM (_BOOL, hl_image_decode_queue_cancel, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_image_decode_queue_create, _I32 _I32);
+	DEFINE_HL_PRIM (_I32, hl_image_decode_queue_get_memory_usage, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_image_decode_queue_get_pending, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_image_decode_queue_poll, _TCFFIPOINTER _TIMAGEBUFFER);
+	DEFINE_HL_PRIM (_I32, hl_image_decode_queue_submit_bytes, _TCFFIPOINTER _TBYTES _I32 _BOOL _I32);
+	DEFINE_HL_PRIM (_I32, hl_image_decode_queue_submit_file, _TCFFIPOINTER _STRING _I32 _BOOL _I32);
 	DEFINE_HL_PRIM (_TBYTES, hl_image_encode, _TIMAGEBUFFER _I32 _I32 _TBYTES);
 	// DEFINE_PRIME2 (lime_image_load);
 	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_image_load_bytes, _TBYTES _TIMAGEBUFFER);
+	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_image_load_bytes_format, _TBYTES _TIMAGEBUFFER _I32 _BOOL);
+	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_image_load_bytes_into, _TBYTES _TIMAGEBUFFER _I32 _I32 _I32 _BOOL);
 	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_image_load_file, _STRING _TIMAGEBUFFER);
+	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_image_load_file_format, _STRING _TIMAGEBUFFER _I32 _BOOL);
+	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_image_load_file_into, _STRING _TIMAGEBUFFER _I32 _I32 _I32 _BOOL);
 	DEFINE_HL_PRIM (_F64, hl_jni_getenv, _NO_ARG);
 	DEFINE_HL_PRIM (_VOID, hl_joystick_event_manager_register, _FUN(_VOID, _NO_ARG) _TJOYSTICK_EVENT);
 	DEFINE_HL_PRIM (_BYTES, hl_joystick_get_device_guid, _I32);
@@ -4206,7 +6123,15 @@ namespace lime {
 	DEFINE_HL_PRIM (_VOID, hl_mouse_event_manager_register, _FUN (_VOID, _NO_ARG) _TMOUSE_EVENT);
 	// DEFINE_PRIME1v (lime_neko_execute);
 	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_png_decode_bytes, _TBYTES _BOOL _TIMAGEBUFFER);
+	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_png_decode_bytes_scaled, _TBYTES _TIMAGEBUFFER _I32 _I32 _I32 _BOOL);
 	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_png_decode_file, _STRING _BOOL _TIMAGEBUFFER);
+	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_png_decode_file_scaled, _STRING _TIMAGEBUFFER _I32 _I32 _I32 _BOOL);
+	DEFINE_HL_PRIM (_TBYTES, hl_png_encode, _TIMAGEBUFFER _TBYTES _I32 _I32 _BOOL _I32);
+	DEFINE_HL_PRIM (_BOOL, hl_png_stream_decoder_append, _TCFFIPOINTER _TBYTES _I32 _I32);
+	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_png_stream_decoder_create, _NO_ARG);
+	DEFINE_HL_PRIM (_F32, hl_png_stream_decoder_get_progress, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_png_stream_decoder_get_rows, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_TIMAGEBUFFER, hl_png_stream_decoder_read, _TCFFIPOINTER _TIMAGEBUFFER);
 	DEFINE_HL_PRIM (_VOID, hl_render_event_manager_register, _FUN (_VOID, _NO_ARG) _TRENDER_EVENT);
 	DEFINE_HL_PRIM (_VOID, hl_sensor_event_manager_register, _FUN (_VOID, _NO_ARG) _TSENSOR_EVENT);
 	DEFINE_HL_PRIM (_BOOL, hl_system_get_allow_screen_timeout, _NO_ARG);
@@ -85,6 +85,21 @@ namespace lime {
 	}
 
 
+	bool ImageBuffer::CheckBounds (ArrayBufferView* data, int offset, int stride, int width, int height) {
+
+		// whether 32-bit rows of the given size fit in the existing allocation, from the start of its buffer
+
+		if (!data || !data->buffer || !data->buffer->b || width <= 0 || height <= 0 || offset < 0 || stride < (long long)width * 4) {
+
+			return false;
+
+		}
+
+		return ((long long)offset + (long long)stride * (height - 1) + (long long)width * 4 <= data->buffer->length);
+
+	}
+
+
 	void ImageBuffer::Resize (int width, int height, int bitsPerPixel) {
 
 		this->bitsPerPixel = bitsPerPixel;
@@ -0,0 +1,551 @@
+#include <graphics/format/JPEG.h>
+#include <graphics/format/PNG.h>
+#include <graphics/format/QOI.h>
+#include <graphics/ImageCache.h>
+#include <utils/Resource.h>
+#include <stdio.h>
+#include <string.h>
+
+
+namespace lime {
+
+
+	static bool DecodeImage (Resource* resource, ImageBuffer* buffer, PixelFormat format, bool premultiplied) {
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (resource, buffer, true, format, premultiplied)) {
+
+			return true;
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::Decode (resource, buffer, true, format, premultiplied)) {
+
+			return true;
+
+		}
+		#endif
+
+		if (QOI::Decode (resource, buffer, true, format, premultiplied)) {
+
+			return true;
+
+		}
+
+		return false;
+
+	}
+
+
+	static std::string HashKey (const unsigned char* data, int length, PixelFormat format, bool premultiplied) {
+
+		// FNV-1a, the length and decode options are part of the key so distinct requests never collide
+
+		unsigned long long hash = 0xcbf29ce484222325ULL;
+
+		for (int i = 0; i < length; i++) {
+
+			hash ^= data[i];
+			hash *= 0x100000001b3ULL;
+
+		}
+
+		char key[64];
+		snprintf (key, sizeof (key), "#%016llx:%d:%d:%d", hash, length, (int)format, premultiplied ? 1 : 0);
+		return std::string (key);
+
+	}
+
+
+	ImageCacheEntry::ImageCacheEntry () {
+
+		// allocated on the calling (GC) thread, so CFFI ids are never initialized elsewhere
+
+		buffer = new ImageBuffer (alloc_null ());
+		buffer->data = new ArrayBufferView (alloc_null ());
+		decoding = false;
+		format = RGBA32;
+		id = 0;
+		pins = 0;
+		premultiplied = false;
+		resident = false;
+		size = 0;
+		source = 0;
+
+	}
+
+
+	ImageCacheEntry::~ImageCacheEntry () {
+
+		if (buffer) {
+
+			if (buffer->data) {
+
+				buffer->data->buffer->Resize (0);
+
+			}
+
+			delete buffer;
+
+		}
+
+		if (source) {
+
+			source->Resize (0);
+			delete source;
+
+		}
+
+	}
+
+
+	ImageCache::ImageCache (int memoryBudget) {
+
+		this->memoryBudget = memoryBudget;
+		evictions = 0;
+		hits = 0;
+		memoryUsage = 0;
+		misses = 0;
+		nextID = 1;
+
+	}
+
+
+	ImageCache::~ImageCache () {
+
+		Clear ();
+
+	}
+
+
+	int ImageCache::Add (Bytes* data, PixelFormat format, bool premultiplied) {
+
+		if (!data || !data->b || data->length <= 0) {
+
+			return 0;
+
+		}
+
+		std::string key = HashKey (data->b, data->length, format, premultiplied);
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		std::map<std::string, int>::iterator it = keys.find (key);
+
+		if (it != keys.end ()) {
+
+			return it->second;
+
+		}
+
+		// the encoded source is kept, it is what the pixels are rebuilt from after an eviction
+
+		ImageCacheEntry* entry = new ImageCacheEntry ();
+		entry->format = format;
+		entry->key = key;
+		entry->premultiplied = premultiplied;
+		entry->source = new Bytes ();
+		entry->source->Resize (data->length);
+		memcpy (entry->source->b, data->b, data->length);
+		memoryUsage += data->length;
+
+		int id = Insert (entry);
+		Trim (0);
+
+		return id;
+
+	}
+
+
+	int ImageCache::Add (const char* path, PixelFormat format, bool premultiplied) {
+
+		if (!path) {
+
+			return 0;
+
+		}
+
+		char options[16];
+		snprintf (options, sizeof (options), ":%d:%d", (int)format, premultiplied ? 1 : 0);
+		std::string key = std::string (path) + options;
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		std::map<std::string, int>::iterator it = keys.find (key);
+
+		if (it != keys.end ()) {
+
+			return it->second;
+
+		}
+
+		ImageCacheEntry* entry = new ImageCacheEntry ();
+		entry->format = format;
+		entry->key = key;
+		entry->path = path;
+		entry->premultiplied = premultiplied;
+
+		return Insert (entry);
+
+	}
+
+
+	int ImageCache::Add (ImageBuffer* buffer) {
+
+		if (!buffer || !buffer->data || !buffer->data->buffer->b || buffer->width <= 0 || buffer->height <= 0) {
+
+			return 0;
+
+		}
+
+		// pixels without a source are kept resident, and compressed to QOI if they are evicted
+
+		ImageCacheEntry* entry = new ImageCacheEntry ();
+		entry->format = buffer->format;
+		entry->premultiplied = buffer->premultiplied;
+
+		ImageBuffer* target = entry->buffer;
+		target->Resize (buffer->width, buffer->height, buffer->bitsPerPixel);
+		memcpy (target->data->buffer->b, buffer->data->buffer->b, target->data->byteLength);
+		target->format = buffer->format;
+		target->premultiplied = buffer->premultiplied;
+		target->transparent = buffer->transparent;
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		entry->resident = true;
+		entry->size = target->data->byteLength;
+		memoryUsage += entry->size;
+
+		int id = Insert (entry);
+		Trim (entry);
+
+		return id;
+
+	}
+
+
+	void ImageCache::Clear () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		// pinned entries stay, their pixels are still in use until they are unpinned
+
+		std::map<int, ImageCacheEntry*>::iterator it = entries.begin ();
+
+		while (it != entries.end ()) {
+
+			ImageCacheEntry* entry = it->second;
+
+			if (entry->pins > 0) {
+
+				it++;
+				continue;
+
+			}
+
+			memoryUsage -= Size (entry);
+
+			if (!entry->key.empty ()) {
+
+				keys.erase (entry->key);
+
+			}
+
+			lru.erase (entry->lru);
+			entries.erase (it++);
+			delete entry;
+
+		}
+
+	}
+
+
+	bool ImageCache::Evict (ImageCacheEntry* entry) {
+
+		if (!entry->resident || entry->pins > 0) {
+
+			return false;
+
+		}
+
+		if (!entry->source && entry->path.empty ()) {
+
+			Bytes* source = new Bytes ();
+
+			if (!QOI::Encode (entry->buffer, source)) {
+
+				source->Resize (0);
+				delete source;
+				return false;
+
+			}
+
+			entry->source = source;
+			memoryUsage += source->length;
+
+		}
+
+		entry->buffer->data->Resize (0);
+		entry->resident = false;
+		memoryUsage -= entry->size;
+		entry->size = 0;
+		evictions++;
+
+		return true;
+
+	}
+
+
+	ImageCacheEntry* ImageCache::Find (int id) {
+
+		std::map<int, ImageCacheEntry*>::iterator it = entries.find (id);
+		return it != entries.end () ? it->second : 0;
+
+	}
+
+
+	int ImageCache::GetEvictions () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return evictions;
+
+	}
+
+
+	int ImageCache::GetHits () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return hits;
+
+	}
+
+
+	int ImageCache::GetMemoryBudget () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return memoryBudget;
+
+	}
+
+
+	int ImageCache::GetMemoryUsage () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return memoryUsage;
+
+	}
+
+
+	int ImageCache::GetMisses () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return misses;
+
+	}
+
+
+	int ImageCache::Insert (ImageCacheEntry* entry) {
+
+		entry->id = nextID++;
+		entries[entry->id] = entry;
+
+		if (!entry->key.empty ()) {
+
+			keys[entry->key] = entry->id;
+
+		}
+
+		lru.push_front (entry);
+		entry->lru = lru.begin ();
+
+		return entry->id;
+
+	}
+
+
+	bool ImageCache::IsResident (int id) {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		ImageCacheEntry* entry = Find (id);
+		return entry && entry->resident;
+
+	}
+
+
+	ImageBuffer* ImageCache::Pin (int id) {
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		ImageCacheEntry* entry = Find (id);
+
+		if (!entry) {
+
+			return 0;
+
+		}
+
+		// the pin keeps the entry from being evicted or removed while the lock is released to decode
+
+		entry->pins++;
+
+		if (entry->resident) {
+
+			hits++;
+
+		} else {
+
+			misses++;
+
+			while (entry->decoding) {
+
+				decoded.wait (lock);
+
+			}
+
+			if (!entry->resident) {
+
+				entry->decoding = true;
+				lock.unlock ();
+
+				Resource resource;
+
+				if (entry->source) {
+
+					resource = Resource (entry->source);
+
+				} else {
+
+					resource = Resource (entry->path.c_str ());
+
+				}
+
+				bool success = DecodeImage (&resource, entry->buffer, entry->format, entry->premultiplied);
+
+				lock.lock ();
+				entry->decoding = false;
+				decoded.notify_all ();
+
+				if (!success) {
+
+					entry->buffer->data->Resize (0);
+					entry->pins--;
+					return 0;
+
+				}
+
+				entry->resident = true;
+				entry->size = entry->buffer->data->byteLength;
+				memoryUsage += entry->size;
+
+			}
+
+		}
+
+		lru.splice (lru.begin (), lru, entry->lru);
+
+		// a pinned image larger than the budget stays resident, everything else older goes first
+
+		Trim (entry);
+
+		return entry->buffer;
+
+	}
+
+
+	bool ImageCache::Remove (int id) {
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		ImageCacheEntry* entry = Find (id);
+
+		if (!entry || entry->pins > 0) {
+
+			return false;
+
+		}
+
+		memoryUsage -= Size (entry);
+
+		if (!entry->key.empty ()) {
+
+			keys.erase (entry->key);
+
+		}
+
+		lru.erase (entry->lru);
+		entries.erase (id);
+		delete entry;
+
+		return true;
+
+	}
+
+
+	void ImageCache::SetMemoryBudget (int memoryBudget) {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		this->memoryBudget = memoryBudget;
+		Trim (0);
+
+	}
+
+
+	int ImageCache::Size (ImageCacheEntry* entry) {
+
+		// the encoded source an entry keeps counts against the budget along with its pixels
+
+		return (entry->resident ? entry->size : 0) + (entry->source ? entry->source->length : 0);
+
+	}
+
+
+	void ImageCache::Trim (ImageCacheEntry* keep) {
+
+		if (memoryBudget <= 0) {
+
+			return;
+
+		}
+
+		std::list<ImageCacheEntry*>::iterator it = lru.end ();
+
+		while (memoryUsage > memoryBudget && it != lru.begin ()) {
+
+			it--;
+
+			if (*it != keep) {
+
+				Evict (*it);
+
+			}
+
+		}
+
+	}
+
+
+	void ImageCache::Unpin (int id) {
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		ImageCacheEntry* entry = Find (id);
+
+		if (entry && entry->pins > 0) {
+
+			entry->pins--;
+
+			if (entry->pins == 0) {
+
+				Trim (0);
+
+			}
+
+		}
+
+	}
+
+
+}
\ No newline at end of file
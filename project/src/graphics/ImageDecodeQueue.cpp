@@ -0,0 +1,408 @@
+#include <graphics/format/JPEG.h>
+#include <graphics/format/PNG.h>
+#include <graphics/format/QOI.h>
+#include <graphics/ImageDecodeQueue.h>
+#include <system/System.h>
+#include <utils/Resource.h>
+
+
+namespace lime {
+
+
+	static bool DecodeImage (Resource* resource, ImageBuffer* buffer, bool decodeData, PixelFormat format, bool premultiplied) {
+
+		#ifdef LIME_PNG
+		if (PNG::Decode (resource, buffer, decodeData, format, premultiplied)) {
+
+			return true;
+
+		}
+		#endif
+
+		#ifdef LIME_JPEG
+		if (JPEG::Decode (resource, buffer, decodeData, format, premultiplied)) {
+
+			return true;
+
+		}
+		#endif
+
+		if (QOI::Decode (resource, buffer, decodeData, format, premultiplied)) {
+
+			return true;
+
+		}
+
+		return false;
+
+	}
+
+
+	ImageDecodeJob::ImageDecodeJob () {
+
+		// allocated on the calling (GC) thread, so that workers never initialize CFFI ids
+
+		buffer = new ImageBuffer (alloc_null ());
+		buffer->data = new ArrayBufferView (alloc_null ());
+		cancelled = false;
+		data = 0;
+		format = RGBA32;
+		id = 0;
+		premultiplied = false;
+		priority = 0;
+		reserved = 0;
+		success = false;
+
+	}
+
+
+	ImageDecodeJob::~ImageDecodeJob () {
+
+		if (buffer) {
+
+			if (buffer->data) {
+
+				buffer->data->buffer->Resize (0);
+
+			}
+
+			delete buffer;
+
+		}
+
+		if (data) {
+
+			data->Resize (0);
+			delete data;
+
+		}
+
+	}
+
+
+	ImageDecodeQueue::ImageDecodeQueue (int numThreads, int memoryBudget) {
+
+		if (numThreads <= 0) {
+
+			numThreads = std::thread::hardware_concurrency ();
+			if (numThreads > 1) numThreads--;
+			if (numThreads <= 0) numThreads = 1;
+
+		}
+
+		this->memoryBudget = memoryBudget;
+		memoryUsage = 0;
+		nextID = 1;
+		running = true;
+
+		for (int i = 0; i < numThreads; i++) {
+
+			threads.push_back (std::thread (ThreadMain, this));
+
+		}
+
+	}
+
+
+	ImageDecodeQueue::~ImageDecodeQueue () {
+
+		mutex.lock ();
+		running = false;
+		mutex.unlock ();
+
+		workCondition.notify_all ();
+		budgetCondition.notify_all ();
+
+		for (size_t i = 0; i < threads.size (); i++) {
+
+			threads[i].join ();
+
+		}
+
+		for (size_t i = 0; i < pending.size (); i++) {
+
+			delete pending[i];
+
+		}
+
+		for (size_t i = 0; i < completed.size (); i++) {
+
+			delete completed[i];
+
+		}
+
+	}
+
+
+	bool ImageDecodeQueue::Cancel (int id) {
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		for (size_t i = 0; i < pending.size (); i++) {
+
+			if (pending[i]->id == id) {
+
+				delete pending[i];
+				pending.erase (pending.begin () + i);
+				return true;
+
+			}
+
+		}
+
+		for (size_t i = 0; i < active.size (); i++) {
+
+			if (active[i]->id == id) {
+
+				// the worker discards the result once it is done with the job
+				active[i]->cancelled = true;
+				budgetCondition.notify_all ();
+				return true;
+
+			}
+
+		}
+
+		for (size_t i = 0; i < completed.size (); i++) {
+
+			if (completed[i]->id == id) {
+
+				ImageDecodeJob* job = completed[i];
+				completed.erase (completed.begin () + i);
+				Release (job);
+				delete job;
+				return true;
+
+			}
+
+		}
+
+		return false;
+
+	}
+
+
+	int ImageDecodeQueue::Enqueue (ImageDecodeJob* job, PixelFormat format, bool premultiplied, int priority) {
+
+		job->format = format;
+		job->premultiplied = premultiplied;
+		job->priority = priority;
+
+		mutex.lock ();
+		job->id = nextID++;
+		pending.push_back (job);
+		int id = job->id;
+		mutex.unlock ();
+
+		workCondition.notify_one ();
+
+		return id;
+
+	}
+
+
+	int ImageDecodeQueue::GetMemoryUsage () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return memoryUsage;
+
+	}
+
+
+	int ImageDecodeQueue::GetPending () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return pending.size () + active.size () + completed.size ();
+
+	}
+
+
+	ImageDecodeJob* ImageDecodeQueue::Poll () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		if (completed.empty ()) {
+
+			return 0;
+
+		}
+
+		ImageDecodeJob* job = completed.front ();
+		completed.erase (completed.begin ());
+
+		// ownership of the pixels moves to the caller, which frees the budget for the next decode
+		Release (job);
+
+		return job;
+
+	}
+
+
+	void ImageDecodeQueue::Release (ImageDecodeJob* job) {
+
+		if (job->reserved > 0) {
+
+			memoryUsage -= job->reserved;
+			job->reserved = 0;
+			budgetCondition.notify_all ();
+
+		}
+
+	}
+
+
+	void ImageDecodeQueue::Run () {
+
+		System::GCIgnoreThread ();
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		while (true) {
+
+			while (running && pending.empty ()) {
+
+				workCondition.wait (lock);
+
+			}
+
+			if (!running) break;
+
+			// highest priority first, then submission order
+
+			size_t next = 0;
+
+			for (size_t i = 1; i < pending.size (); i++) {
+
+				if (pending[i]->priority > pending[next]->priority) {
+
+					next = i;
+
+				}
+
+			}
+
+			ImageDecodeJob* job = pending[next];
+			pending.erase (pending.begin () + next);
+			active.push_back (job);
+
+			lock.unlock ();
+
+			Resource resource;
+
+			if (job->data) {
+
+				resource = Resource (job->data);
+
+			} else {
+
+				resource = Resource (job->path.c_str ());
+
+			}
+
+			bool valid = DecodeImage (&resource, job->buffer, false, job->format, job->premultiplied);
+			int size = valid ? job->buffer->width * job->buffer->height * 4 : 0;
+
+			lock.lock ();
+
+			if (valid) {
+
+				// a single image larger than the budget may still decode, but only on its own
+
+				while (running && !job->cancelled && memoryBudget > 0 && memoryUsage > 0 && memoryUsage + size > memoryBudget) {
+
+					budgetCondition.wait (lock);
+
+				}
+
+				if (running && !job->cancelled) {
+
+					job->reserved = size;
+					memoryUsage += size;
+
+					lock.unlock ();
+
+					job->success = DecodeImage (&resource, job->buffer, true, job->format, job->premultiplied);
+
+					lock.lock ();
+
+				}
+
+			}
+
+			for (size_t i = 0; i < active.size (); i++) {
+
+				if (active[i] == job) {
+
+					active.erase (active.begin () + i);
+					break;
+
+				}
+
+			}
+
+			if (!running || job->cancelled) {
+
+				Release (job);
+				delete job;
+
+			} else {
+
+				if (!job->success) {
+
+					Release (job);
+
+				}
+
+				completed.push_back (job);
+
+			}
+
+		}
+
+	}
+
+
+	int ImageDecodeQueue::Submit (Bytes* data, PixelFormat format, bool premultiplied, int priority) {
+
+		if (!data || !data->b || data->length <= 0) {
+
+			return 0;
+
+		}
+
+		// copy the source, the caller's Bytes may be collected before a worker reaches it
+
+		ImageDecodeJob* job = new ImageDecodeJob ();
+		job->data = new Bytes ();
+		job->data->Resize (data->length);
+		memcpy (job->data->b, data->b, data->length);
+
+		return Enqueue (job, format, premultiplied, priority);
+
+	}
+
+
+	int ImageDecodeQueue::Submit (const char* path, PixelFormat format, bool premultiplied, int priority) {
+
+		if (!path) {
+
+			return 0;
+
+		}
+
+		ImageDecodeJob* job = new ImageDecodeJob ();
+		job->path = path;
+
+		return Enqueue (job, format, premultiplied, priority);
+
+	}
+
+
+	void ImageDecodeQueue::ThreadMain (ImageDecodeQueue* queue) {
+
+		queue->Run ();
+
+	}
+
+
+}
\ No newline at end of file
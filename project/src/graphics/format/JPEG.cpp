@@ -188,7 +188,7 @@ namespace lime {
 	};
 
 
-	bool JPEG::Decode (Resource *resource, ImageBuffer* imageBuffer, bool decodeData) {
+	static bool decode_jpeg (Resource *resource, ImageBuffer* imageBuffer, bool decodeData, PixelFormat format, bool premultiplied, bool into, int offset, int stride) {
 
 		struct jpeg_decompress_struct cinfo;
 
@@ -268,7 +268,7 @@ namespace lime {
 
 		bool decoded = false;
 
-		if (jpeg_read_header (&cinfo, TRUE) == JPEG_HEADER_OK) {
+		if (jpeg_read_header (&cinfo, TRUE) == JPEG_HEADER_OK && (!into || ImageBuffer::CheckBounds (imageBuffer->data, offset, stride, cinfo.image_width, cinfo.image_height))) {
 
 			switch (cinfo.jpeg_color_space) {
 
@@ -294,16 +294,63 @@ namespace lime {
 
 			if (decodeData) {
 
+				#ifdef JCS_ALPHA_EXTENSIONS
+				if (cinfo.out_color_space == JCS_RGB) {
+
+					// libjpeg-turbo can color convert straight into the target layout
+
+					switch (format) {
+
+						case RGBA32: cinfo.out_color_space = JCS_EXT_RGBA; break;
+						case ARGB32: cinfo.out_color_space = JCS_EXT_ARGB; break;
+						case BGRA32: cinfo.out_color_space = JCS_EXT_BGRA; break;
+
+					}
+
+				}
+				#endif
+
 				jpeg_start_decompress (&cinfo);
 
 				int components = cinfo.output_components;
-				imageBuffer->Resize (cinfo.output_width, cinfo.output_height, 32);
+				unsigned char *pixels;
+
+				if (into) {
+
+					pixels = imageBuffer->data->buffer->b + offset;
+					imageBuffer->width = cinfo.output_width;
+					imageBuffer->height = cinfo.output_height;
+					imageBuffer->bitsPerPixel = 32;
+
+				} else {
+
+					imageBuffer->Resize (cinfo.output_width, cinfo.output_height, 32);
+					pixels = imageBuffer->data->buffer->b;
+					stride = imageBuffer->Stride ();
+
+				}
+
+				// JPEG has no alpha, so premultiplied pixels are identical to straight ones
+				imageBuffer->format = format;
+				imageBuffer->premultiplied = premultiplied;
+
+				unsigned char *bytes;
+				unsigned char *scanline = NULL;
+
+				int r = 0, g = 1, b = 2, a = 3;
+
+				switch (format) {
+
+					case RGBA32: r = 0; g = 1; b = 2; a = 3; break;
+					case ARGB32: r = 1; g = 2; b = 3; a = 0; break;
+					case BGRA32: r = 2; g = 1; b = 0; a = 3; break;
 
-				unsigned char *bytes = imageBuffer->data->buffer->b;
-				unsigned char *scanline = new unsigned char [imageBuffer->width * components];
+				}
 
 				if (cinfo.out_color_space == JCS_CMYK) {
 
+					scanline = new unsigned char [imageBuffer->width * components];
+
 					bool invert = false;
 					jpeg_saved_marker_ptr marker;
 					marker = cinfo.marker_list;
@@ -323,6 +370,7 @@ namespace lime {
 
 					while (cinfo.output_scanline < cinfo.output_height) {
 
+						bytes = pixels + cinfo.output_scanline * stride;
 						jpeg_read_scanlines (&cinfo, &scanline, 1);
 
 						const unsigned char *line = scanline;
@@ -347,19 +395,34 @@ namespace lime {
 
 							}
 
-							*bytes++ = (unsigned char)((0xFF - c) * (0xFF - k) / 0xFF);
-							*bytes++ = (unsigned char)((0xFF - m) * (0xFF - k) / 0xFF);
-							*bytes++ = (unsigned char)((0xFF - y) * (0xFF - k) / 0xFF);
-							*bytes++ = 0xFF;
+							bytes[r] = (unsigned char)((0xFF - c) * (0xFF - k) / 0xFF);
+							bytes[g] = (unsigned char)((0xFF - m) * (0xFF - k) / 0xFF);
+							bytes[b] = (unsigned char)((0xFF - y) * (0xFF - k) / 0xFF);
+							bytes[a] = 0xFF;
+							bytes += 4;
 
 						}
 
 					}
 
+				} else if (components == 4) {
+
+					JSAMPROW row;
+
+					while (cinfo.output_scanline < cinfo.output_height) {
+
+						row = pixels + cinfo.output_scanline * stride;
+						jpeg_read_scanlines (&cinfo, &row, 1);
+
+					}
+
 				} else {
 
+					scanline = new unsigned char [imageBuffer->width * components];
+
 					while (cinfo.output_scanline < cinfo.output_height) {
 
+						bytes = pixels + cinfo.output_scanline * stride;
 						jpeg_read_scanlines (&cinfo, &scanline, 1);
 
 						// convert 24-bit scanline to 32-bit
@@ -368,10 +431,11 @@ namespace lime {
 
 						while (line < end) {
 
-							*bytes++ = *line++;
-							*bytes++ = *line++;
-							*bytes++ = *line++;
-							*bytes++ = 0xFF;
+							bytes[r] = *line++;
+							bytes[g] = *line++;
+							bytes[b] = *line++;
+							bytes[a] = 0xFF;
+							bytes += 4;
 
 						}
 
@@ -379,7 +443,7 @@ namespace lime {
 
 				}
 
-				delete[] scanline;
+				if (scanline) delete[] scanline;
 
 				jpeg_finish_decompress (&cinfo);
 
@@ -418,6 +482,20 @@ namespace lime {
 	}
 
 
+	bool JPEG::Decode (Resource *resource, ImageBuffer* imageBuffer, bool decodeData, PixelFormat format, bool premultiplied) {
+
+		return decode_jpeg (resource, imageBuffer, decodeData, format, premultiplied, false, 0, 0);
+
+	}
+
+
+	bool JPEG::DecodeInto (Resource *resource, ImageBuffer* imageBuffer, int offset, int stride, PixelFormat format, bool premultiplied) {
+
+		return decode_jpeg (resource, imageBuffer, true, format, premultiplied, true, offset, stride);
+
+	}
+
+
 	bool JPEG::Encode (ImageBuffer *imageBuffer, Bytes *bytes, int quality) {
 
 		struct jpeg_compress_struct cinfo;
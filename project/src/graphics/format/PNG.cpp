@@ -6,9 +6,14 @@ extern "C" {
 
 }
 
+#include <limits.h>
 #include <setjmp.h>
+#include <zlib.h>
+#include <algorithm>
+#include <vector>
 #include <graphics/format/PNG.h>
 #include <graphics/ImageBuffer.h>
+#include <system/Parallel.h>
 #include <system/System.h>
 #include <utils/Bytes.h>
 #include <utils/QuickVec.h>
@@ -68,18 +73,734 @@ namespace lime {
 	static void user_warning_fn (png_structp png_ptr, png_const_charp warning_msg) {}
 
 
-	void user_write_data (png_structp png_ptr, png_bytep data, png_size_t length) {
+	struct WriteBuffer {
 
-		QuickVec<unsigned char> *buffer = (QuickVec<unsigned char> *)png_get_io_ptr (png_ptr);
-		buffer->append ((unsigned char *)data,(int)length);
+		WriteBuffer (Bytes* bytes) : bytes (bytes), failed (false), length (0) {}
+
+		bool Reserve (size_t size) {
+
+			// Bytes has an int length, so capacity doubles in size_t and stops at INT_MAX
+
+			if (size > INT_MAX) {
+
+				failed = true;
+				return false;
+
+			}
+
+			if ((int)size > bytes->length) {
+
+				size_t capacity = bytes->length > 0 ? bytes->length : 4096;
+
+				while (capacity < size) {
+
+					capacity *= 2;
+
+				}
+
+				bytes->Resize ((int)std::min (capacity, (size_t)INT_MAX));
+
+			}
+
+			return true;
+
+		}
+
+		void Write (const unsigned char* data, size_t count) {
+
+			if (failed || !Reserve ((size_t)length + count)) {
+
+				return;
+
+			}
+
+			memcpy (bytes->b + length, data, count);
+			length += count;
+
+		}
+
+		void WriteInt (unsigned int value) {
+
+			unsigned char data[4] = { (unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value };
+			Write (data, 4);
+
+		}
+
+		int BeginChunk (const char* type) {
+
+			int start = length;
+			WriteInt (0);
+			Write ((const unsigned char*)type, 4);
+			return start;
+
+		}
+
+		void EndChunk (int start) {
+
+			if (failed) {
+
+				return;
+
+			}
+
+			int size = length - start - 8;
+			unsigned char* chunk = bytes->b + start;
+			chunk[0] = size >> 24;
+			chunk[1] = size >> 16;
+			chunk[2] = size >> 8;
+			chunk[3] = size;
+			WriteInt (crc32 (0, chunk + 4, size + 4));
+
+		}
+
+		Bytes* bytes;
+		bool failed;
+		int length;
+
+	};
+
+
+	struct AreaDownscaler {
+
+		// box filter with exact fractional coverage, fed one RGBA source row at a time. Weights
+		// are integers in units where a source pixel is dstWidth wide and a destination pixel is
+		// srcWidth wide (likewise vertically), and colors are weighted by alpha so that
+		// transparent pixels do not bleed into their neighbours
+
+		AreaDownscaler (int srcWidth, int srcHeight, int dstWidth, int dstHeight, unsigned char* dest, int stride, PixelFormat format, bool premultiplied) : srcWidth (srcWidth), srcHeight (srcHeight), dstWidth (dstWidth), dstHeight (dstHeight), dest (dest), stride (stride), premultiplied (premultiplied), sourceRow (0) {
+
+			switch (format) {
+
+				case ARGB32: r = 1; g = 2; b = 3; a = 0; break;
+				case BGRA32: r = 2; g = 1; b = 0; a = 3; break;
+				default: r = 0; g = 1; b = 2; a = 3; break;
+
+			}
+
+			column.resize (srcWidth);
+			columnWeight.resize (srcWidth);
+
+			for (int x = 0; x < srcWidth; x++) {
+
+				long long start = (long long)x * dstWidth;
+				int index = start / srcWidth;
+				long long boundary = (long long)(index + 1) * srcWidth;
+				column[x] = index;
+				columnWeight[x] = (start + dstWidth <= boundary) ? dstWidth : (int)(boundary - start);
+
+			}
+
+			horizontal.resize (dstWidth * 4 + 4);
+			current.resize (dstWidth * 4 + 4);
+			next.resize (dstWidth * 4 + 4);
+
+		}
+
+		void PushRow (const unsigned char* row) {
+
+			std::fill (horizontal.begin (), horizontal.end (), 0);
+
+			for (int x = 0; x < srcWidth; x++, row += 4) {
+
+				unsigned long long pa = row[3];
+				if (pa == 0) continue;
+
+				unsigned long long pr = row[0] * pa;
+				unsigned long long pg = row[1] * pa;
+				unsigned long long pb = row[2] * pa;
+				unsigned long long* h = &horizontal[column[x] * 4];
+				unsigned long long w0 = columnWeight[x];
+				unsigned long long w1 = dstWidth - w0;
+
+				h[0] += w0 * pr; h[1] += w0 * pg; h[2] += w0 * pb; h[3] += w0 * pa;
+
+				if (w1) {
+
+					h[4] += w1 * pr; h[5] += w1 * pg; h[6] += w1 * pb; h[7] += w1 * pa;
+
+				}
+
+			}
+
+			long long start = (long long)sourceRow * dstHeight;
+			int index = start / srcHeight;
+			long long boundary = (long long)(index + 1) * srcHeight;
+			unsigned long long w0 = (start + dstHeight <= boundary) ? dstHeight : (boundary - start);
+			unsigned long long w1 = dstHeight - w0;
+			int length = dstWidth * 4;
+
+			for (int i = 0; i < length; i++) {
+
+				current[i] += w0 * horizontal[i];
+
+			}
+
+			if (w1 || start + dstHeight == boundary) {
+
+				EmitRow (index);
+				current.swap (next);
+				std::fill (next.begin (), next.end (), 0);
+
+				for (int i = 0; i < length; i++) {
+
+					current[i] += w1 * horizontal[i];
+
+				}
+
+			}
+
+			sourceRow++;
+
+		}
+
+		void EmitRow (int index) {
+
+			if (index >= dstHeight) return;
+
+			unsigned long long total = (unsigned long long)srcWidth * srcHeight;
+			unsigned char* out = dest + (long long)index * stride;
+			const unsigned long long* acc = &current[0];
+
+			for (int x = 0; x < dstWidth; x++, acc += 4, out += 4) {
+
+				unsigned long long sum = acc[3];
+
+				if (sum == 0) {
+
+					out[r] = out[g] = out[b] = out[a] = 0;
+					continue;
+
+				}
+
+				int alpha = (sum + total / 2) / total;
+				int cr = (acc[0] + sum / 2) / sum;
+				int cg = (acc[1] + sum / 2) / sum;
+				int cb = (acc[2] + sum / 2) / sum;
+
+				if (premultiplied && alpha != 0xFF) {
+
+					// matches RGBA::MultiplyAlpha
+					int a16 = (alpha + 1) * 257;
+					cr = alpha ? (cr * a16) >> 16 : 0;
+					cg = alpha ? (cg * a16) >> 16 : 0;
+					cb = alpha ? (cb * a16) >> 16 : 0;
+
+				}
+
+				out[r] = cr;
+				out[g] = cg;
+				out[b] = cb;
+				out[a] = alpha;
+
+			}
+
+		}
+
+		int srcWidth;
+		int srcHeight;
+		int dstWidth;
+		int dstHeight;
+		unsigned char* dest;
+		int stride;
+		bool premultiplied;
+		int sourceRow;
+		int r, g, b, a;
+		std::vector<int> column;
+		std::vector<int> columnWeight;
+		std::vector<unsigned long long> horizontal;
+		std::vector<unsigned long long> current;
+		std::vector<unsigned long long> next;
+		std::vector<unsigned char> rows;
+
+	};
+
+
+	static void fit_size (int width, int height, int maxWidth, int maxHeight, int* outWidth, int* outHeight) {
+
+		double w = width;
+		double h = height;
+
+		if (maxWidth > 0 && w > maxWidth) {
+
+			h = h * maxWidth / w;
+			w = maxWidth;
+
+		}
+
+		if (maxHeight > 0 && h > maxHeight) {
+
+			w = w * maxHeight / h;
+			h = maxHeight;
+
+		}
+
+		*outWidth = (int)(w + 0.5) < 1 ? 1 : (int)(w + 0.5);
+		*outHeight = (int)(h + 0.5) < 1 ? 1 : (int)(h + 0.5);
+
+		if (*outWidth > width) *outWidth = width;
+		if (*outHeight > height) *outHeight = height;
+
+	}
+
+
+	struct EncodeGroup {
+
+		EncodeGroup () : adler (0), failed (false) {}
+
+		uLong adler;
+		bool failed;
+		std::vector<unsigned char> output;
+
+	};
+
+
+	struct EncodeJob {
+
+		int bpp;
+		const unsigned char* data;
+		PNGFilterStrategy filter;
+		PixelFormat format;
+		std::vector<EncodeGroup> groups;
+		int groupRows;
+		int height;
+		int level;
+		int stride;
+		int width;
+
+	};
+
+
+	static void user_write_data (png_structp png_ptr, png_bytep data, png_size_t length) {
+
+		WriteBuffer* buffer = (WriteBuffer*)png_get_io_ptr (png_ptr);
+		buffer->Write (data, length);
+
+		if (buffer->failed) {
+
+			png_error (png_ptr, "PNG output is larger than 2 GB");
+
+		}
+
+	}
+
+
+	static void user_flush_data (png_structp png_ptr) {}
+
+
+	static bool encode_detect_alpha (const unsigned char* data, int width, int height, int stride, PixelFormat format) {
+
+		int a = (format == ARGB32) ? 0 : 3;
+
+		for (int y = 0; y < height; y++) {
+
+			const unsigned char* src = data + stride * y + a;
+
+			for (int x = 0; x < width; x++) {
+
+				if (src[x * 4] != 0xFF) {
+
+					return true;
+
+				}
+
+			}
+
+		}
+
+		return false;
+
+	}
+
+
+	static void encode_row (const unsigned char* src, unsigned char* dest, int width, PixelFormat format, int bpp) {
+
+		int r = 0, g = 1, b = 2, a = 3;
+
+		switch (format) {
+
+			case ARGB32: r = 1; g = 2; b = 3; a = 0; break;
+			case BGRA32: r = 2; g = 1; b = 0; a = 3; break;
+			default: break;
+
+		}
+
+		if (bpp == 4) {
+
+			for (int x = 0; x < width; x++) {
+
+				dest[0] = src[r];
+				dest[1] = src[g];
+				dest[2] = src[b];
+				dest[3] = src[a];
+				src += 4;
+				dest += 4;
+
+			}
+
+		} else {
+
+			for (int x = 0; x < width; x++) {
+
+				dest[0] = src[r];
+				dest[1] = src[g];
+				dest[2] = src[b];
+				src += 4;
+				dest += 3;
+
+			}
+
+		}
+
+	}
+
+
+	static void encode_filter (int type, const unsigned char* row, const unsigned char* prior, int rowbytes, int bpp, unsigned char* dest) {
+
+		// prior is a row of zeroes for the first row of the image
+
+		*dest++ = type;
+
+		switch (type) {
+
+			case FILTER_SUB:
+
+				memcpy (dest, row, bpp);
+
+				for (int i = bpp; i < rowbytes; i++) {
+
+					dest[i] = row[i] - row[i - bpp];
+
+				}
+
+				break;
+
+			case FILTER_UP:
+
+				for (int i = 0; i < rowbytes; i++) {
+
+					dest[i] = row[i] - prior[i];
+
+				}
+
+				break;
+
+			case FILTER_AVERAGE:
+
+				for (int i = 0; i < bpp; i++) {
+
+					dest[i] = row[i] - (prior[i] >> 1);
+
+				}
+
+				for (int i = bpp; i < rowbytes; i++) {
+
+					dest[i] = row[i] - ((row[i - bpp] + prior[i]) >> 1);
+
+				}
+
+				break;
+
+			case FILTER_PAETH:
+
+				for (int i = 0; i < bpp; i++) {
+
+					dest[i] = row[i] - prior[i];
+
+				}
+
+				for (int i = bpp; i < rowbytes; i++) {
+
+					int a = row[i - bpp];
+					int b = prior[i];
+					int c = prior[i - bpp];
+					int pa = abs (b - c);
+					int pb = abs (a - c);
+					int pc = abs (a + b - c - c);
+					dest[i] = row[i] - ((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+
+				}
+
+				break;
+
+			default:
+
+				memcpy (dest, row, rowbytes);
+				break;
+
+		}
+
+	}
+
+
+	static int encode_filter_cost (const unsigned char* data, int length) {
+
+		// same heuristic as libpng, the sum of the filtered bytes taken as signed values
+
+		int sum = 0;
+
+		for (int i = 0; i < length; i++) {
+
+			sum += data[i] < 128 ? data[i] : 256 - data[i];
+
+		}
+
+		return sum;
+
+	}
+
+
+	static void encode_filter_row (PNGFilterStrategy filter, const unsigned char* row, const unsigned char* prior, int rowbytes, int bpp, unsigned char* dest, unsigned char* scratch) {
+
+		if (filter != FILTER_ADAPTIVE) {
+
+			encode_filter (filter, row, prior, rowbytes, bpp, dest);
+			return;
+
+		}
+
+		encode_filter (FILTER_NONE, row, prior, rowbytes, bpp, dest);
+		int best = encode_filter_cost (dest + 1, rowbytes);
+
+		for (int type = FILTER_SUB; type <= FILTER_PAETH; type++) {
+
+			encode_filter (type, row, prior, rowbytes, bpp, scratch);
+			int cost = encode_filter_cost (scratch + 1, rowbytes);
+
+			if (cost < best) {
+
+				best = cost;
+				memcpy (dest, scratch, rowbytes + 1);
+
+			}
+
+		}
+
+	}
+
+
+	static void encode_group (int index, void* userData) {
+
+		EncodeJob* job = (EncodeJob*)userData;
+		EncodeGroup* group = &job->groups[index];
+
+		int rowbytes = job->width * job->bpp;
+		int filtered = rowbytes + 1;
+		int start = index * job->groupRows;
+		int end = start + job->groupRows;
+		if (end > job->height) end = job->height;
+		bool last = (index == (int)job->groups.size () - 1);
+
+		// like pigz, each group also filters the rows before it, so that the previous
+		// 32K of the stream can prime the compressor as a preset dictionary
+
+		int dictionaryRows = (32768 + filtered - 1) / filtered;
+		if (dictionaryRows > start) dictionaryRows = start;
+		int first = start - dictionaryRows;
+
+		std::vector<unsigned char> rows ((end - first) * filtered);
+		std::vector<unsigned char> scratch (filtered);
+		std::vector<unsigned char> current (rowbytes);
+		std::vector<unsigned char> prior (rowbytes, 0);
+
+		if (first > 0) {
+
+			encode_row (job->data + job->stride * (first - 1), &prior[0], job->width, job->format, job->bpp);
+
+		}
+
+		for (int y = first; y < end; y++) {
+
+			encode_row (job->data + job->stride * y, &current[0], job->width, job->format, job->bpp);
+			encode_filter_row (job->filter, &current[0], &prior[0], rowbytes, job->bpp, &rows[(y - first) * filtered], &scratch[0]);
+			current.swap (prior);
+
+		}
+
+		const unsigned char* input = &rows[dictionaryRows * filtered];
+		int inputLength = (end - start) * filtered;
+		group->adler = adler32 (adler32 (0, Z_NULL, 0), input, inputLength);
+
+		z_stream stream;
+		memset (&stream, 0, sizeof (stream));
+
+		if (deflateInit2 (&stream, job->level, Z_DEFLATED, -15, 8, job->filter == FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED) != Z_OK) {
+
+			group->failed = true;
+			return;
+
+		}
+
+		if (dictionaryRows > 0) {
+
+			int dictionaryLength = dictionaryRows * filtered;
+			if (dictionaryLength > 32768) dictionaryLength = 32768;
+			deflateSetDictionary (&stream, input - dictionaryLength, dictionaryLength);
+
+		}
+
+		// non-final groups end on a sync flush, which byte-aligns the output without closing the stream
+
+		int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+		group->output.resize (deflateBound (&stream, inputLength) + 16);
+
+		stream.next_in = (Bytef*)input;
+		stream.avail_in = inputLength;
+		stream.next_out = &group->output[0];
+		stream.avail_out = group->output.size ();
+
+		while (true) {
+
+			int ret = deflate (&stream, flush);
+
+			if (ret == Z_STREAM_ERROR || (ret == Z_BUF_ERROR && stream.avail_out > 0)) {
+
+				group->failed = true;
+				break;
+
+			}
+
+			if (last ? (ret == Z_STREAM_END) : (stream.avail_in == 0 && stream.avail_out > 0)) {
+
+				break;
+
+			}
+
+			int used = group->output.size () - stream.avail_out;
+			group->output.resize (group->output.size () * 2);
+			stream.next_out = &group->output[used];
+			stream.avail_out = group->output.size () - used;
+
+		}
+
+		group->output.resize (group->output.size () - stream.avail_out);
+		deflateEnd (&stream);
+
+	}
+
+
+	static void premultiply_alpha_last (png_structp png_ptr, png_row_infop row_info, png_bytep data) {
+
+		png_bytep end = data + row_info->rowbytes;
+		int a, a16;
+
+		for (; data < end; data += 4) {
+
+			a = data[3];
+
+			if (a == 0) {
+
+				data[0] = data[1] = data[2] = 0;
+
+			} else if (a != 0xFF) {
+
+				// matches RGBA::MultiplyAlpha
+				a16 = (a + 1) * 257;
+				data[0] = (data[0] * a16) >> 16;
+				data[1] = (data[1] * a16) >> 16;
+				data[2] = (data[2] * a16) >> 16;
+
+			}
+
+		}
+
+	}
+
+
+	static void premultiply_alpha_first (png_structp png_ptr, png_row_infop row_info, png_bytep data) {
+
+		png_bytep end = data + row_info->rowbytes;
+		int a, a16;
+
+		for (; data < end; data += 4) {
+
+			a = data[0];
+
+			if (a == 0) {
+
+				data[1] = data[2] = data[3] = 0;
+
+			} else if (a != 0xFF) {
+
+				a16 = (a + 1) * 257;
+				data[1] = (data[1] * a16) >> 16;
+				data[2] = (data[2] * a16) >> 16;
+				data[3] = (data[3] * a16) >> 16;
+
+			}
+
+		}
+
+	}
+
+
+	static void stream_info_callback (png_structp png_ptr, png_infop info_ptr) {
+
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)png_get_progressive_ptr (png_ptr);
+		png_uint_32 width, height;
+		int bit_depth, color_type, interlace_type;
+
+		png_get_IHDR (png_ptr, info_ptr, &width, &height, &bit_depth, &color_type, &interlace_type, NULL, NULL);
+
+		png_set_expand (png_ptr);
+		png_set_filler (png_ptr, 0xff, PNG_FILLER_AFTER);
+		png_set_palette_to_rgb (png_ptr);
+		png_set_gray_to_rgb (png_ptr);
+
+		if (bit_depth < 8) {
+
+			png_set_packing (png_ptr);
+
+		} else if (bit_depth == 16) {
+
+			png_set_scale_16 (png_ptr);
+
+		}
+
+		decoder->passes = png_set_interlace_handling (png_ptr);
+		png_read_update_info (png_ptr, info_ptr);
+
+		decoder->buffer->Resize (width, height, 32);
+
+		if (decoder->passes > 1) {
+
+			// interlaced passes are combined into the previous contents of each row
+			memset (decoder->buffer->data->buffer->b, 0, decoder->buffer->data->byteLength);
+
+		}
+
+	}
+
+
+	static void stream_row_callback (png_structp png_ptr, png_bytep new_row, png_uint_32 row_num, int pass) {
+
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)png_get_progressive_ptr (png_ptr);
+
+		decoder->pass = pass;
+
+		if (pass == decoder->passes - 1 && (int)row_num >= decoder->rows) {
+
+			decoder->rows = row_num + 1;
+
+		}
+
+		if (!new_row) return;
+
+		ImageBuffer* buffer = decoder->buffer;
+		png_bytep row = buffer->data->buffer->b + row_num * buffer->Stride ();
+		png_progressive_combine_row (png_ptr, row, new_row);
 
 	}
 
 
-	void user_flush_data (png_structp png_ptr) {}
+	static void stream_end_callback (png_structp png_ptr, png_infop info_ptr) {
+
+		PNGStreamDecoder* decoder = (PNGStreamDecoder*)png_get_progressive_ptr (png_ptr);
+		decoder->complete = true;
+
+	}
 
 
-	bool PNG::Decode (Resource *resource, ImageBuffer *imageBuffer, bool decodeData) {
+	static bool decode_png (Resource *resource, ImageBuffer *imageBuffer, bool decodeData, PixelFormat format, bool premultiplied, bool into, int offset, int stride, int maxWidth, int maxHeight) {
 
 		png_structp png_ptr;
 		png_infop info_ptr;
@@ -88,6 +809,8 @@ namespace lime {
 
 		FILE_HANDLE* file = NULL;
 		Bytes* data = NULL;
+		ReadBuffer buffer (NULL, 0);
+		AreaDownscaler* volatile scaler = NULL;
 
 		if (resource->path) {
 
@@ -133,6 +856,7 @@ namespace lime {
 
 			png_destroy_read_struct (&png_ptr, &info_ptr, (png_infopp)NULL);
 			if (file) lime::fclose (file);
+			if (scaler) delete scaler;
 			return false;
 
 		}
@@ -148,14 +872,14 @@ namespace lime {
 
 				data = new Bytes ();
 				data->ReadFile (resource->path);
-				ReadBuffer buffer (data->b, data->length);
+				buffer = ReadBuffer (data->b, data->length);
 				png_set_read_fn (png_ptr, &buffer, user_read_data_fn);
 
 			}
 
 		} else {
 
-			ReadBuffer buffer (resource->data->b, resource->data->length);
+			buffer = ReadBuffer (resource->data->b, resource->data->length);
 			png_set_read_fn (png_ptr, &buffer, user_read_data_fn);
 
 		}
@@ -163,13 +887,28 @@ namespace lime {
 		png_read_info (png_ptr, info_ptr);
 		png_get_IHDR (png_ptr, info_ptr, &width, &height, &bit_depth, &color_type, &interlace_type, NULL, NULL);
 
+		int outWidth, outHeight;
+		fit_size (width, height, maxWidth, maxHeight, &outWidth, &outHeight);
+		bool scale = (outWidth != (int)width || outHeight != (int)height);
+
+		if (into && !ImageBuffer::CheckBounds (imageBuffer->data, offset, stride, outWidth, outHeight)) {
+
+			png_destroy_read_struct (&png_ptr, &info_ptr, (png_infopp)NULL);
+			if (file) lime::fclose (file);
+			if (data) delete data;
+			return false;
+
+		}
+
 		if (decodeData) {
 
-			//bool has_alpha = (color_type == PNG_COLOR_TYPE_GRAY_ALPHA || color_type == PNG_COLOR_TYPE_RGB_ALPHA || png_get_valid (png_ptr, info_ptr, PNG_INFO_tRNS));
+			bool has_alpha = (color_type == PNG_COLOR_TYPE_GRAY_ALPHA || color_type == PNG_COLOR_TYPE_RGB_ALPHA || png_get_valid (png_ptr, info_ptr, PNG_INFO_tRNS));
 
 			png_set_expand (png_ptr);
 
-			png_set_filler (png_ptr, 0xff, PNG_FILLER_AFTER);
+			// libpng adds the filler before it swaps alpha, and the swap only applies to rows that
+			// already had alpha, so opaque images need the filler placed first for ARGB directly
+			png_set_filler (png_ptr, 0xff, (format == ARGB32 && !scale) ? PNG_FILLER_BEFORE : PNG_FILLER_AFTER);
 			//png_set_gray_1_2_4_to_8 (png_ptr);
 			png_set_palette_to_rgb (png_ptr);
 			png_set_gray_to_rgb (png_ptr);
@@ -184,21 +923,98 @@ namespace lime {
 
 			}
 
-			//png_set_bgr (png_ptr);
+			// channel order and premultiplication are applied by libpng as each row is
+			// unfiltered, instead of as extra passes over the finished image. When
+			// downscaling, libpng hands over straight RGBA and the scaler converts
+
+			if (!scale) {
+
+				if (format == BGRA32) {
+
+					png_set_bgr (png_ptr);
+
+				} else if (format == ARGB32) {
+
+					png_set_swap_alpha (png_ptr);
+
+				}
+
+				if (premultiplied && has_alpha) {
+
+					png_set_read_user_transform_fn (png_ptr, format == ARGB32 ? premultiply_alpha_first : premultiply_alpha_last);
+
+				}
+
+			}
+
+			unsigned char *bytes;
+
+			if (into) {
+
+				bytes = imageBuffer->data->buffer->b + offset;
+				imageBuffer->width = outWidth;
+				imageBuffer->height = outHeight;
+				imageBuffer->bitsPerPixel = 32;
+
+			} else {
+
+				imageBuffer->Resize (outWidth, outHeight, 32);
+				bytes = imageBuffer->data->buffer->b;
+				stride = imageBuffer->Stride ();
 
-			imageBuffer->Resize (width, height, 32);
+			}
 
-			const unsigned int stride = imageBuffer->Stride ();
-			unsigned char *bytes = imageBuffer->data->buffer->b;
+			imageBuffer->format = format;
+			imageBuffer->premultiplied = premultiplied;
 
 			int number_of_passes = png_set_interlace_handling (png_ptr);
 
-			for (int pass = 0; pass < number_of_passes; pass++) {
+			if (scale) {
+
+				// only a few source rows are held at once, except for interlaced images,
+				// where later passes fill in earlier rows and the full image is needed
+
+				scaler = new AreaDownscaler (width, height, outWidth, outHeight, bytes, stride, format, premultiplied);
+				int rows = (number_of_passes > 1) ? height : 1;
+				scaler->rows.resize ((size_t)width * 4 * rows);
+				unsigned char* source = &scaler->rows[0];
+
+				for (int pass = 0; pass < number_of_passes; pass++) {
+
+					for (png_uint_32 i = 0; i < height; i++) {
+
+						png_bytep anAddr = (png_bytep)(source + (rows > 1 ? (size_t)i * width * 4 : 0));
+						png_read_rows (png_ptr, (png_bytepp) &anAddr, NULL, 1);
+
+						if (rows == 1) scaler->PushRow (source);
+
+					}
+
+				}
+
+				if (rows > 1) {
+
+					for (png_uint_32 i = 0; i < height; i++) {
+
+						scaler->PushRow (source + (size_t)i * width * 4);
+
+					}
+
+				}
+
+				delete scaler;
+				scaler = NULL;
+
+			} else {
+
+				for (int pass = 0; pass < number_of_passes; pass++) {
 
-				for (int i = 0; i < height; i++) {
+					for (png_uint_32 i = 0; i < height; i++) {
 
-					png_bytep anAddr = (png_bytep)(bytes + i * stride);
-					png_read_rows (png_ptr, (png_bytepp) &anAddr, NULL, 1);
+						png_bytep anAddr = (png_bytep)(bytes + i * stride);
+						png_read_rows (png_ptr, (png_bytepp) &anAddr, NULL, 1);
+
+					}
 
 				}
 
@@ -208,8 +1024,8 @@ namespace lime {
 
 		} else {
 
-			imageBuffer->width = width;
-			imageBuffer->height = height;
+			imageBuffer->width = outWidth;
+			imageBuffer->height = outHeight;
 
 		}
 
@@ -223,7 +1039,142 @@ namespace lime {
 	}
 
 
-	bool PNG::Encode (ImageBuffer *imageBuffer, Bytes* bytes) {
+	bool PNG::Decode (Resource *resource, ImageBuffer *imageBuffer, bool decodeData, PixelFormat format, bool premultiplied, int maxWidth, int maxHeight) {
+
+		return decode_png (resource, imageBuffer, decodeData, format, premultiplied, false, 0, 0, maxWidth, maxHeight);
+
+	}
+
+
+	bool PNG::DecodeInto (Resource *resource, ImageBuffer *imageBuffer, int offset, int stride, PixelFormat format, bool premultiplied, int maxWidth, int maxHeight) {
+
+		return decode_png (resource, imageBuffer, true, format, premultiplied, true, offset, stride, maxWidth, maxHeight);
+
+	}
+
+
+	bool PNG::Encode (ImageBuffer *imageBuffer, Bytes* bytes, int compression, PNGFilterStrategy filter, bool detectAlpha, int numThreads) {
+
+		int w = imageBuffer->width;
+		int h = imageBuffer->height;
+
+		if (w <= 0 || h <= 0 || !imageBuffer->data || !imageBuffer->data->buffer->b) {
+
+			return false;
+
+		}
+
+		PixelFormat format = imageBuffer->format;
+		unsigned char* imageData = imageBuffer->data->buffer->b;
+		int stride = imageBuffer->Stride ();
+
+		bool do_alpha = !detectAlpha || encode_detect_alpha (imageData, w, h, stride, format);
+		int bpp = do_alpha ? 4 : 3;
+		int level = (compression < 0 || compression > 9) ? Z_DEFAULT_COMPRESSION : compression;
+
+		if (numThreads <= 0) {
+
+			numThreads = Parallel::GetConcurrency ();
+
+		}
+
+		WriteBuffer out_buffer (bytes);
+
+		if (numThreads > 1) {
+
+			EncodeJob job;
+			job.bpp = bpp;
+			job.data = imageData;
+			job.filter = filter;
+			job.format = format;
+			job.groupRows = 262144 / (w * bpp + 1);
+			if (job.groupRows < 1) job.groupRows = 1;
+			job.height = h;
+			job.level = level;
+			job.stride = stride;
+			job.width = w;
+			job.groups.resize ((h + job.groupRows - 1) / job.groupRows);
+
+			Parallel::For (job.groups.size (), numThreads, encode_group, &job);
+
+			size_t size = 8 + 25 + 12;
+			uLong adler = adler32 (0, Z_NULL, 0);
+
+			for (size_t i = 0; i < job.groups.size (); i++) {
+
+				EncodeGroup* group = &job.groups[i];
+
+				if (group->failed) {
+
+					return false;
+
+				}
+
+				size += group->output.size () + 12;
+				adler = adler32_combine (adler, group->adler, (z_off_t)((i == job.groups.size () - 1 ? h - i * job.groupRows : job.groupRows) * (w * bpp + 1)));
+
+			}
+
+			out_buffer.Reserve (size + 6);
+
+			static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+			out_buffer.Write (signature, 8);
+
+			int chunk = out_buffer.BeginChunk ("IHDR");
+			out_buffer.WriteInt (w);
+			out_buffer.WriteInt (h);
+			unsigned char header[5] = { 8, (unsigned char)(do_alpha ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB), PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE, PNG_INTERLACE_NONE };
+			out_buffer.Write (header, 5);
+			out_buffer.EndChunk (chunk);
+
+			// the groups are raw deflate streams, wrap them into a single zlib stream
+
+			int flevel = (level < 0) ? 2 : (level < 2) ? 0 : (level < 6) ? 1 : (level == 6) ? 2 : 3;
+			int zlibHeader = (0x78 << 8) | (flevel << 6);
+			zlibHeader += 31 - (zlibHeader % 31);
+
+			for (size_t i = 0; i < job.groups.size (); i++) {
+
+				EncodeGroup* group = &job.groups[i];
+				chunk = out_buffer.BeginChunk ("IDAT");
+
+				if (i == 0) {
+
+					unsigned char cmf[2] = { (unsigned char)(zlibHeader >> 8), (unsigned char)zlibHeader };
+					out_buffer.Write (cmf, 2);
+
+				}
+
+				if (group->output.size () > 0) {
+
+					out_buffer.Write (&group->output[0], group->output.size ());
+
+				}
+
+				if (i == job.groups.size () - 1) {
+
+					out_buffer.WriteInt (adler);
+
+				}
+
+				out_buffer.EndChunk (chunk);
+
+			}
+
+			chunk = out_buffer.BeginChunk ("IEND");
+			out_buffer.EndChunk (chunk);
+
+			if (out_buffer.failed) {
+
+				return false;
+
+			}
+
+			bytes->Resize (out_buffer.length);
+
+			return true;
+
+		}
 
 		png_structp png_ptr = png_create_write_struct (PNG_LIBPNG_VER_STRING, NULL, user_error_fn, user_warning_fn);
 
@@ -243,6 +1194,8 @@ namespace lime {
 
 		}
 
+		QuickVec<unsigned char> row_data (w * 4);
+
 		if (setjmp (png_jmpbuf (png_ptr))) {
 
 			png_destroy_write_struct (&png_ptr, &info_ptr);
@@ -250,73 +1203,155 @@ namespace lime {
 
 		}
 
-		QuickVec<unsigned char> out_buffer;
+		// libpng writes straight into the destination, growing it geometrically
 
+		out_buffer.Reserve (std::min (((size_t)w * h * bpp) / 4 + 1024, (size_t)INT_MAX));
 		png_set_write_fn (png_ptr, &out_buffer, user_write_data, user_flush_data);
 
-		int w = imageBuffer->width;
-		int h = imageBuffer->height;
-
 		int bit_depth = 8;
-		//int color_type = (inSurface->Format () & pfHasAlpha) ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB;
-		int color_type = PNG_COLOR_TYPE_RGB_ALPHA;
+		int color_type = do_alpha ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB;
 		png_set_IHDR (png_ptr, info_ptr, w, h, bit_depth, color_type, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
 
-		png_write_info (png_ptr, info_ptr);
+		if (compression >= 0) {
 
-		bool do_alpha = (color_type == PNG_COLOR_TYPE_RGBA);
-		unsigned char* imageData = imageBuffer->data->buffer->b;
-		int stride = imageBuffer->Stride ();
+			png_set_compression_level (png_ptr, level);
 
-		{
-			QuickVec<unsigned char> row_data (w * 4);
-			png_bytep row = &row_data[0];
+		}
 
-			for (int y = 0; y < h; y++) {
+		switch (filter) {
 
-				unsigned char *buf = &row_data[0];
-				const unsigned char *src = (const unsigned char *)(imageData + (stride * y));
+			case FILTER_NONE: png_set_filter (png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE); break;
+			case FILTER_SUB: png_set_filter (png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB); break;
+			case FILTER_UP: png_set_filter (png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_UP); break;
+			case FILTER_AVERAGE: png_set_filter (png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_AVG); break;
+			case FILTER_PAETH: png_set_filter (png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_PAETH); break;
+			default: png_set_filter (png_ptr, PNG_FILTER_TYPE_BASE, PNG_ALL_FILTERS); break;
 
-				for (int x = 0; x < w; x++) {
+		}
 
-					buf[0] = src[0];
-					buf[1] = src[1];
-					buf[2] = src[2];
-					src += 3;
-					buf += 3;
+		png_write_info (png_ptr, info_ptr);
 
-					if (do_alpha) {
+		for (int y = 0; y < h; y++) {
 
-						*buf++ = *src;
+			const unsigned char *src = (const unsigned char *)(imageData + (stride * y));
 
-					}
+			if (do_alpha && format == RGBA32) {
 
-					src++;
+				// libpng copies each row internally, so RGBA rows need no staging copy
+				png_write_row (png_ptr, src);
 
-				}
+			} else {
 
-				png_write_rows (png_ptr, &row, 1);
+				encode_row (src, &row_data[0], w, format, bpp);
+				png_write_row (png_ptr, &row_data[0]);
 
 			}
 
 		}
 
 		png_write_end (png_ptr, NULL);
+		png_destroy_write_struct (&png_ptr, &info_ptr);
+
+		bytes->Resize (out_buffer.length);
 
-		int size = out_buffer.size ();
+		return true;
+
+	}
+
+
+	PNGStreamDecoder::PNGStreamDecoder () {
+
+		buffer = new ImageBuffer (alloc_null ());
+		buffer->data = new ArrayBufferView (alloc_null ());
+		complete = false;
+		error = false;
+		pass = 0;
+		passes = 1;
+		rows = 0;
+
+		png_structp _png_ptr = png_create_read_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+		png_infop _info_ptr = _png_ptr ? png_create_info_struct (_png_ptr) : NULL;
+
+		if (!_info_ptr) {
 
-		if (size > 0) {
+			if (_png_ptr) png_destroy_read_struct (&_png_ptr, NULL, NULL);
+			error = true;
 
-			bytes->Resize (size);
-			memcpy (bytes->b, &out_buffer[0], size);
+		} else {
+
+			png_set_progressive_read_fn (_png_ptr, this, stream_info_callback, stream_row_callback, stream_end_callback);
 
 		}
 
-		png_destroy_write_struct (&png_ptr, &info_ptr);
+		png_ptr = _png_ptr;
+		info_ptr = _info_ptr;
+
+	}
+
+
+	PNGStreamDecoder::~PNGStreamDecoder () {
+
+		if (png_ptr) {
 
+			png_structp _png_ptr = (png_structp)png_ptr;
+			png_infop _info_ptr = (png_infop)info_ptr;
+			png_destroy_read_struct (&_png_ptr, &_info_ptr, NULL);
+
+		}
+
+		buffer->data->buffer->Resize (0);
+		delete buffer;
+
+	}
+
+
+	bool PNGStreamDecoder::Append (const unsigned char* data, int length) {
+
+		if (error) return false;
+		if (complete || length <= 0) return true;
+
+		png_structp _png_ptr = (png_structp)png_ptr;
+
+		if (setjmp (png_jmpbuf (_png_ptr))) {
+
+			// libpng cannot resume after an error, the decoder stays failed
+			error = true;
+			return false;
+
+		}
+
+		png_process_data (_png_ptr, (png_infop)info_ptr, (png_bytep)data, length);
 		return true;
 
 	}
 
 
+	float PNGStreamDecoder::GetProgress () {
+
+		if (complete) return 1.0;
+
+		int height = buffer->height;
+		if (height <= 0) return 0.0;
+
+		if (passes > 1) {
+
+			// Adam7 passes are not equal in size, this is only a rough estimate
+			return (float)pass / passes;
+
+		}
+
+		return (float)rows / height;
+
+	}
+
+
+	int PNGStreamDecoder::GetRows () {
+
+		// interlaced rows keep changing until the last pass reaches them
+
+		return rows;
+
+	}
+
+
 }
\ No newline at end of file
@@ -0,0 +1,476 @@
+#include <graphics/format/QOI.h>
+#include <system/System.h>
+
+
+// "Quite OK Image" format, see https://qoiformat.org/qoi-specification.pdf
+
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+#define QOI_MASK 0xC0
+
+#define QOI_HASH(r, g, b, a) (((r) * 3 + (g) * 5 + (b) * 7 + (a) * 11) & 63)
+
+
+namespace lime {
+
+
+	static const unsigned char qoi_padding[QOI_PADDING_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+
+	static void qoi_channel_offsets (PixelFormat format, int* r, int* g, int* b, int* a) {
+
+		switch (format) {
+
+			case ARGB32: *r = 1; *g = 2; *b = 3; *a = 0; break;
+			case BGRA32: *r = 2; *g = 1; *b = 0; *a = 3; break;
+			default: *r = 0; *g = 1; *b = 2; *a = 3; break;
+
+		}
+
+	}
+
+
+	static unsigned int qoi_read_int (const unsigned char* data) {
+
+		return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+
+	}
+
+
+	static void qoi_write_int (unsigned char* data, unsigned int value) {
+
+		data[0] = value >> 24;
+		data[1] = value >> 16;
+		data[2] = value >> 8;
+		data[3] = value;
+
+	}
+
+
+	static bool decode_qoi (Resource *resource, ImageBuffer* imageBuffer, bool decodeData, PixelFormat format, bool premultiplied, bool into, int offset, int stride) {
+
+		unsigned char header[QOI_HEADER_SIZE];
+		const unsigned char* bytes = NULL;
+		int length = 0;
+		Bytes* data = NULL;
+
+		if (resource->path) {
+
+			if (decodeData) {
+
+				data = new Bytes ();
+				data->ReadFile (resource->path);
+				bytes = data->b;
+				length = data->length;
+
+			} else {
+
+				FILE_HANDLE* file = lime::fopen (resource->path, "rb");
+
+				if (!file) {
+
+					return false;
+
+				}
+
+				length = lime::fread (header, 1, QOI_HEADER_SIZE, file);
+				lime::fclose (file);
+				bytes = header;
+
+			}
+
+		} else {
+
+			bytes = resource->data->b;
+			length = resource->data->length;
+
+		}
+
+		bool decoded = false;
+
+		if (bytes && length >= QOI_HEADER_SIZE && bytes[0] == 'q' && bytes[1] == 'o' && bytes[2] == 'i' && bytes[3] == 'f') {
+
+			unsigned int width = qoi_read_int (bytes + 4);
+			unsigned int height = qoi_read_int (bytes + 8);
+			int channels = bytes[12];
+			int colorspace = bytes[13];
+
+			bool valid = (width > 0 && height > 0 && (channels == 3 || channels == 4) && colorspace <= 1 && (double)width * height * 4 < 0x7FFFFFFF);
+
+			if (valid && into && !ImageBuffer::CheckBounds (imageBuffer->data, offset, stride, width, height)) {
+
+				valid = false;
+
+			}
+
+			if (valid && !decodeData) {
+
+				imageBuffer->width = width;
+				imageBuffer->height = height;
+				decoded = true;
+
+			} else if (valid && length >= QOI_HEADER_SIZE + QOI_PADDING_SIZE) {
+
+				unsigned char* pixels;
+
+				if (into) {
+
+					pixels = imageBuffer->data->buffer->b + offset;
+					imageBuffer->width = width;
+					imageBuffer->height = height;
+					imageBuffer->bitsPerPixel = 32;
+
+				} else {
+
+					imageBuffer->Resize (width, height, 32);
+					pixels = imageBuffer->data->buffer->b;
+					stride = imageBuffer->Stride ();
+
+				}
+
+				imageBuffer->format = format;
+				imageBuffer->premultiplied = premultiplied;
+
+				int ro, go, bo, ao;
+				qoi_channel_offsets (format, &ro, &go, &bo, &ao);
+
+				unsigned char index[64 * 4];
+				memset (index, 0, sizeof (index));
+
+				unsigned char r = 0, g = 0, b = 0, a = 0xFF;
+				int run = 0;
+
+				// every chunk is at most 5 bytes, and the padding keeps multi-byte reads in range
+				const unsigned char* p = bytes + QOI_HEADER_SIZE;
+				const unsigned char* end = bytes + length - QOI_PADDING_SIZE;
+
+				for (unsigned int y = 0; y < height; y++) {
+
+					unsigned char* out = pixels + y * stride;
+					unsigned char* const rowEnd = out + width * 4;
+
+					for (; out < rowEnd; out += 4) {
+
+						if (run > 0) {
+
+							run--;
+
+						} else if (p < end) {
+
+							int b1 = *p++;
+
+							if (b1 == QOI_OP_RGB) {
+
+								r = p[0];
+								g = p[1];
+								b = p[2];
+								p += 3;
+
+							} else if (b1 == QOI_OP_RGBA) {
+
+								r = p[0];
+								g = p[1];
+								b = p[2];
+								a = p[3];
+								p += 4;
+
+							} else {
+
+								switch (b1 & QOI_MASK) {
+
+									case QOI_OP_INDEX: {
+
+										const unsigned char* entry = index + b1 * 4;
+										r = entry[0];
+										g = entry[1];
+										b = entry[2];
+										a = entry[3];
+										break;
+
+									}
+
+									case QOI_OP_DIFF:
+
+										r += ((b1 >> 4) & 0x03) - 2;
+										g += ((b1 >> 2) & 0x03) - 2;
+										b += (b1 & 0x03) - 2;
+										break;
+
+									case QOI_OP_LUMA: {
+
+										int b2 = *p++;
+										int vg = (b1 & 0x3F) - 32;
+										r += vg - 8 + ((b2 >> 4) & 0x0F);
+										g += vg;
+										b += vg - 8 + (b2 & 0x0F);
+										break;
+
+									}
+
+									default:
+
+										run = (b1 & 0x3F);
+										break;
+
+								}
+
+							}
+
+							unsigned char* entry = index + QOI_HASH (r, g, b, a) * 4;
+							entry[0] = r;
+							entry[1] = g;
+							entry[2] = b;
+							entry[3] = a;
+
+						}
+
+						if (premultiplied && a != 0xFF) {
+
+							if (a == 0) {
+
+								out[ro] = out[go] = out[bo] = 0;
+
+							} else {
+
+								// matches RGBA::MultiplyAlpha
+								int a16 = (a + 1) * 257;
+								out[ro] = (r * a16) >> 16;
+								out[go] = (g * a16) >> 16;
+								out[bo] = (b * a16) >> 16;
+
+							}
+
+						} else {
+
+							out[ro] = r;
+							out[go] = g;
+							out[bo] = b;
+
+						}
+
+						out[ao] = a;
+
+					}
+
+				}
+
+				decoded = true;
+
+			}
+
+		}
+
+		if (data) {
+
+			data->Resize (0);
+			delete data;
+
+		}
+
+		return decoded;
+
+	}
+
+
+	bool QOI::Decode (Resource *resource, ImageBuffer* imageBuffer, bool decodeData, PixelFormat format, bool premultiplied) {
+
+		return decode_qoi (resource, imageBuffer, decodeData, format, premultiplied, false, 0, 0);
+
+	}
+
+
+	bool QOI::DecodeInto (Resource *resource, ImageBuffer* imageBuffer, int offset, int stride, PixelFormat format, bool premultiplied) {
+
+		return decode_qoi (resource, imageBuffer, true, format, premultiplied, true, offset, stride);
+
+	}
+
+
+	bool QOI::Encode (ImageBuffer *imageBuffer, Bytes* bytes) {
+
+		int width = imageBuffer->width;
+		int height = imageBuffer->height;
+
+		if (width <= 0 || height <= 0 || !imageBuffer->data || !imageBuffer->data->buffer->b || (double)width * height * 5 + QOI_HEADER_SIZE + QOI_PADDING_SIZE >= 0x7FFFFFFF) {
+
+			return false;
+
+		}
+
+		int ro, go, bo, ao;
+		qoi_channel_offsets (imageBuffer->format, &ro, &go, &bo, &ao);
+
+		bool premultiplied = imageBuffer->premultiplied;
+		int stride = imageBuffer->Stride ();
+		const unsigned char* imageData = imageBuffer->data->buffer->b;
+
+		// worst case is a 5 byte chunk per pixel, the output grows a row at a time instead
+
+		int rowLimit = width * 5;
+		int capacity = QOI_HEADER_SIZE + width * height + rowLimit + QOI_PADDING_SIZE;
+		bytes->Resize (capacity);
+
+		unsigned char* out = bytes->b;
+		memcpy (out, "qoif", 4);
+		qoi_write_int (out + 4, width);
+		qoi_write_int (out + 8, height);
+		out[12] = 4;
+		out[13] = 0;
+		int position = QOI_HEADER_SIZE;
+
+		unsigned char index[64 * 4];
+		memset (index, 0, sizeof (index));
+
+		unsigned char pr = 0, pg = 0, pb = 0, pa = 0xFF;
+		unsigned char r, g, b, a;
+		bool opaque = true;
+		int run = 0;
+
+		for (int y = 0; y < height; y++) {
+
+			if (position + rowLimit + QOI_PADDING_SIZE > capacity) {
+
+				while (position + rowLimit + QOI_PADDING_SIZE > capacity) {
+
+					capacity *= 2;
+
+				}
+
+				bytes->Resize (capacity);
+				out = bytes->b;
+
+			}
+
+			const unsigned char* src = imageData + stride * y;
+			bool lastRow = (y == height - 1);
+
+			for (int x = 0; x < width; x++, src += 4) {
+
+				r = src[ro];
+				g = src[go];
+				b = src[bo];
+				a = src[ao];
+
+				if (a != 0xFF) {
+
+					opaque = false;
+
+					if (premultiplied && a != 0) {
+
+						// smallest straight value that premultiplies back to the stored one,
+						// so that a premultiplied decode reproduces the buffer exactly
+
+						int a16 = (a + 1) * 257;
+						int v;
+						v = ((r << 16) + a16 - 1) / a16; r = v > 0xFF ? 0xFF : v;
+						v = ((g << 16) + a16 - 1) / a16; g = v > 0xFF ? 0xFF : v;
+						v = ((b << 16) + a16 - 1) / a16; b = v > 0xFF ? 0xFF : v;
+
+					}
+
+				}
+
+				if (r == pr && g == pg && b == pb && a == pa) {
+
+					run++;
+
+					if (run == 62 || (lastRow && x == width - 1)) {
+
+						out[position++] = QOI_OP_RUN | (run - 1);
+						run = 0;
+
+					}
+
+					continue;
+
+				}
+
+				if (run > 0) {
+
+					out[position++] = QOI_OP_RUN | (run - 1);
+					run = 0;
+
+				}
+
+				int hash = QOI_HASH (r, g, b, a);
+				unsigned char* entry = index + hash * 4;
+
+				if (entry[0] == r && entry[1] == g && entry[2] == b && entry[3] == a) {
+
+					out[position++] = QOI_OP_INDEX | hash;
+
+				} else {
+
+					entry[0] = r;
+					entry[1] = g;
+					entry[2] = b;
+					entry[3] = a;
+
+					if (a == pa) {
+
+						signed char vr = r - pr;
+						signed char vg = g - pg;
+						signed char vb = b - pb;
+						signed char vg_r = vr - vg;
+						signed char vg_b = vb - vg;
+
+						if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+
+							out[position++] = QOI_OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2);
+
+						} else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+
+							out[position++] = QOI_OP_LUMA | (vg + 32);
+							out[position++] = ((vg_r + 8) << 4) | (vg_b + 8);
+
+						} else {
+
+							out[position++] = QOI_OP_RGB;
+							out[position++] = r;
+							out[position++] = g;
+							out[position++] = b;
+
+						}
+
+					} else {
+
+						out[position++] = QOI_OP_RGBA;
+						out[position++] = r;
+						out[position++] = g;
+						out[position++] = b;
+						out[position++] = a;
+
+					}
+
+				}
+
+				pr = r;
+				pg = g;
+				pb = b;
+				pa = a;
+
+			}
+
+		}
+
+		memcpy (out + position, qoi_padding, QOI_PADDING_SIZE);
+		position += QOI_PADDING_SIZE;
+
+		// the channel count is informative only, so it can be settled after the scan
+		if (opaque) out[12] = 3;
+
+		bytes->Resize (position);
+
+		return true;
+
+	}
+
+
+}
\ No newline at end of file
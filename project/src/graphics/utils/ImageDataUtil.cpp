@@ -1,16 +1,941 @@
 #include <graphics/utils/ImageDataUtil.h>
 #include <math/color/RGBA.h>
+#include <system/Parallel.h>
 #include <utils/QuickVec.h>
+#include <float.h>
 #include <math.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 namespace lime {
 
 
-	unsigned char alphaTable[256];
-	unsigned char redTable[256];
-	unsigned char greenTable[256];
-	unsigned char blueTable[256];
+	unsigned char alphaTable[256];
+	unsigned char redTable[256];
+	unsigned char greenTable[256];
+	unsigned char blueTable[256];
+
+	// sRGB <-> linear light, 8-bit sRGB to 16-bit linear, and back through a 12-bit index
+
+	static uint16_t linearTable[256];
+	static uint8_t sRGBTable[4096];
+
+
+	static int initLinearTables () {
+
+		for (int i = 0; i < 256; i++) {
+
+			double c = i / 255.0;
+			double l = (c <= 0.04045) ? c / 12.92 : pow ((c + 0.055) / 1.055, 2.4);
+			linearTable[i] = (uint16_t)(l * 65535.0 + 0.5);
+
+		}
+
+		for (int i = 0; i < 4096; i++) {
+
+			double l = (i * 16 + 7.5) / 65535.0;
+			double c = (l <= 0.0031308) ? l * 12.92 : 1.055 * pow (l, 1.0 / 2.4) - 0.055;
+			sRGBTable[i] = (uint8_t)(c * 255.0 + 0.5);
+
+		}
+
+		// every 8-bit value lands in its own bucket, pin those so an unblended pixel round-trips exactly
+
+		for (int i = 0; i < 256; i++) {
+
+			sRGBTable[linearTable[i] >> 4] = i;
+
+		}
+
+		return 0;
+
+	}
+
+	static int initLinearTables_ = initLinearTables ();
+
+
+	static inline uint8_t linear_to_srgb (float value) {
+
+		int index = int (value) >> 4;
+		return sRGBTable[index > 4095 ? 4095 : index];
+
+	}
+
+
+	static void resize_linear (const uint8_t* data, int imageWidth, int imageHeight, uint8_t* newData, int newWidth, int newHeight, PixelFormat format) {
+
+		// same sampling and alpha rule as the sRGB path, but colour is interpolated in linear light.
+		// Weights are 12-bit fixed point and each source row is filtered horizontally only once,
+		// the vertical pass then blends two cached integer rows
+
+		int alphaOffset = (format == ARGB32) ? 0 : 3;
+		int rowLength = newWidth * 4;
+
+		std::vector<int> columns (newWidth * 2);
+		std::vector<uint32_t> columnWeights (newWidth);
+
+		for (int x = 0; x < newWidth; x++) {
+
+			float u = ((x + 0.5) / newWidth) * imageWidth - 0.5;
+			if (u < 0) u = 0;
+
+			int sourceX = int (u);
+			columns[x * 2] = sourceX * 4;
+			columns[x * 2 + 1] = (sourceX < imageWidth - 1) ? (sourceX + 1) * 4 : sourceX * 4;
+			columnWeights[x] = uint32_t ((u - sourceX) * 4096 + 0.5);
+
+		}
+
+		std::vector<uint32_t> rows (rowLength * 2);
+		uint32_t* top = &rows[0];
+		uint32_t* bottom = &rows[rowLength];
+		int topY = -1, bottomY = -1;
+
+		for (int y = 0; y < newHeight; y++) {
+
+			float v = ((y + 0.5) / newHeight) * imageHeight - 0.5;
+			if (v < 0) v = 0;
+
+			int sourceY = int (v);
+			int sourceY1 = (sourceY < imageHeight - 1) ? sourceY + 1 : sourceY;
+			uint32_t rowWeight = uint32_t ((v - sourceY) * 4096 + 0.5);
+
+			if (sourceY == bottomY) {
+
+				uint32_t* swap = top;
+				top = bottom;
+				bottom = swap;
+				topY = bottomY;
+				bottomY = -1;
+
+			}
+
+			for (int i = 0; i < 2; i++) {
+
+				int rowY = (i == 0) ? sourceY : sourceY1;
+				uint32_t* row = (i == 0) ? top : bottom;
+
+				if ((i == 0 ? topY : bottomY) == rowY) continue;
+
+				const uint8_t* source = data + rowY * imageWidth * 4;
+
+				for (int x = 0; x < newWidth; x++) {
+
+					const uint8_t* left = source + columns[x * 2];
+					const uint8_t* right = source + columns[x * 2 + 1];
+					uint32_t weight = columnWeights[x];
+					uint32_t opposite = 4096 - weight;
+
+					for (int c = 0; c < 4; c++) {
+
+						row[x * 4 + c] = (linearTable[left[c]] * opposite + linearTable[right[c]] * weight + 128) >> 8;
+
+					}
+
+				}
+
+				if (i == 0) topY = rowY; else bottomY = rowY;
+
+			}
+
+			uint8_t* dest = newData + y * rowLength;
+			uint32_t rowOpposite = 4096 - rowWeight;
+
+			for (int i = 0; i < rowLength; i++) {
+
+				dest[i] = sRGBTable[(top[i] * rowOpposite + bottom[i] * rowWeight) >> 20];
+
+			}
+
+			const uint8_t* source = data + sourceY * imageWidth * 4;
+			const uint8_t* sourceBelow = data + sourceY1 * imageWidth * 4;
+
+			for (int x = 0; x < newWidth; x++) {
+
+				int index = columns[x * 2];
+				int indexX = columns[x * 2 + 1];
+
+				if (source[indexX + alphaOffset] == 0 || sourceBelow[index + alphaOffset] == 0 || sourceBelow[indexX + alphaOffset] == 0) {
+
+					dest[x * 4 + alphaOffset] = 0;
+
+				} else {
+
+					dest[x * 4 + alphaOffset] = source[index + alphaOffset];
+
+				}
+
+			}
+
+		}
+
+	}
+
+
+	// streaming XXH64, rows are fed one at a time so padding between them is never hashed
+
+	static const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+	static const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+	static const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+	static const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+	static const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+
+	struct HashState {
+
+		uint64_t v[4];
+		uint64_t length;
+		uint8_t memory[32];
+		int memorySize;
+		uint64_t seed;
+
+	};
+
+
+	static inline uint64_t xxh_rotl (uint64_t value, int bits) {
+
+		return (value << bits) | (value >> (64 - bits));
+
+	}
+
+
+	static inline uint64_t xxh_read64 (const uint8_t* data) {
+
+		uint64_t value;
+		memcpy (&value, data, 8);
+		return value;
+
+	}
+
+
+	static inline uint64_t xxh_round (uint64_t acc, uint64_t input) {
+
+		acc += input * XXH_PRIME64_2;
+		acc = xxh_rotl (acc, 31);
+		return acc * XXH_PRIME64_1;
+
+	}
+
+
+	static inline uint64_t xxh_merge_round (uint64_t acc, uint64_t value) {
+
+		acc ^= xxh_round (0, value);
+		return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+
+	}
+
+
+	static void hash_init (HashState* state, uint64_t seed) {
+
+		state->v[0] = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+		state->v[1] = seed + XXH_PRIME64_2;
+		state->v[2] = seed;
+		state->v[3] = seed - XXH_PRIME64_1;
+		state->length = 0;
+		state->memorySize = 0;
+		state->seed = seed;
+
+	}
+
+
+	static void hash_update (HashState* state, const uint8_t* data, size_t length) {
+
+		const uint8_t* end = data + length;
+		state->length += length;
+
+		if (state->memorySize + length < 32) {
+
+			memcpy (state->memory + state->memorySize, data, length);
+			state->memorySize += length;
+			return;
+
+		}
+
+		if (state->memorySize > 0) {
+
+			int fill = 32 - state->memorySize;
+			memcpy (state->memory + state->memorySize, data, fill);
+			data += fill;
+
+			for (int i = 0; i < 4; i++) {
+
+				state->v[i] = xxh_round (state->v[i], xxh_read64 (state->memory + i * 8));
+
+			}
+
+			state->memorySize = 0;
+
+		}
+
+		uint64_t v0 = state->v[0], v1 = state->v[1], v2 = state->v[2], v3 = state->v[3];
+
+		while (data + 32 <= end) {
+
+			v0 = xxh_round (v0, xxh_read64 (data));
+			v1 = xxh_round (v1, xxh_read64 (data + 8));
+			v2 = xxh_round (v2, xxh_read64 (data + 16));
+			v3 = xxh_round (v3, xxh_read64 (data + 24));
+			data += 32;
+
+		}
+
+		state->v[0] = v0; state->v[1] = v1; state->v[2] = v2; state->v[3] = v3;
+
+		if (data < end) {
+
+			memcpy (state->memory, data, end - data);
+			state->memorySize = end - data;
+
+		}
+
+	}
+
+
+	static uint64_t hash_digest (HashState* state) {
+
+		uint64_t hash;
+
+		if (state->length >= 32) {
+
+			hash = xxh_rotl (state->v[0], 1) + xxh_rotl (state->v[1], 7) + xxh_rotl (state->v[2], 12) + xxh_rotl (state->v[3], 18);
+
+			for (int i = 0; i < 4; i++) {
+
+				hash = xxh_merge_round (hash, state->v[i]);
+
+			}
+
+		} else {
+
+			hash = state->seed + XXH_PRIME64_5;
+
+		}
+
+		hash += state->length;
+
+		const uint8_t* data = state->memory;
+		const uint8_t* end = data + state->memorySize;
+
+		while (data + 8 <= end) {
+
+			hash ^= xxh_round (0, xxh_read64 (data));
+			hash = xxh_rotl (hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+			data += 8;
+
+		}
+
+		if (data + 4 <= end) {
+
+			uint32_t value;
+			memcpy (&value, data, 4);
+			hash ^= (uint64_t)value * XXH_PRIME64_1;
+			hash = xxh_rotl (hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+			data += 4;
+
+		}
+
+		while (data < end) {
+
+			hash ^= (*data) * XXH_PRIME64_5;
+			hash = xxh_rotl (hash, 11) * XXH_PRIME64_1;
+			data++;
+
+		}
+
+		hash ^= hash >> 33;
+		hash *= XXH_PRIME64_2;
+		hash ^= hash >> 29;
+		hash *= XXH_PRIME64_3;
+		hash ^= hash >> 32;
+
+		return hash;
+
+	}
+
+
+	// textured triangles, rasterized with half-space edge functions in 24.8 fixed point and
+	// binned into tiles so that tiles can be filled on separate threads
+
+	#define RASTER_TILE_SIZE 64
+
+
+	struct RasterTriangle {
+
+		int64_t c[3];
+		int64_t dx[3];
+		int64_t dy[3];
+		float dudx, dudy, dvdx, dvdy, dqdx, dqdy;
+		float u0, v0, q0;
+		int minX, minY, maxX, maxY;
+		bool perspective;
+
+	};
+
+
+	struct RasterJob {
+
+		std::vector<std::vector<int> > bins;
+		uint8_t* data;
+		int alphaOffset, redOffset, greenOffset, blueOffset;
+		bool premultiplied;
+		bool repeat;
+		bool smooth;
+		int stride;
+		int offset;
+		const uint32_t* texels;
+		int textureHeight;
+		int textureWidth;
+		int tilesX;
+		std::vector<RasterTriangle> triangles;
+
+	};
+
+
+	static inline bool raster_within (double value, double limit) {
+
+		// false for NaN as well as for anything out of range
+
+		return value >= -limit && value <= limit;
+
+	}
+
+
+	static inline int raster_wrap (int value, int size, bool repeat) {
+
+		if (repeat) {
+
+			value %= size;
+			return value < 0 ? value + size : value;
+
+		}
+
+		return value < 0 ? 0 : (value >= size ? size - 1 : value);
+
+	}
+
+
+	static inline float raster_bound (float value) {
+
+		// texel coordinates (NaN included) are held within 2^30, so converting them to int is defined,
+		// which is far past the point where repeat or clamp could tell the difference
+
+		return (value >= -1073741824.0f) ? (value <= 1073741824.0f ? value : 1073741824.0f) : -1073741824.0f;
+
+	}
+
+
+	static inline int raster_floor (float value) {
+
+		// floorf is a library call on baseline x86-64
+
+		int result = (int)value;
+		return (value < result) ? result - 1 : result;
+
+	}
+
+
+	static inline uint32_t raster_sample (RasterJob* job, float u, float v) {
+
+		int width = job->textureWidth;
+		int height = job->textureHeight;
+
+		if (!job->smooth) {
+
+			int x = raster_wrap (raster_floor (raster_bound (u * width)), width, job->repeat);
+			int y = raster_wrap (raster_floor (raster_bound (v * height)), height, job->repeat);
+			return job->texels[y * width + x];
+
+		}
+
+		float fx = raster_bound (u * width - 0.5f);
+		float fy = raster_bound (v * height - 0.5f);
+		int x0 = raster_floor (fx);
+		int y0 = raster_floor (fy);
+		int wx = (int)((fx - x0) * 256);
+		int wy = (int)((fy - y0) * 256);
+		int x1 = raster_wrap (x0 + 1, width, job->repeat);
+		int y1 = raster_wrap (y0 + 1, height, job->repeat);
+		x0 = raster_wrap (x0, width, job->repeat);
+		y0 = raster_wrap (y0, height, job->repeat);
+
+		uint32_t a = job->texels[y0 * width + x0];
+		uint32_t b = job->texels[y0 * width + x1];
+		uint32_t c = job->texels[y1 * width + x0];
+		uint32_t d = job->texels[y1 * width + x1];
+
+		// two channels at a time, the texels are premultiplied so colour and alpha filter alike
+
+		uint32_t result = 0;
+
+		for (int shift = 0; shift < 16; shift += 8) {
+
+			uint32_t top = (((a >> shift) & 0x00FF00FF) * (256 - wx) + ((b >> shift) & 0x00FF00FF) * wx) >> 8;
+			uint32_t bottom = (((c >> shift) & 0x00FF00FF) * (256 - wx) + ((d >> shift) & 0x00FF00FF) * wx) >> 8;
+			result |= (((top & 0x00FF00FF) * (256 - wy) + (bottom & 0x00FF00FF) * wy) >> 8 & 0x00FF00FF) << shift;
+
+		}
+
+		return result;
+
+	}
+
+
+	static inline int raster_div255 (int value) {
+
+		value += 128;
+		return (value + (value >> 8)) >> 8;
+
+	}
+
+
+	static void raster_tile (int index, void* userData) {
+
+		RasterJob* job = (RasterJob*)userData;
+		std::vector<int>& bin = job->bins[index];
+
+		int tileX = (index % job->tilesX) * RASTER_TILE_SIZE;
+		int tileY = (index / job->tilesX) * RASTER_TILE_SIZE;
+
+		for (size_t i = 0; i < bin.size (); i++) {
+
+			RasterTriangle* triangle = &job->triangles[bin[i]];
+
+			int minX = triangle->minX > tileX ? triangle->minX : tileX;
+			int minY = triangle->minY > tileY ? triangle->minY : tileY;
+			int maxX = triangle->maxX < tileX + RASTER_TILE_SIZE - 1 ? triangle->maxX : tileX + RASTER_TILE_SIZE - 1;
+			int maxY = triangle->maxY < tileY + RASTER_TILE_SIZE - 1 ? triangle->maxY : tileY + RASTER_TILE_SIZE - 1;
+
+			for (int y = minY; y <= maxY; y++) {
+
+				// edge values at the centre of the first pixel in the row
+
+				int64_t px = ((int64_t)minX << 8) + 128;
+				int64_t py = ((int64_t)y << 8) + 128;
+				int64_t e0 = triangle->c[0] + triangle->dx[0] * px + triangle->dy[0] * py;
+				int64_t e1 = triangle->c[1] + triangle->dx[1] * px + triangle->dy[1] * py;
+				int64_t e2 = triangle->c[2] + triangle->dx[2] * px + triangle->dy[2] * py;
+				int64_t step0 = triangle->dx[0] * 256;
+				int64_t step1 = triangle->dx[1] * 256;
+				int64_t step2 = triangle->dx[2] * 256;
+
+				float u = triangle->u0 + triangle->dudx * (minX + 0.5f) + triangle->dudy * (y + 0.5f);
+				float v = triangle->v0 + triangle->dvdx * (minX + 0.5f) + triangle->dvdy * (y + 0.5f);
+				float q = triangle->q0 + triangle->dqdx * (minX + 0.5f) + triangle->dqdy * (y + 0.5f);
+
+				uint8_t* pixel = job->data + job->offset + y * job->stride + minX * 4;
+
+				for (int x = minX; x <= maxX; x++) {
+
+					if ((e0 | e1 | e2) >= 0) {
+
+						uint32_t texel = triangle->perspective ? raster_sample (job, u / q, v / q) : raster_sample (job, u, v);
+						int sr = texel & 0xFF, sg = (texel >> 8) & 0xFF, sb = (texel >> 16) & 0xFF, sa = texel >> 24;
+
+						if (sa == 255) {
+
+							pixel[job->redOffset] = sr;
+							pixel[job->greenOffset] = sg;
+							pixel[job->blueOffset] = sb;
+							pixel[job->alphaOffset] = 255;
+
+						} else if (sa > 0) {
+
+							int inverse = 255 - sa;
+							int da = pixel[job->alphaOffset];
+							int dr = pixel[job->redOffset], dg = pixel[job->greenOffset], db = pixel[job->blueOffset];
+
+							if (!job->premultiplied) {
+
+								dr = raster_div255 (dr * da);
+								dg = raster_div255 (dg * da);
+								db = raster_div255 (db * da);
+
+							}
+
+							int oa = sa + raster_div255 (da * inverse);
+							int or_ = sr + raster_div255 (dr * inverse);
+							int og = sg + raster_div255 (dg * inverse);
+							int ob = sb + raster_div255 (db * inverse);
+
+							if (!job->premultiplied) {
+
+								int reciprocal = (255 * 65536 + oa / 2) / oa;
+								or_ = (or_ * reciprocal + 32768) >> 16;
+								og = (og * reciprocal + 32768) >> 16;
+								ob = (ob * reciprocal + 32768) >> 16;
+
+							}
+
+							pixel[job->redOffset] = or_ > 255 ? 255 : or_;
+							pixel[job->greenOffset] = og > 255 ? 255 : og;
+							pixel[job->blueOffset] = ob > 255 ? 255 : ob;
+							pixel[job->alphaOffset] = oa > 255 ? 255 : oa;
+
+						}
+
+					}
+
+					e0 += step0;
+					e1 += step1;
+					e2 += step2;
+					u += triangle->dudx;
+					v += triangle->dvdx;
+					q += triangle->dqdx;
+					pixel += 4;
+
+				}
+
+			}
+
+		}
+
+	}
+
+
+	struct DiffBand {
+
+		int maxDelta;
+		int maxX;
+		int maxY;
+		int minX;
+		int minY;
+		int mismatches;
+		uint64_t sumSquares;
+
+	};
+
+
+	struct DiffJob {
+
+		std::vector<DiffBand> bands;
+		int bandHeight;
+		const uint8_t* data;
+		PixelFormat format;
+		int height;
+		int offset;
+		const uint8_t* otherData;
+		PixelFormat otherFormat;
+		int otherOffset;
+		bool otherPremultiplied;
+		int otherStride;
+		bool premultiplied;
+		bool raw;
+		int stride;
+		int tolerance;
+		int width;
+
+	};
+
+
+	static int diff_row (const uint8_t* row, const uint8_t* otherRow, int length, uint64_t* sumSquares) {
+
+		int i = 0;
+		int rowMax = 0;
+
+		#ifdef __SSE2__
+
+		__m128i zero = _mm_setzero_si128 ();
+		__m128i maxDelta = zero;
+
+		while (i + 16 <= length) {
+
+			// squares are summed in 32-bit lanes, flushed often enough that they cannot overflow
+
+			int chunkEnd = (i + 16384 < length) ? i + 16384 : length;
+			__m128i squares = zero;
+
+			for (; i + 16 <= chunkEnd; i += 16) {
+
+				__m128i a = _mm_loadu_si128 ((const __m128i*)(row + i));
+				__m128i b = _mm_loadu_si128 ((const __m128i*)(otherRow + i));
+				__m128i delta = _mm_or_si128 (_mm_subs_epu8 (a, b), _mm_subs_epu8 (b, a));
+				__m128i low = _mm_unpacklo_epi8 (delta, zero);
+				__m128i high = _mm_unpackhi_epi8 (delta, zero);
+
+				maxDelta = _mm_max_epu8 (maxDelta, delta);
+				squares = _mm_add_epi32 (squares, _mm_madd_epi16 (low, low));
+				squares = _mm_add_epi32 (squares, _mm_madd_epi16 (high, high));
+
+			}
+
+			uint32_t lanes[4];
+			_mm_storeu_si128 ((__m128i*)lanes, squares);
+			*sumSquares += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+		}
+
+		uint8_t maxLanes[16];
+		_mm_storeu_si128 ((__m128i*)maxLanes, maxDelta);
+
+		for (int j = 0; j < 16; j++) {
+
+			if (maxLanes[j] > rowMax) rowMax = maxLanes[j];
+
+		}
+
+		#endif
+
+		uint64_t squares = 0;
+
+		for (; i < length; i++) {
+
+			int delta = row[i] > otherRow[i] ? row[i] - otherRow[i] : otherRow[i] - row[i];
+			squares += delta * delta;
+			if (delta > rowMax) rowMax = delta;
+
+		}
+
+		*sumSquares += squares;
+
+		return rowMax;
+
+	}
+
+
+	static void diff_band (int index, void* userData) {
+
+		DiffJob* job = (DiffJob*)userData;
+		DiffBand* band = &job->bands[index];
+
+		int startY = index * job->bandHeight;
+		int endY = startY + job->bandHeight;
+		if (endY > job->height) endY = job->height;
+
+		int width = job->width;
+		int tolerance = job->tolerance;
+		RGBA pixel, otherPixel;
+		uint8_t a[4], b[4];
+
+		for (int y = startY; y < endY; y++) {
+
+			const uint8_t* row = job->data + job->offset + y * job->stride;
+			const uint8_t* otherRow = job->otherData + job->otherOffset + y * job->otherStride;
+
+			if (job->raw) {
+
+				// a flat pass over the row bytes settles identical or in-tolerance rows, only rows
+				// that differ are walked again per pixel
+
+				int rowMax = diff_row (row, otherRow, width * 4, &band->sumSquares);
+
+				if (rowMax > band->maxDelta) band->maxDelta = rowMax;
+				if (rowMax <= tolerance) continue;
+
+			}
+
+			int rowMismatches = 0;
+			int rowMinX = width;
+			int rowMaxX = -1;
+
+			for (int x = 0; x < width; x++) {
+
+				const uint8_t* p = row + x * 4;
+				const uint8_t* q = otherRow + x * 4;
+
+				if (!job->raw) {
+
+					// formats differ, compare the unmultiplied RGBA each side decodes to
+
+					pixel.ReadUInt8 (row, x * 4, job->format, job->premultiplied, LIME_BIG_ENDIAN);
+					otherPixel.ReadUInt8 (otherRow, x * 4, job->otherFormat, job->otherPremultiplied, LIME_BIG_ENDIAN);
+					a[0] = pixel.r; a[1] = pixel.g; a[2] = pixel.b; a[3] = pixel.a;
+					b[0] = otherPixel.r; b[1] = otherPixel.g; b[2] = otherPixel.b; b[3] = otherPixel.a;
+					p = a;
+					q = b;
+
+				}
+
+				int pixelDelta = 0;
+
+				for (int c = 0; c < 4; c++) {
+
+					int delta = p[c] > q[c] ? p[c] - q[c] : q[c] - p[c];
+					if (!job->raw) band->sumSquares += delta * delta;
+					if (delta > pixelDelta) pixelDelta = delta;
+
+				}
+
+				if (pixelDelta > band->maxDelta) band->maxDelta = pixelDelta;
+
+				if (pixelDelta > tolerance) {
+
+					rowMismatches++;
+					if (x < rowMinX) rowMinX = x;
+					rowMaxX = x;
+
+				}
+
+			}
+
+			if (rowMismatches > 0) {
+
+				band->mismatches += rowMismatches;
+				if (rowMinX < band->minX) band->minX = rowMinX;
+				if (rowMaxX > band->maxX) band->maxX = rowMaxX;
+				if (y < band->minY) band->minY = y;
+				band->maxY = y;
+
+			}
+
+		}
+
+	}
+
+
+	void ImageDataUtil::AlphaBleed (Image* image, Rectangle* rect, int radius) {
+
+		// premultiplied colour is always zero under zero alpha, so there is nothing to bleed
+
+		if (image->buffer->premultiplied) return;
+
+		uint8_t* data = (uint8_t*)image->buffer->data->buffer->b;
+
+		if (!data) return;
+
+		ImageDataView dataView = ImageDataView (image, rect);
+		int width = dataView.width;
+		int height = dataView.height;
+
+		if (width <= 0 || height <= 0) return;
+
+		int alphaOffset = (image->buffer->format == ARGB32) ? 0 : 3;
+		int colorOffset = (image->buffer->format == ARGB32) ? 1 : 0;
+
+		// 0 = transparent, 1 = has colour, 2 = queued for the current pass
+
+		std::vector<uint8_t> state (width * height, 0);
+		std::vector<int> frontier;
+		std::vector<int> next;
+
+		for (int y = 0; y < height; y++) {
+
+			int row = dataView.Row (y);
+
+			for (int x = 0; x < width; x++) {
+
+				if (data[row + x * 4 + alphaOffset] != 0) {
+
+					state[y * width + x] = 1;
+
+				}
+
+			}
+
+		}
+
+		for (int y = 0; y < height; y++) {
+
+			for (int x = 0; x < width; x++) {
+
+				if (state[y * width + x] != 0) continue;
+
+				for (int dy = -1; dy <= 1 && state[y * width + x] == 0; dy++) {
+
+					for (int dx = -1; dx <= 1; dx++) {
+
+						int nx = x + dx;
+						int ny = y + dy;
+
+						if (nx >= 0 && nx < width && ny >= 0 && ny < height && state[ny * width + nx] == 1) {
+
+							state[y * width + x] = 2;
+							frontier.push_back (y * width + x);
+							break;
+
+						}
+
+					}
+
+				}
+
+			}
+
+		}
+
+		// each pass fills one ring of transparent texels with the average of their coloured neighbours
+
+		int pass = 0;
+
+		while (!frontier.empty () && (radius <= 0 || pass < radius)) {
+
+			for (size_t i = 0; i < frontier.size (); i++) {
+
+				int x = frontier[i] % width;
+				int y = frontier[i] / width;
+				int r = 0, g = 0, b = 0, count = 0;
+
+				for (int dy = -1; dy <= 1; dy++) {
+
+					for (int dx = -1; dx <= 1; dx++) {
+
+						int nx = x + dx;
+						int ny = y + dy;
+
+						if (nx >= 0 && nx < width && ny >= 0 && ny < height && state[ny * width + nx] == 1) {
+
+							uint8_t* pixel = &data[dataView.Row (ny) + nx * 4 + colorOffset];
+							r += pixel[0];
+							g += pixel[1];
+							b += pixel[2];
+							count++;
+
+						}
+
+					}
+
+				}
+
+				uint8_t* pixel = &data[dataView.Row (y) + x * 4 + colorOffset];
+				pixel[0] = (r + count / 2) / count;
+				pixel[1] = (g + count / 2) / count;
+				pixel[2] = (b + count / 2) / count;
+
+			}
+
+			for (size_t i = 0; i < frontier.size (); i++) {
+
+				state[frontier[i]] = 1;
+
+			}
+
+			next.clear ();
+
+			for (size_t i = 0; i < frontier.size (); i++) {
+
+				int x = frontier[i] % width;
+				int y = frontier[i] / width;
+
+				for (int dy = -1; dy <= 1; dy++) {
+
+					for (int dx = -1; dx <= 1; dx++) {
+
+						int nx = x + dx;
+						int ny = y + dy;
+
+						if (nx >= 0 && nx < width && ny >= 0 && ny < height && state[ny * width + nx] == 0) {
+
+							state[ny * width + nx] = 2;
+							next.push_back (ny * width + nx);
+
+						}
+
+					}
+
+				}
+
+			}
+
+			frontier.swap (next);
+			pass++;
+
+		}
+
+	}
 
 
 	void ImageDataUtil::ColorTransform (Image* image, Rectangle* rect, ColorMatrix* colorMatrix) {
@@ -107,7 +1032,7 @@ namespace lime {
 	}
 
 
-	void ImageDataUtil::CopyPixels (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, Image* alphaImage, Vector2* alphaPoint, bool mergeAlpha) {
+	void ImageDataUtil::CopyPixels (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, Image* alphaImage, Vector2* alphaPoint, bool mergeAlpha, bool linear) {
 
 		uint8_t* sourceData = (uint8_t*)sourceImage->buffer->data->buffer->b;
 		uint8_t* destData = (uint8_t*)image->buffer->data->buffer->b;
@@ -156,6 +1081,13 @@ namespace lime {
 
 							destPixel.Set (0, 0, 0, 0);
 
+						} else if (linear) {
+
+							destPixel.r = linear_to_srgb ((linearTable[sourcePixel.r] * sourceAlpha + linearTable[destPixel.r] * destAlpha * oneMinusSourceAlpha) / blendAlpha);
+							destPixel.g = linear_to_srgb ((linearTable[sourcePixel.g] * sourceAlpha + linearTable[destPixel.g] * destAlpha * oneMinusSourceAlpha) / blendAlpha);
+							destPixel.b = linear_to_srgb ((linearTable[sourcePixel.b] * sourceAlpha + linearTable[destPixel.b] * destAlpha * oneMinusSourceAlpha) / blendAlpha);
+							destPixel.a = __clamp[int (0.5 + blendAlpha * 255.0)];
+
 						} else {
 
 							destPixel.r = __clamp[int (0.5 + (sourcePixel.r * sourceAlpha + destPixel.r * destAlpha * oneMinusSourceAlpha) / blendAlpha)];
@@ -241,9 +1173,20 @@ namespace lime {
 							oneMinusSourceAlpha = 1 - sourceAlpha;
 							blendAlpha = sourceAlpha + (destAlpha * oneMinusSourceAlpha);
 
-							destPixel.r = __clamp[int (0.5 + (sourcePixel.r * sourceAlpha + destPixel.r * destAlpha * oneMinusSourceAlpha) / blendAlpha)];
-							destPixel.g = __clamp[int (0.5 + (sourcePixel.g * sourceAlpha + destPixel.g * destAlpha * oneMinusSourceAlpha) / blendAlpha)];
-							destPixel.b = __clamp[int (0.5 + (sourcePixel.b * sourceAlpha + destPixel.b * destAlpha * oneMinusSourceAlpha) / blendAlpha)];
+							if (linear) {
+
+								destPixel.r = linear_to_srgb ((linearTable[sourcePixel.r] * sourceAlpha + linearTable[destPixel.r] * destAlpha * oneMinusSourceAlpha) / blendAlpha);
+								destPixel.g = linear_to_srgb ((linearTable[sourcePixel.g] * sourceAlpha + linearTable[destPixel.g] * destAlpha * oneMinusSourceAlpha) / blendAlpha);
+								destPixel.b = linear_to_srgb ((linearTable[sourcePixel.b] * sourceAlpha + linearTable[destPixel.b] * destAlpha * oneMinusSourceAlpha) / blendAlpha);
+
+							} else {
+
+								destPixel.r = __clamp[int (0.5 + (sourcePixel.r * sourceAlpha + destPixel.r * destAlpha * oneMinusSourceAlpha) / blendAlpha)];
+								destPixel.g = __clamp[int (0.5 + (sourcePixel.g * sourceAlpha + destPixel.g * destAlpha * oneMinusSourceAlpha) / blendAlpha)];
+								destPixel.b = __clamp[int (0.5 + (sourcePixel.b * sourceAlpha + destPixel.b * destAlpha * oneMinusSourceAlpha) / blendAlpha)];
+
+							}
+
 							destPixel.a = __clamp[int (0.5 + blendAlpha * 255.0)];
 
 							destPixel.WriteUInt8 (destData, destPosition, destFormat, destPremultiplied);
@@ -289,6 +1232,397 @@ namespace lime {
 	}
 
 
+	void ImageDataUtil::Diff (Image* image, Image* otherImage, Rectangle* rect, int tolerance, ImageDiff* result) {
+
+		result->height = 0;
+		result->maxDelta = 0;
+		result->mismatches = 0;
+		result->psnr = INFINITY;
+		result->width = 0;
+		result->x = 0;
+		result->y = 0;
+
+		uint8_t* data = (uint8_t*)image->buffer->data->buffer->b;
+		uint8_t* otherData = (uint8_t*)otherImage->buffer->data->buffer->b;
+
+		if (!data || !otherData) return;
+
+		ImageDataView dataView = ImageDataView (image, rect);
+		ImageDataView otherView = ImageDataView (otherImage, rect);
+
+		DiffJob job;
+		job.width = dataView.width < otherView.width ? dataView.width : otherView.width;
+		job.height = dataView.height < otherView.height ? dataView.height : otherView.height;
+
+		if (job.width <= 0 || job.height <= 0) return;
+
+		job.data = data;
+		job.format = image->buffer->format;
+		job.offset = dataView.Row (0);
+		job.premultiplied = image->buffer->premultiplied;
+		job.stride = image->buffer->Stride ();
+		job.otherData = otherData;
+		job.otherFormat = otherImage->buffer->format;
+		job.otherOffset = otherView.Row (0);
+		job.otherPremultiplied = otherImage->buffer->premultiplied;
+		job.otherStride = otherImage->buffer->Stride ();
+		job.raw = (job.format == job.otherFormat && job.premultiplied == job.otherPremultiplied);
+		job.tolerance = tolerance;
+
+		// bands of rows are compared in parallel and merged, small regions stay on this thread
+
+		int threads = Parallel::GetConcurrency ();
+		int bandCount = (job.width * job.height >= 256 * 256) ? threads * 4 : 1;
+		if (bandCount > job.height) bandCount = job.height;
+		job.bandHeight = (job.height + bandCount - 1) / bandCount;
+		bandCount = (job.height + job.bandHeight - 1) / job.bandHeight;
+
+		DiffBand empty = { 0, -1, -1, job.width, job.height, 0, 0 };
+		job.bands.assign (bandCount, empty);
+
+		Parallel::For (bandCount, threads, diff_band, &job);
+
+		uint64_t sumSquares = 0;
+		int minX = job.width, minY = job.height, maxX = -1, maxY = -1;
+
+		for (int i = 0; i < bandCount; i++) {
+
+			DiffBand* band = &job.bands[i];
+
+			sumSquares += band->sumSquares;
+			result->mismatches += band->mismatches;
+			if (band->maxDelta > result->maxDelta) result->maxDelta = band->maxDelta;
+			if (band->minX < minX) minX = band->minX;
+			if (band->minY < minY) minY = band->minY;
+			if (band->maxX > maxX) maxX = band->maxX;
+			if (band->maxY > maxY) maxY = band->maxY;
+
+		}
+
+		if (sumSquares > 0) {
+
+			double mse = (double)sumSquares / ((double)job.width * job.height * 4);
+			result->psnr = 10.0 * log10 ((255.0 * 255.0) / mse);
+
+		}
+
+		if (result->mismatches > 0) {
+
+			result->x = dataView.x + minX;
+			result->y = dataView.y + minY;
+			result->width = maxX - minX + 1;
+			result->height = maxY - minY + 1;
+
+		}
+
+	}
+
+
+	void ImageDataUtil::DrawTriangles (Image* image, Image* texture, ArrayBufferView* vertices, ArrayBufferView* indices, ArrayBufferView* uvs, int culling, bool smooth, bool repeat) {
+
+		// vertices are Float32 x, y pairs in image pixels, uvs are Float32 u, v (or u, v, t) in
+		// 0-1 texture space and indices are Int32, three per triangle (sequential if empty).
+		// t is the vertex depth, u / t, v / t and 1 / t are interpolated for perspective-correct
+		// texturing. Triangles with a non-finite or non-positive t, non-finite uvs, or a vertex
+		// further than 2^20 pixels out are skipped.
+		// culling > 0 drops triangles that are clockwise on screen, culling < 0 counter-clockwise
+
+		uint8_t* data = (uint8_t*)image->buffer->data->buffer->b;
+		uint8_t* textureData = (uint8_t*)texture->buffer->data->buffer->b;
+
+		if (!data || !textureData || !vertices || !vertices->buffer->b || !uvs || !uvs->buffer->b) return;
+		if (image->width <= 0 || image->height <= 0 || texture->width <= 0 || texture->height <= 0) return;
+
+		const float* vertexData = (const float*)vertices->buffer->b;
+		const float* uvData = (const float*)uvs->buffer->b;
+		const int* indexData = (indices && indices->buffer->b) ? (const int*)indices->buffer->b : 0;
+
+		int vertexCount = vertices->byteLength / 8;
+		int uvCount = uvs->byteLength / 4;
+		int uvStride = (uvCount == vertexCount * 3) ? 3 : 2;
+		int indexCount = indexData ? indices->byteLength / 4 : vertexCount;
+
+		if (uvCount < vertexCount * uvStride) return;
+
+		RasterJob job;
+
+		// the texture is sampled as premultiplied RGBA, converted once up front
+
+		job.textureWidth = texture->width;
+		job.textureHeight = texture->height;
+		std::vector<uint32_t> texels (texture->width * texture->height);
+
+		Rectangle textureRect = Rectangle (0, 0, texture->width, texture->height);
+		ImageDataView textureView = ImageDataView (texture, &textureRect);
+		PixelFormat textureFormat = texture->buffer->format;
+		bool texturePremultiplied = texture->buffer->premultiplied;
+		RGBA pixel;
+
+		for (int y = 0; y < textureView.height; y++) {
+
+			int row = textureView.Row (y);
+
+			for (int x = 0; x < textureView.width; x++) {
+
+				pixel.ReadUInt8 (textureData, row + x * 4, textureFormat, false, LIME_BIG_ENDIAN);
+
+				if (!texturePremultiplied) {
+
+					pixel.r = raster_div255 (pixel.r * pixel.a);
+					pixel.g = raster_div255 (pixel.g * pixel.a);
+					pixel.b = raster_div255 (pixel.b * pixel.a);
+
+				}
+
+				texels[y * texture->width + x] = pixel.r | (pixel.g << 8) | (pixel.b << 16) | ((uint32_t)pixel.a << 24);
+
+			}
+
+		}
+
+		job.texels = &texels[0];
+		job.smooth = smooth;
+		job.repeat = repeat;
+
+		PixelFormat format = image->buffer->format;
+		job.redOffset = (format == ARGB32) ? 1 : (format == BGRA32) ? 2 : 0;
+		job.greenOffset = (format == ARGB32) ? 2 : 1;
+		job.blueOffset = (format == ARGB32) ? 3 : (format == BGRA32) ? 0 : 2;
+		job.alphaOffset = (format == ARGB32) ? 0 : 3;
+		job.premultiplied = image->buffer->premultiplied;
+		job.data = data;
+		job.stride = image->buffer->Stride ();
+		job.offset = job.stride * image->offsetY + image->offsetX * 4;
+
+		job.tilesX = (image->width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+		int tilesY = (image->height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+		job.bins.resize (job.tilesX * tilesY);
+
+		int64_t coverage = 0;
+
+		for (int i = 0; i + 2 < indexCount; i += 3) {
+
+			int index[3];
+
+			for (int j = 0; j < 3; j++) {
+
+				index[j] = indexData ? indexData[i + j] : i + j;
+
+			}
+
+			if (index[0] < 0 || index[1] < 0 || index[2] < 0 || index[0] >= vertexCount || index[1] >= vertexCount || index[2] >= vertexCount) continue;
+
+			int64_t x[3], y[3];
+			double u[3], v[3], q[3];
+			bool valid = true;
+
+			for (int j = 0; j < 3; j++) {
+
+				// the limit keeps 24.8 coordinates in range of the 64-bit edge products below
+
+				double vx = vertexData[index[j] * 2];
+				double vy = vertexData[index[j] * 2 + 1];
+				double t = (uvStride == 3) ? uvData[index[j] * 3 + 2] : 1.0;
+
+				u[j] = uvData[index[j] * uvStride];
+				v[j] = uvData[index[j] * uvStride + 1];
+
+				if (!raster_within (vx, 1 << 20) || !raster_within (vy, 1 << 20) || !raster_within (u[j], FLT_MAX) || !raster_within (v[j], FLT_MAX) || !(t > 0 && t <= FLT_MAX)) {
+
+					valid = false;
+					break;
+
+				}
+
+				x[j] = (int64_t)floor (vx * 256.0 + 0.5);
+				y[j] = (int64_t)floor (vy * 256.0 + 0.5);
+				q[j] = 1.0 / t;
+
+			}
+
+			if (!valid) continue;
+
+			// a constant t is an affine mapping, which skips the divide per pixel
+
+			bool perspective = (q[0] != q[1] || q[0] != q[2]);
+
+			for (int j = 0; j < 3; j++) {
+
+				if (perspective) {
+
+					u[j] *= q[j];
+					v[j] *= q[j];
+
+				} else {
+
+					q[j] = 1;
+
+				}
+
+			}
+
+			int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+			if (area == 0 || (culling > 0 && area > 0) || (culling < 0 && area < 0)) continue;
+
+			if (area < 0) {
+
+				std::swap (x[1], x[2]);
+				std::swap (y[1], y[2]);
+				std::swap (u[1], u[2]);
+				std::swap (v[1], v[2]);
+				std::swap (q[1], q[2]);
+				area = -area;
+
+			}
+
+			RasterTriangle triangle;
+
+			double minFX = x[0], maxFX = x[0], minFY = y[0], maxFY = y[0];
+
+			for (int j = 1; j < 3; j++) {
+
+				if (x[j] < minFX) minFX = x[j];
+				if (x[j] > maxFX) maxFX = x[j];
+				if (y[j] < minFY) minFY = y[j];
+				if (y[j] > maxFY) maxFY = y[j];
+
+			}
+
+			triangle.minX = (int)floor (minFX / 256.0);
+			triangle.minY = (int)floor (minFY / 256.0);
+			triangle.maxX = (int)ceil (maxFX / 256.0);
+			triangle.maxY = (int)ceil (maxFY / 256.0);
+
+			if (triangle.minX < 0) triangle.minX = 0;
+			if (triangle.minY < 0) triangle.minY = 0;
+			if (triangle.maxX > image->width - 1) triangle.maxX = image->width - 1;
+			if (triangle.maxY > image->height - 1) triangle.maxY = image->height - 1;
+
+			if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) continue;
+
+			// edge k runs opposite vertex k, its value at a point is that vertex's barycentric weight times the area
+
+			double uOrigin = 0, vOrigin = 0, qOrigin = 0, uStepX = 0, uStepY = 0, vStepX = 0, vStepY = 0, qStepX = 0, qStepY = 0;
+
+			for (int k = 0; k < 3; k++) {
+
+				int i0 = (k + 1) % 3;
+				int i1 = (k + 2) % 3;
+
+				triangle.dx[k] = -(y[i1] - y[i0]);
+				triangle.dy[k] = x[i1] - x[i0];
+				triangle.c[k] = (y[i1] - y[i0]) * x[i0] - (x[i1] - x[i0]) * y[i0];
+
+				uOrigin += (double)triangle.c[k] * u[k];
+				vOrigin += (double)triangle.c[k] * v[k];
+				qOrigin += (double)triangle.c[k] * q[k];
+				uStepX += (double)triangle.dx[k] * u[k];
+				vStepX += (double)triangle.dx[k] * v[k];
+				qStepX += (double)triangle.dx[k] * q[k];
+				uStepY += (double)triangle.dy[k] * u[k];
+				vStepY += (double)triangle.dy[k] * v[k];
+				qStepY += (double)triangle.dy[k] * q[k];
+
+				// top-left rule, a pixel centre exactly on a shared edge belongs to one triangle only
+
+				bool topLeft = (y[i1] < y[i0]) || (y[i1] == y[i0] && x[i1] > x[i0]);
+				if (!topLeft) triangle.c[k] -= 1;
+
+			}
+
+			triangle.u0 = uOrigin / area;
+			triangle.v0 = vOrigin / area;
+			triangle.dudx = uStepX * 256.0 / area;
+			triangle.dvdx = vStepX * 256.0 / area;
+			triangle.dudy = uStepY * 256.0 / area;
+			triangle.dvdy = vStepY * 256.0 / area;
+			triangle.q0 = qOrigin / area;
+			triangle.dqdx = qStepX * 256.0 / area;
+			triangle.dqdy = qStepY * 256.0 / area;
+			triangle.perspective = perspective;
+
+			int id = job.triangles.size ();
+			job.triangles.push_back (triangle);
+			coverage += (int64_t)(triangle.maxX - triangle.minX + 1) * (triangle.maxY - triangle.minY + 1);
+
+			for (int tileY = triangle.minY / RASTER_TILE_SIZE; tileY <= triangle.maxY / RASTER_TILE_SIZE; tileY++) {
+
+				for (int tileX = triangle.minX / RASTER_TILE_SIZE; tileX <= triangle.maxX / RASTER_TILE_SIZE; tileX++) {
+
+					job.bins[tileY * job.tilesX + tileX].push_back (id);
+
+				}
+
+			}
+
+		}
+
+		// each tile keeps submission order, so overlapping triangles composite as if drawn in sequence
+
+		int threads = (coverage >= 256 * 256) ? Parallel::GetConcurrency () : 1;
+		Parallel::For (job.bins.size (), threads, raster_tile, &job);
+
+	}
+
+
+	void ImageDataUtil::Extrude (Image* image, Rectangle* rect, int padding) {
+
+		// repeats the edge texels of rect outward, so filtering at the edge of an atlas region
+		// never samples its neighbour
+
+		uint8_t* data = (uint8_t*)image->buffer->data->buffer->b;
+
+		if (!data || padding <= 0) return;
+
+		ImageDataView dataView = ImageDataView (image, rect);
+
+		if (dataView.width <= 0 || dataView.height <= 0) return;
+
+		int stride = image->buffer->Stride ();
+		int left = dataView.x;
+		int top = dataView.y;
+		int right = dataView.x + dataView.width;
+		int bottom = dataView.y + dataView.height;
+
+		int x0 = (left - padding > 0) ? left - padding : 0;
+		int y0 = (top - padding > 0) ? top - padding : 0;
+		int x1 = (right + padding < image->width) ? right + padding : image->width;
+		int y1 = (bottom + padding < image->height) ? bottom + padding : image->height;
+
+		uint32_t* pixels;
+		uint32_t edge;
+
+		for (int y = top; y < bottom; y++) {
+
+			pixels = (uint32_t*)&data[stride * (y + image->offsetY) + image->offsetX * 4];
+
+			edge = pixels[left];
+			for (int x = x0; x < left; x++) pixels[x] = edge;
+
+			edge = pixels[right - 1];
+			for (int x = right; x < x1; x++) pixels[x] = edge;
+
+		}
+
+		int rowOffset = (x0 + image->offsetX) * 4;
+		int rowLength = (x1 - x0) * 4;
+
+		for (int y = y0; y < top; y++) {
+
+			memcpy (&data[stride * (y + image->offsetY) + rowOffset], &data[stride * (top + image->offsetY) + rowOffset], rowLength);
+
+		}
+
+		for (int y = bottom; y < y1; y++) {
+
+			memcpy (&data[stride * (y + image->offsetY) + rowOffset], &data[stride * (bottom - 1 + image->offsetY) + rowOffset], rowLength);
+
+		}
+
+	}
+
+
 	void ImageDataUtil::FillRect (Image* image, Rectangle* rect, int32_t color) {
 
 		uint8_t* data = (uint8_t*)image->buffer->data->buffer->b;
@@ -433,6 +1767,34 @@ namespace lime {
 	}
 
 
+	uint64_t ImageDataUtil::Hash (Image* image, Rectangle* rect) {
+
+		// XXH64 of the stored bytes inside rect, row by row, seeded with its size so equal
+		// bytes in a different shape hash differently
+
+		uint8_t* data = (uint8_t*)image->buffer->data->buffer->b;
+		ImageDataView dataView = ImageDataView (image, rect);
+
+		HashState state;
+		hash_init (&state, ((uint64_t)dataView.width << 32) | (uint32_t)dataView.height);
+
+		if (data && dataView.width > 0) {
+
+			int rowLength = dataView.width * 4;
+
+			for (int y = 0; y < dataView.height; y++) {
+
+				hash_update (&state, data + dataView.Row (y), rowLength);
+
+			}
+
+		}
+
+		return hash_digest (&state);
+
+	}
+
+
 	void ImageDataUtil::Merge (Image* image, Image* sourceImage, Rectangle* sourceRect, Vector2* destPoint, int redMultiplier, int greenMultiplier, int blueMultiplier, int alphaMultiplier) {
 
 		ImageDataView sourceView = ImageDataView (sourceImage, sourceRect);
@@ -493,7 +1855,7 @@ namespace lime {
 	}
 
 
-	void ImageDataUtil::Resize (Image* image, ImageBuffer* buffer, int newWidth, int newHeight) {
+	void ImageDataUtil::Resize (Image* image, ImageBuffer* buffer, int newWidth, int newHeight, bool linear) {
 
 		int imageWidth = image->width;
 		int imageHeight = image->height;
@@ -501,6 +1863,13 @@ namespace lime {
 		uint8_t* data = (uint8_t*)image->buffer->data->buffer->b;
 		uint8_t* newData = (uint8_t*)buffer->data->buffer->b;
 
+		if (linear) {
+
+			resize_linear (data, imageWidth, imageHeight, newData, newWidth, newHeight, image->buffer->format);
+			return;
+
+		}
+
 		int sourceIndex, sourceIndexX, sourceIndexY, sourceIndexXY, index;
 		int sourceX, sourceY;
 		float u, v, uRatio, vRatio, uOpposite, vOpposite;
@@ -532,6 +1901,7 @@ namespace lime {
 				newData[index + 2] = int ((data[sourceIndex + 2] * uOpposite + data[sourceIndexX + 2] * uRatio) * vOpposite + (data[sourceIndexY + 2] * uOpposite + data[sourceIndexXY + 2] * uRatio) * vRatio);
 
 				// Maybe it would be better to not weigh colors with an alpha of zero, but the below should help prevent black fringes caused by transparent pixels made visible
+				// (running AlphaBleed on the source at load time removes the cause)
 
 				if (data[sourceIndexX + 3] == 0 || data[sourceIndexY + 3] == 0 || data[sourceIndexXY + 3] == 0) {
 
@@ -0,0 +1,604 @@
+/*
+ * Adapted from earcut (https://github.com/mapbox/earcut)
+ *
+ * ISC License
+ *
+ * Copyright (c) 2016, Mapbox
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+ * IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA
+ * OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#include <math/Polygon.h>
+#include <algorithm>
+#include <deque>
+#include <math.h>
+
+
+namespace lime {
+
+
+	// ear clipping with hole bridging, ported from mapbox/earcut
+
+
+	struct PolygonNode {
+
+		int i;
+		float x;
+		float y;
+		PolygonNode* next;
+		PolygonNode* prev;
+		bool steiner;
+
+	};
+
+
+	typedef std::deque<PolygonNode> PolygonNodes;
+
+
+	static float Area (const PolygonNode* p, const PolygonNode* q, const PolygonNode* r) {
+
+		return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+
+	}
+
+
+	static bool Equals (const PolygonNode* a, const PolygonNode* b) {
+
+		return a->x == b->x && a->y == b->y;
+
+	}
+
+
+	static PolygonNode* InsertNode (PolygonNodes* nodes, int i, float x, float y, PolygonNode* last) {
+
+		PolygonNode node = { i, x, y, 0, 0, false };
+		nodes->push_back (node);
+		PolygonNode* p = &nodes->back ();
+
+		if (!last) {
+
+			p->prev = p;
+			p->next = p;
+
+		} else {
+
+			p->next = last->next;
+			p->prev = last;
+			last->next->prev = p;
+			last->next = p;
+
+		}
+
+		return p;
+
+	}
+
+
+	static void RemoveNode (PolygonNode* p) {
+
+		p->next->prev = p->prev;
+		p->prev->next = p->next;
+
+	}
+
+
+	static bool OnSegment (const PolygonNode* p, const PolygonNode* q, const PolygonNode* r) {
+
+		return q->x <= std::max (p->x, r->x) && q->x >= std::min (p->x, r->x) && q->y <= std::max (p->y, r->y) && q->y >= std::min (p->y, r->y);
+
+	}
+
+
+	static int Sign (float value) {
+
+		return value > 0 ? 1 : value < 0 ? -1 : 0;
+
+	}
+
+
+	static bool Intersects (const PolygonNode* p1, const PolygonNode* q1, const PolygonNode* p2, const PolygonNode* q2) {
+
+		int o1 = Sign (Area (p1, q1, p2));
+		int o2 = Sign (Area (p1, q1, q2));
+		int o3 = Sign (Area (p2, q2, p1));
+		int o4 = Sign (Area (p2, q2, q1));
+
+		if (o1 != o2 && o3 != o4) return true;
+		if (o1 == 0 && OnSegment (p1, p2, q1)) return true;
+		if (o2 == 0 && OnSegment (p1, q2, q1)) return true;
+		if (o3 == 0 && OnSegment (p2, p1, q2)) return true;
+		if (o4 == 0 && OnSegment (p2, q1, q2)) return true;
+
+		return false;
+
+	}
+
+
+	static bool IntersectsPolygon (const PolygonNode* a, const PolygonNode* b) {
+
+		const PolygonNode* p = a;
+
+		do {
+
+			if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i && Intersects (p, p->next, a, b)) {
+
+				return true;
+
+			}
+
+			p = p->next;
+
+		} while (p != a);
+
+		return false;
+
+	}
+
+
+	static bool LocallyInside (const PolygonNode* a, const PolygonNode* b) {
+
+		if (Area (a->prev, a, a->next) < 0) {
+
+			return Area (a, b, a->next) >= 0 && Area (a, a->prev, b) >= 0;
+
+		} else {
+
+			return Area (a, b, a->prev) < 0 || Area (a, a->next, b) < 0;
+
+		}
+
+	}
+
+
+	static bool MiddleInside (const PolygonNode* a, const PolygonNode* b) {
+
+		const PolygonNode* p = a;
+		bool inside = false;
+		float px = (a->x + b->x) / 2;
+		float py = (a->y + b->y) / 2;
+
+		do {
+
+			if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y && (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x)) {
+
+				inside = !inside;
+
+			}
+
+			p = p->next;
+
+		} while (p != a);
+
+		return inside;
+
+	}
+
+
+	static bool PointInTriangle (float ax, float ay, float bx, float by, float cx, float cy, float px, float py) {
+
+		return (cx - px) * (ay - py) >= (ax - px) * (cy - py) && (ax - px) * (by - py) >= (bx - px) * (ay - py) && (bx - px) * (cy - py) >= (cx - px) * (by - py);
+
+	}
+
+
+	static bool IsValidDiagonal (const PolygonNode* a, const PolygonNode* b) {
+
+		if (a->next->i == b->i || a->prev->i == b->i || IntersectsPolygon (a, b)) {
+
+			return false;
+
+		}
+
+		if (LocallyInside (a, b) && LocallyInside (b, a) && MiddleInside (a, b) && (Area (a->prev, a, b->prev) != 0 || Area (a, b->prev, b) != 0)) {
+
+			return true;
+
+		}
+
+		return Equals (a, b) && Area (a->prev, a, a->next) > 0 && Area (b->prev, b, b->next) > 0;
+
+	}
+
+
+	static PolygonNode* FilterPoints (PolygonNode* start, PolygonNode* end) {
+
+		// removes duplicate and collinear points
+
+		if (!start) return start;
+		if (!end) end = start;
+
+		PolygonNode* p = start;
+		bool again;
+
+		do {
+
+			again = false;
+
+			if (!p->steiner && (Equals (p, p->next) || Area (p->prev, p, p->next) == 0)) {
+
+				RemoveNode (p);
+				p = end = p->prev;
+
+				if (p == p->next) break;
+				again = true;
+
+			} else {
+
+				p = p->next;
+
+			}
+
+		} while (again || p != end);
+
+		return end;
+
+	}
+
+
+	static PolygonNode* SplitPolygon (PolygonNodes* nodes, PolygonNode* a, PolygonNode* b) {
+
+		// links a and b with a bridge, returning the node that starts the second polygon
+
+		PolygonNode a2 = { a->i, a->x, a->y, 0, 0, false };
+		PolygonNode b2 = { b->i, b->x, b->y, 0, 0, false };
+		nodes->push_back (a2);
+		PolygonNode* _a2 = &nodes->back ();
+		nodes->push_back (b2);
+		PolygonNode* _b2 = &nodes->back ();
+
+		PolygonNode* an = a->next;
+		PolygonNode* bp = b->prev;
+
+		a->next = b;
+		b->prev = a;
+
+		_a2->next = an;
+		an->prev = _a2;
+
+		_b2->next = _a2;
+		_a2->prev = _b2;
+
+		bp->next = _b2;
+		_b2->prev = bp;
+
+		return _b2;
+
+	}
+
+
+	static bool IsEar (const PolygonNode* ear) {
+
+		const PolygonNode* a = ear->prev;
+		const PolygonNode* b = ear;
+		const PolygonNode* c = ear->next;
+
+		if (Area (a, b, c) >= 0) return false;
+
+		const PolygonNode* p = c->next;
+
+		while (p != a) {
+
+			if (PointInTriangle (a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) && Area (p->prev, p, p->next) >= 0) {
+
+				return false;
+
+			}
+
+			p = p->next;
+
+		}
+
+		return true;
+
+	}
+
+
+	static void EarcutLinked (PolygonNodes* nodes, PolygonNode* ear, std::vector<int>* triangles, int pass);
+
+
+	static PolygonNode* CureLocalIntersections (PolygonNode* start, std::vector<int>* triangles) {
+
+		PolygonNode* p = start;
+
+		do {
+
+			PolygonNode* a = p->prev;
+			PolygonNode* b = p->next->next;
+
+			if (!Equals (a, b) && Intersects (a, p, p->next, b) && LocallyInside (a, b) && LocallyInside (b, a)) {
+
+				triangles->push_back (a->i);
+				triangles->push_back (p->i);
+				triangles->push_back (b->i);
+
+				RemoveNode (p);
+				RemoveNode (p->next);
+
+				p = start = b;
+
+			}
+
+			p = p->next;
+
+		} while (p != start);
+
+		return FilterPoints (p, 0);
+
+	}
+
+
+	static void SplitEarcut (PolygonNodes* nodes, PolygonNode* start, std::vector<int>* triangles) {
+
+		// last resort, split the polygon along a valid diagonal and clip both halves
+
+		PolygonNode* a = start;
+
+		do {
+
+			PolygonNode* b = a->next->next;
+
+			while (b != a->prev) {
+
+				if (a->i != b->i && IsValidDiagonal (a, b)) {
+
+					PolygonNode* c = SplitPolygon (nodes, a, b);
+
+					a = FilterPoints (a, a->next);
+					c = FilterPoints (c, c->next);
+
+					EarcutLinked (nodes, a, triangles, 0);
+					EarcutLinked (nodes, c, triangles, 0);
+					return;
+
+				}
+
+				b = b->next;
+
+			}
+
+			a = a->next;
+
+		} while (a != start);
+
+	}
+
+
+	static void EarcutLinked (PolygonNodes* nodes, PolygonNode* ear, std::vector<int>* triangles, int pass) {
+
+		if (!ear) return;
+
+		PolygonNode* stop = ear;
+
+		while (ear->prev != ear->next) {
+
+			PolygonNode* prev = ear->prev;
+			PolygonNode* next = ear->next;
+
+			if (IsEar (ear)) {
+
+				triangles->push_back (prev->i);
+				triangles->push_back (ear->i);
+				triangles->push_back (next->i);
+
+				RemoveNode (ear);
+
+				// skipping the next vertex leaves fewer sliver triangles
+
+				ear = next->next;
+				stop = next->next;
+				continue;
+
+			}
+
+			ear = next;
+
+			if (ear == stop) {
+
+				if (pass == 0) {
+
+					EarcutLinked (nodes, FilterPoints (ear, 0), triangles, 1);
+
+				} else if (pass == 1) {
+
+					ear = CureLocalIntersections (FilterPoints (ear, 0), triangles);
+					EarcutLinked (nodes, ear, triangles, 2);
+
+				} else {
+
+					SplitEarcut (nodes, ear, triangles);
+
+				}
+
+				break;
+
+			}
+
+		}
+
+	}
+
+
+	static PolygonNode* FindHoleBridge (PolygonNode* hole, PolygonNode* outerNode) {
+
+		// find a segment of the outer ring to the left of the hole's leftmost point
+
+		PolygonNode* p = outerNode;
+		float hx = hole->x;
+		float hy = hole->y;
+		float qx = -INFINITY;
+		PolygonNode* m = 0;
+
+		do {
+
+			if (hy <= p->y && hy >= p->next->y && p->next->y != p->y) {
+
+				float x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+
+				if (x <= hx && x > qx) {
+
+					qx = x;
+					m = p->x < p->next->x ? p : p->next;
+
+					if (x == hx) return m;
+
+				}
+
+			}
+
+			p = p->next;
+
+		} while (p != outerNode);
+
+		if (!m) return 0;
+
+		// of the points inside the triangle formed with that segment, connect to the one at the smallest angle
+
+		PolygonNode* stop = m;
+		float mx = m->x;
+		float my = m->y;
+		float tanMin = INFINITY;
+
+		p = m;
+
+		do {
+
+			if (hx >= p->x && p->x >= mx && hx != p->x && PointInTriangle (hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)) {
+
+				float tan = fabsf (hy - p->y) / (hx - p->x);
+
+				if (LocallyInside (p, hole) && (tan < tanMin || (tan == tanMin && (p->x > m->x || (p->x == m->x && Area (m->prev, m, p->prev) < 0 && Area (p->next, m, m->next) < 0))))) {
+
+					m = p;
+					tanMin = tan;
+
+				}
+
+			}
+
+			p = p->next;
+
+		} while (p != stop);
+
+		return m;
+
+	}
+
+
+	static PolygonNode* GetLeftmost (PolygonNode* start) {
+
+		PolygonNode* p = start;
+		PolygonNode* leftmost = start;
+
+		do {
+
+			if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y)) leftmost = p;
+			p = p->next;
+
+		} while (p != start);
+
+		return leftmost;
+
+	}
+
+
+	static PolygonNode* LinkedList (PolygonNodes* nodes, const float* points, int start, int end, bool clockwise) {
+
+		float area = 0;
+
+		for (int i = start, j = end - 1; i < end; j = i++) {
+
+			area += (points[j * 2] - points[i * 2]) * (points[i * 2 + 1] + points[j * 2 + 1]);
+
+		}
+
+		PolygonNode* last = 0;
+
+		if (clockwise == (area > 0)) {
+
+			for (int i = start; i < end; i++) last = InsertNode (nodes, i, points[i * 2], points[i * 2 + 1], last);
+
+		} else {
+
+			for (int i = end - 1; i >= start; i--) last = InsertNode (nodes, i, points[i * 2], points[i * 2 + 1], last);
+
+		}
+
+		if (last && Equals (last, last->next)) {
+
+			RemoveNode (last);
+			last = last->next;
+
+		}
+
+		return last;
+
+	}
+
+
+	static bool CompareX (const PolygonNode* a, const PolygonNode* b) {
+
+		return a->x < b->x;
+
+	}
+
+
+	void Polygon::Triangulate (const float* points, const int* rings, int numRings, std::vector<int>* triangles) {
+
+		// rings holds a start and end point index for each ring, the first ring is the outline and the rest are holes
+
+		if (numRings <= 0) return;
+
+		PolygonNodes nodes;
+		PolygonNode* outerNode = LinkedList (&nodes, points, rings[0], rings[1], true);
+
+		if (!outerNode || outerNode->next == outerNode->prev) return;
+
+		if (numRings > 1) {
+
+			std::vector<PolygonNode*> queue;
+
+			for (int i = 1; i < numRings; i++) {
+
+				PolygonNode* list = LinkedList (&nodes, points, rings[i * 2], rings[i * 2 + 1], false);
+
+				if (!list) continue;
+				if (list == list->next) list->steiner = true;
+
+				queue.push_back (GetLeftmost (list));
+
+			}
+
+			std::sort (queue.begin (), queue.end (), CompareX);
+
+			for (size_t i = 0; i < queue.size (); i++) {
+
+				PolygonNode* bridge = FindHoleBridge (queue[i], outerNode);
+
+				if (bridge) {
+
+					PolygonNode* bridgeReverse = SplitPolygon (&nodes, bridge, queue[i]);
+					FilterPoints (bridgeReverse, bridgeReverse->next);
+					outerNode = FilterPoints (bridge, bridge->next);
+
+				}
+
+			}
+
+		}
+
+		EarcutLinked (&nodes, outerNode, triangles, 0);
+
+	}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <system/Parallel.h>
+#include <system/System.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+namespace lime {
+
+
+	struct ParallelJob {
+
+		std::atomic<int> next;
+		int count;
+		ParallelTask task;
+		void* userData;
+
+	};
+
+
+	static void ParallelRun (ParallelJob* job) {
+
+		int index;
+
+		while ((index = job->next.fetch_add (1)) < job->count) {
+
+			job->task (index, job->userData);
+
+		}
+
+	}
+
+
+	static void ParallelWorker (ParallelJob* job) {
+
+		System::GCIgnoreThread ();
+		ParallelRun (job);
+
+	}
+
+
+	void Parallel::For (int count, int numThreads, ParallelTask task, void* userData) {
+
+		if (count <= 0) return;
+
+		if (numThreads <= 0) {
+
+			numThreads = GetConcurrency ();
+
+		}
+
+		if (numThreads > count) {
+
+			numThreads = count;
+
+		}
+
+		ParallelJob job;
+		job.next = 0;
+		job.count = count;
+		job.task = task;
+		job.userData = userData;
+
+		if (numThreads <= 1) {
+
+			ParallelRun (&job);
+			return;
+
+		}
+
+		// the calling thread takes a share of the work, tasks must not touch GC values
+
+		System::GCEnterBlocking ();
+
+		std::vector<std::thread> threads;
+
+		for (int i = 1; i < numThreads; i++) {
+
+			threads.push_back (std::thread (ParallelWorker, &job));
+
+		}
+
+		ParallelRun (&job);
+
+		for (size_t i = 0; i < threads.size (); i++) {
+
+			threads[i].join ();
+
+		}
+
+		System::GCExitBlocking ();
+
+	}
+
+
+	int Parallel::GetConcurrency () {
+
+		int concurrency = std::thread::hardware_concurrency ();
+		return concurrency > 0 ? concurrency : 1;
+
+	}
+
+
+}
\ No newline at end of file
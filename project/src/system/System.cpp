@@ -19,10 +19,12 @@ namespace lime {
 	bool System::_isHL = false;
 	#endif
 
+	thread_local bool System::_isUnmanagedThread = false;
+
 
 	void System::GCEnterBlocking () {
 
-		if (!_isHL) {
+		if (!_isHL && !_isUnmanagedThread) {
 
 			gc_enter_blocking ();
 
@@ -33,7 +35,7 @@ namespace lime {
 
 	void System::GCExitBlocking () {
 
-		if (!_isHL) {
+		if (!_isHL && !_isUnmanagedThread) {
 
 			gc_exit_blocking ();
 
@@ -42,9 +44,19 @@ namespace lime {
 	}
 
 
+	void System::GCIgnoreThread () {
+
+		// native worker threads are never registered with the GC, so blocking
+		// calls made while they read files must not reach it
+
+		_isUnmanagedThread = true;
+
+	}
+
+
 	void System::GCTryEnterBlocking () {
 
-		if (!_isHL) {
+		if (!_isHL && !_isUnmanagedThread) {
 
 			// TODO: Only supported in HXCPP 4.3
 			// gc_try_blocking ();
@@ -56,7 +68,7 @@ namespace lime {
 
 	void System::GCTryExitBlocking () {
 
-		if (!_isHL) {
+		if (!_isHL && !_isUnmanagedThread) {
 
 			// TODO: Only supported in HXCPP 4.3
 			//gc_try_unblocking ();
@@ -1,19 +1,27 @@
 #include <text/Font.h>
 #include <graphics/ImageBuffer.h>
+#include <math/Polygon.h>
+#include <system/Parallel.h>
 #include <system/System.h>
 
 #include <algorithm>
+#include <atomic>
 #include <list>
+#include <math.h>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #ifdef LIME_FREETYPE
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_BITMAP_H
+#include FT_CACHE_H
 #include FT_SFNT_NAMES_H
 #include FT_TRUETYPE_IDS_H
 #include FT_TRUETYPE_TABLES_H
 #include FT_GLYPH_H
+#include FT_MODULE_H
 #include FT_OUTLINE_H
 #endif
 
@@ -21,6 +29,12 @@
 #undef GetGlyphIndices
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) && defined (__aarch64__)
+#include <arm_neon.h>
+#endif
+
 
 // from http://stackoverflow.com/questions/2948308/how-do-i-read-utf-8-characters-via-a-pointer
 #define IS_IN_RANGE(c, f, l) (((c) >= (f)) && ((c) <= (l)))
@@ -98,8 +112,7 @@ unsigned long readNextChar (const char*& p)
 				c2 = ptr[1];
 
 				if (((c1 == 0xE0) && !IS_IN_RANGE(c2, 0xA0, 0xBF)) ||
-					 ((c1 == 0xED) && !IS_IN_RANGE(c2, 0x80, 0x9F)) ||
-					 (!IS_IN_RANGE(c1, 0xE1, 0xEC) && !IS_IN_RANGE(c1, 0xEE, 0xEF))) {
+					 ((c1 == 0xED) && !IS_IN_RANGE(c2, 0x80, 0x9F))) {
 
 					 // malformed data, do something !!!
 					 return (unsigned long) -1;
@@ -113,7 +126,7 @@ unsigned long readNextChar (const char*& p)
 
 				if (((c1 == 0xF0) && !IS_IN_RANGE(c2, 0x90, 0xBF)) ||
 					 ((c1 == 0xF4) && !IS_IN_RANGE(c2, 0x80, 0x8F)) ||
-					 !IS_IN_RANGE(c1, 0xF1, 0xF3)) {
+					 (c1 > 0xF4)) {
 
 					 // malformed data, do something !!!
 					 return (unsigned long) -1;
@@ -266,1099 +279,2456 @@ namespace {
 	}
 
 
-}
-
+	struct outline_path {
 
-namespace lime {
+		std::vector<unsigned char> commands;
+		std::vector<int> contours;
+		std::vector<float> points;
+		int start;
+		float tolerance;
+		float x, y;
 
+		outline_path (float tolerance) : start (0), tolerance (tolerance), x (0), y (0) { }
 
-	static int id_buffer;
-	static int id_charCode;
-	static int id_codepoint;
-	static int id_height;
-	static int id_index;
-	static int id_horizontalAdvance;
-	static int id_horizontalBearingX;
-	static int id_horizontalBearingY;
-	static int id_image;
-	static int id_offset;
-	static int id_offsetX;
-	static int id_offsetY;
-	static int id_size;
-	static int id_verticalAdvance;
-	static int id_verticalBearingX;
-	static int id_verticalBearingY;
-	static int id_width;
-	static int id_x;
-	static int id_y;
-	static bool init = false;
+	};
 
 
-	static void initialize () {
+	void path_close (outline_path *p) {
 
-		if (!init) {
+		// flattened contours are kept as start and end point pairs, dropping the closing point and any contour too small to fill
 
-			id_width = val_id ("width");
-			id_height = val_id ("height");
-			id_x = val_id ("x");
-			id_y = val_id ("y");
-			id_offset = val_id ("offset");
-			id_size = val_id ("size");
-			id_codepoint = val_id ("codepoint");
+		int end = p->points.size () / 2;
 
-			id_buffer = val_id ("buffer");
-			id_charCode = val_id ("charCode");
-			id_horizontalAdvance = val_id ("horizontalAdvance");
-			id_horizontalBearingX = val_id ("horizontalBearingX");
-			id_horizontalBearingY = val_id ("horizontalBearingY");
-			id_image = val_id ("image");
-			id_index = val_id ("index");
-			id_offsetX = val_id ("offsetX");
-			id_offsetY = val_id ("offsetY");
-			id_verticalAdvance = val_id ("verticalAdvance");
-			id_verticalBearingX = val_id ("verticalBearingX");
-			id_verticalBearingY = val_id ("verticalBearingY");
+		if (p->tolerance <= 0 || end == p->start) {
 
-			init = true;
+			return;
 
 		}
 
-	}
-
-
-	Font::Font (Resource *resource, int faceIndex) {
+		if (end - p->start > 1 && p->points[end * 2 - 2] == p->points[p->start * 2] && p->points[end * 2 - 1] == p->points[p->start * 2 + 1]) {
 
-		this->library = 0;
-		this->face = 0;
-		this->faceMemory = 0;
+			end--;
 
-		if (resource) {
+		}
 
-			int error;
-			FT_Library library;
+		if (end - p->start >= 3) {
 
-			error = FT_Init_FreeType (&library);
+			p->contours.push_back (p->start);
+			p->contours.push_back (end);
 
-			if (error) {
+		} else {
 
-				printf ("Could not initialize FreeType\n");
+			end = p->start;
 
-			} else {
+		}
 
-				FT_Face face;
-				FILE_HANDLE *file = NULL;
-				unsigned char *faceMemory = NULL;
+		p->points.resize (end * 2);
+		p->start = end;
 
-				if (resource->path) {
+	}
 
-					file = lime::fopen (resource->path, "rb");
 
-					if (!file) {
+	int path_segments (float deviation, float tolerance) {
 
-						FT_Done_FreeType (library);
-						return;
+		int segments = (int)ceilf (sqrtf (deviation / tolerance));
+		return segments < 1 ? 1 : segments > 64 ? 64 : segments;
 
-					}
+	}
 
-					if (file->isFile ()) {
 
-						error = FT_New_Face (library, resource->path, faceIndex, &face);
+	void path_point (outline_path *p, float x, float y) {
 
-					} else {
+		p->points.push_back (x);
+		p->points.push_back (y);
 
-						Bytes data;
-						data.ReadFile (resource->path);
-						faceMemory = (unsigned char*)malloc (data.length);
-						memcpy (faceMemory, data.b, data.length);
+	}
 
-						lime::fclose (file);
-						file = 0;
 
-						error = FT_New_Memory_Face (library, faceMemory, data.length, faceIndex, &face);
+	int path_move_to (FVecPtr to, void *user) {
 
-					}
+		outline_path *p = static_cast<outline_path*> (user);
 
-				} else {
+		path_close (p);
+		p->start = p->points.size () / 2;
 
-					faceMemory = (unsigned char*)malloc (resource->data->length);
-					memcpy (faceMemory, resource->data->b, resource->data->length);
-					error = FT_New_Memory_Face (library, faceMemory, resource->data->length, faceIndex, &face);
+		if (p->tolerance <= 0) p->commands.push_back (PT_MOVE);
+		path_point (p, to->x, to->y);
 
-				}
+		p->x = to->x;
+		p->y = to->y;
 
-				if (file) {
+		return 0;
 
-					lime::fclose (file);
-					file = 0;
+	}
 
-				}
 
-				if (!error) {
+	int path_line_to (FVecPtr to, void *user) {
 
-					this->library = library;
-					this->face = face;
-					this->faceMemory = faceMemory;
+		outline_path *p = static_cast<outline_path*> (user);
 
-					/* Set charmap
-					 *
-					 * See http://www.microsoft.com/typography/otspec/name.htm for a list of
-					 * some possible platform-encoding pairs.  We're interested in 0-3 aka 3-1
-					 * - UCS-2.  Otherwise, fail. If a font has some unicode map, but lacks
-					 * UCS-2 - it is a broken or irrelevant font. What exactly Freetype will
-					 * select on face load (it promises most wide unicode, and if that will be
-					 * slower that UCS-2 - left as an excercise to check.
-					 */
-					for (int i = 0; i < ((FT_Face)face)->num_charmaps; i++) {
+		if (p->tolerance <= 0) p->commands.push_back (PT_LINE);
+		path_point (p, to->x, to->y);
 
-						FT_UShort pid = ((FT_Face)face)->charmaps[i]->platform_id;
-						FT_UShort eid = ((FT_Face)face)->charmaps[i]->encoding_id;
+		p->x = to->x;
+		p->y = to->y;
 
-						if (((pid == 0) && (eid == 3)) || ((pid == 3) && (eid == 1))) {
+		return 0;
 
-							FT_Set_Charmap ((FT_Face)face, ((FT_Face)face)->charmaps[i]);
+	}
 
-						}
 
-					}
+	int path_conic_to (FVecPtr ctl, FVecPtr to, void *user) {
 
-				} else {
+		outline_path *p = static_cast<outline_path*> (user);
 
-					FT_Done_FreeType (library);
-					free (faceMemory);
+		if (p->tolerance <= 0) {
 
-				}
+			p->commands.push_back (PT_CURVE);
+			path_point (p, ctl->x, ctl->y);
+			path_point (p, to->x, to->y);
 
-			}
+		} else {
 
-		}
+			// the chord error of n segments is at most |p0 - 2p1 + p2| / (4n^2)
 
-	}
+			float dx = p->x - 2.0f * ctl->x + to->x;
+			float dy = p->y - 2.0f * ctl->y + to->y;
+			int segments = path_segments (sqrtf (dx * dx + dy * dy) / 4.0f, p->tolerance);
 
+			for (int i = 1; i <= segments; i++) {
 
-	Font::~Font () {
+				float t = (float)i / segments;
+				float mt = 1.0f - t;
 
-		if (library) {
+				path_point (p, mt * mt * p->x + 2.0f * mt * t * ctl->x + t * t * to->x, mt * mt * p->y + 2.0f * mt * t * ctl->y + t * t * to->y);
 
-			FT_Done_FreeType ((FT_Library)library);
-			library = 0;
-			face = 0;
+			}
 
 		}
 
-		free (faceMemory);
-		faceMemory = 0;
+		p->x = to->x;
+		p->y = to->y;
 
-	}
+		return 0;
 
+	}
 
-	void* Font::Decompose (bool useCFFIValue, int em) {
 
-		int result, i, j;
+	int path_cubic_to (FVecPtr control1, FVecPtr control2, FVecPtr to, void *user) {
 
-		FT_Set_Char_Size ((FT_Face)face, em, em, 72, 72);
-		FT_Set_Transform ((FT_Face)face, 0, NULL);
+		outline_path *p = static_cast<outline_path*> (user);
 
-		std::vector<glyph*> glyphs;
+		if (p->tolerance <= 0) {
 
-		FT_Outline_Funcs ofn =
-		{
-			outline_move_to,
-			outline_line_to,
-			outline_conic_to,
-			outline_cubic_to,
-			0, // shift
-			0  // delta
-		};
+			p->commands.push_back (PT_CUBIC);
+			path_point (p, control1->x, control1->y);
+			path_point (p, control2->x, control2->y);
+			path_point (p, to->x, to->y);
 
-		// Import every character in face
-		FT_ULong char_code;
-		FT_UInt glyph_index;
+		} else {
 
-		char_code = FT_Get_First_Char ((FT_Face)face, &glyph_index);
+			float dx1 = p->x - 2.0f * control1->x + control2->x;
+			float dy1 = p->y - 2.0f * control1->y + control2->y;
+			float dx2 = control1->x - 2.0f * control2->x + to->x;
+			float dy2 = control1->y - 2.0f * control2->y + to->y;
+			float deviation = sqrtf (std::max (dx1 * dx1 + dy1 * dy1, dx2 * dx2 + dy2 * dy2)) * 3.0f / 4.0f;
+			int segments = path_segments (deviation, p->tolerance);
 
-		while (glyph_index != 0) {
+			for (int i = 1; i <= segments; i++) {
 
-			if (FT_Load_Glyph ((FT_Face)face, glyph_index, FT_LOAD_NO_BITMAP | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_DEFAULT) == 0) {
+				float t = (float)i / segments;
+				float mt = 1.0f - t;
+				float a = mt * mt * mt, b = 3.0f * mt * mt * t, c = 3.0f * mt * t * t, d = t * t * t;
 
-				glyph *g = new glyph;
-				result = FT_Outline_Decompose (&((FT_Face)face)->glyph->outline, &ofn, g);
+				path_point (p, a * p->x + b * control1->x + c * control2->x + d * to->x, a * p->y + b * control1->y + c * control2->y + d * to->y);
 
-				if (result == 0) {
+			}
 
-					g->index = glyph_index;
-					g->char_code = char_code;
-					g->metrics = ((FT_Face)face)->glyph->metrics;
-					glyphs.push_back (g);
+		}
 
-				} else {
+		p->x = to->x;
+		p->y = to->y;
 
-					delete g;
+		return 0;
 
-				}
+	}
 
-			}
 
-			char_code = FT_Get_Next_Char ((FT_Face)face, char_code, &glyph_index);
+	float ring_area (const float* points, int start, int end) {
 
-		}
+		float area = 0;
 
-		// Ascending sort by character codes
-		std::sort (glyphs.begin (), glyphs.end (), glyph_sort_predicate ());
+		for (int i = start, j = end - 1; i < end; j = i++) {
 
-		std::vector<kerning>  kern;
-		if (FT_HAS_KERNING (((FT_Face)face))) {
+			area += (points[j * 2] - points[i * 2]) * (points[i * 2 + 1] + points[j * 2 + 1]);
 
-			int n = glyphs.size ();
-			FT_Vector v;
+		}
 
-			for (i = 0; i < n; i++) {
+		return area;
 
-				int  l_glyph = glyphs[i]->index;
+	}
 
-				for (j = 0; j < n; j++) {
 
-					int r_glyph = glyphs[j]->index;
+	bool ring_contains (const float* points, int start, int end, float x, float y) {
 
-					FT_Get_Kerning ((FT_Face)face, l_glyph, r_glyph, FT_KERNING_DEFAULT, &v);
+		bool inside = false;
 
-					if (v.x != 0 || v.y != 0) {
+		for (int i = start, j = end - 1; i < end; j = i++) {
 
-						kern.push_back (kerning (i, j, v.x, v.y));
+			float xi = points[i * 2], yi = points[i * 2 + 1];
+			float xj = points[j * 2], yj = points[j * 2 + 1];
 
-					}
+			if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
 
-				}
+				inside = !inside;
 
 			}
 
 		}
 
-		int num_glyphs = glyphs.size ();
+		return inside;
 
-		wchar_t* family_name = GetFamilyName ();
+	}
 
-		#ifdef LIME_FREETYPE_SWF_METRICS
 
-		// this should more closely match how [Embed] works in AS3 when
-		// embedding a font in a SWF
+	void triangulate_contours (const std::vector<float>& points, const std::vector<int>& contours, int firstContour, std::vector<int>* triangles) {
 
-		int calculatedAscender = 0;
-		int calculatedDescender = 0;
-		int calculatedHeight = 0;
+		// contours wound like the largest one are outlines, the rest are holes of the smallest outline around them
 
-		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
-		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+		int numContours = (contours.size () - firstContour * 2) / 2;
 
-		if (os2 && os2->version != 0xFFFFU) {
+		if (numContours <= 0) {
 
-			calculatedAscender = (FT_Short)os2->usWinAscent;
-			calculatedDescender = -(FT_Short)os2->usWinDescent;
-			calculatedHeight = calculatedAscender - calculatedDescender;
+			return;
 
-		} else if (hhea) {
+		}
 
-			calculatedAscender = hhea->Ascender;
-			calculatedDescender = hhea->Descender;
-			calculatedHeight = calculatedAscender - calculatedDescender + hhea->Line_Gap;
+		const int* ring = &contours[firstContour * 2];
+		std::vector<float> areas (numContours);
+		int largest = 0;
 
-		} else {
+		for (int i = 0; i < numContours; i++) {
 
-			// should never happen, but let's have a fallback to be safe
-			calculatedAscender = ((FT_Face)face)->ascender;
-			calculatedDescender = ((FT_Face)face)->descender;
-			calculatedHeight = ((FT_Face)face)->height;
+			areas[i] = ring_area (&points[0], ring[i * 2], ring[i * 2 + 1]);
+			if (fabsf (areas[i]) > fabsf (areas[largest])) largest = i;
 
 		}
 
-		#elif defined(LIME_FREETYPE_LEGACY_METRICS)
+		bool clockwise = areas[largest] > 0;
+		std::vector<int> owners (numContours, -1);
 
-		// this is FreeType's font metrics algorithm from 2.9.1
-		// it behaves more like SWF than the new algorithm
+		for (int i = 0; i < numContours; i++) {
 
-		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
-		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+			if (areas[i] == 0 || (areas[i] > 0) == clockwise) continue;
 
-		int calculatedAscender = 0;
-		int calculatedDescender = 0;
-		int calculatedHeight = 0;
+			for (int j = 0; j < numContours; j++) {
 
-		if (hhea) {
+				if (areas[j] == 0 || (areas[j] > 0) != clockwise) continue;
 
-			calculatedAscender = hhea->Ascender;
-			calculatedDescender = hhea->Descender;
-			calculatedHeight = calculatedAscender - calculatedDescender + hhea->Line_Gap;
+				if ((owners[i] < 0 || fabsf (areas[j]) < fabsf (areas[owners[i]])) && ring_contains (&points[0], ring[j * 2], ring[j * 2 + 1], points[ring[i * 2] * 2], points[ring[i * 2] * 2 + 1])) {
+
+					owners[i] = j;
+
+				}
+
+			}
 
 		}
 
-        if (!( calculatedAscender || calculatedDescender ))
-        {
-			if (os2 && os2->version != 0xFFFFU)
-			{
-				if (os2->sTypoAscender || os2->sTypoDescender)
-				{
+		std::vector<int> rings;
 
-					calculatedAscender = os2->sTypoAscender;
-					calculatedDescender = os2->sTypoDescender;
-					calculatedHeight = calculatedAscender - calculatedDescender + os2->sTypoLineGap;
+		for (int i = 0; i < numContours; i++) {
 
-				}
-				else
-				{
+			if (areas[i] == 0 || (areas[i] > 0) != clockwise) continue;
 
-					calculatedAscender = (FT_Short)os2->usWinAscent;
-					calculatedDescender = -(FT_Short)os2->usWinDescent;
-					calculatedHeight = calculatedAscender - calculatedDescender;
+			rings.clear ();
+			rings.push_back (ring[i * 2]);
+			rings.push_back (ring[i * 2 + 1]);
+
+			for (int j = 0; j < numContours; j++) {
+
+				if (owners[j] == i) {
+
+					rings.push_back (ring[j * 2]);
+					rings.push_back (ring[j * 2 + 1]);
 
 				}
-			}
-        }
 
-		if (!calculatedAscender || !calculatedDescender) {
+			}
 
-			calculatedAscender = ((FT_Face)face)->ascender;
-			calculatedDescender = ((FT_Face)face)->descender;
-			calculatedHeight = ((FT_Face)face)->height;
+			lime::Polygon::Triangulate (&points[0], &rings[0], rings.size () / 2, triangles);
 
 		}
 
-		#else
+	}
 
-		int calculatedAscender = ((FT_Face)face)->ascender;
-		int calculatedDescender = ((FT_Face)face)->descender;
-		int calculatedHeight = ((FT_Face)face)->height;
 
-		#endif
+}
 
-		if (useCFFIValue) {
 
-			value ret = alloc_empty_object ();
-			alloc_field (ret, val_id ("has_kerning"), alloc_bool (FT_HAS_KERNING (((FT_Face)face))));
-			alloc_field (ret, val_id ("is_fixed_width"), alloc_bool (FT_IS_FIXED_WIDTH (((FT_Face)face))));
-			alloc_field (ret, val_id ("has_glyph_names"), alloc_bool (FT_HAS_GLYPH_NAMES (((FT_Face)face))));
-			alloc_field (ret, val_id ("is_italic"), alloc_bool (((FT_Face)face)->style_flags & FT_STYLE_FLAG_ITALIC));
-			alloc_field (ret, val_id ("is_bold"), alloc_bool (((FT_Face)face)->style_flags & FT_STYLE_FLAG_BOLD));
-			alloc_field (ret, val_id ("num_glyphs"), alloc_int (num_glyphs));
-			alloc_field (ret, val_id ("family_name"), family_name == NULL ? alloc_string (((FT_Face)face)->family_name) : alloc_wstring (family_name));
-			alloc_field (ret, val_id ("style_name"), alloc_string (((FT_Face)face)->style_name));
-			alloc_field (ret, val_id ("em_size"), alloc_int (((FT_Face)face)->units_per_EM));
-			alloc_field (ret, val_id ("ascend"), alloc_int (calculatedAscender));
-			alloc_field (ret, val_id ("descend"), alloc_int (calculatedDescender));
-			alloc_field (ret, val_id ("height"), alloc_int (calculatedHeight));
+namespace lime {
 
-			delete family_name;
+
+	static int id_buffer;
+	static int id_charCode;
+	static int id_codepoint;
+	static int id_height;
+	static int id_index;
+	static int id_horizontalAdvance;
+	static int id_horizontalBearingX;
+	static int id_horizontalBearingY;
+	static int id_image;
+	static int id_offset;
+	static int id_offsetX;
+	static int id_offsetY;
+	static int id_size;
+	static int id_verticalAdvance;
+	static int id_verticalBearingX;
+	static int id_verticalBearingY;
+	static int id_width;
+	static int id_x;
+	static int id_y;
+	static bool init = false;
+
+
+	static void initialize () {
+
+		if (!init) {
+
+			id_width = val_id ("width");
+			id_height = val_id ("height");
+			id_x = val_id ("x");
+			id_y = val_id ("y");
+			id_offset = val_id ("offset");
+			id_size = val_id ("size");
+			id_codepoint = val_id ("codepoint");
+
+			id_buffer = val_id ("buffer");
+			id_charCode = val_id ("charCode");
+			id_horizontalAdvance = val_id ("horizontalAdvance");
+			id_horizontalBearingX = val_id ("horizontalBearingX");
+			id_horizontalBearingY = val_id ("horizontalBearingY");
+			id_image = val_id ("image");
+			id_index = val_id ("index");
+			id_offsetX = val_id ("offsetX");
+			id_offsetY = val_id ("offsetY");
+			id_verticalAdvance = val_id ("verticalAdvance");
+			id_verticalBearingX = val_id ("verticalBearingX");
+			id_verticalBearingY = val_id ("verticalBearingY");
+
+			init = true;
+
+		}
+
+	}
+
+
+	static FTC_ImageCache cacheImages = 0;
+	static FTC_Manager cacheManager = 0;
+	static FTC_SBitCache cacheSBits = 0;
+	static int cacheBudget = 0x200000;
+	static FT_Library sharedLibrary = 0;
+	static int sharedLibraryRefs = 0;
+	static std::recursive_mutex sharedLibraryMutex;
+	static std::atomic<unsigned long long> nextFontID (1);
+
+
+	static FT_Error cache_request_face (FTC_FaceID faceID, FT_Library, FT_Pointer, FT_Face* face) {
+
+		// the cache gets a face of its own, so its sizes never change the scale of the Font's face
+
+		*face = (FT_Face)((Font*)faceID)->NewFace ();
+		return *face ? 0 : FT_Err_Cannot_Open_Resource;
+
+	}
+
+
+	static bool cache_open () {
+
+		if (!cacheManager && sharedLibrary) {
+
+			if (FTC_Manager_New (sharedLibrary, 16, 32, cacheBudget, cache_request_face, NULL, &cacheManager) != 0) {
+
+				cacheManager = 0;
+				return false;
+
+			}
+
+			// outlines for anything rasterized here, sbits for the small A8 and mono glyphs FreeType renders itself
+
+			if (FTC_ImageCache_New (cacheManager, &cacheImages) != 0 || FTC_SBitCache_New (cacheManager, &cacheSBits) != 0) {
+
+				FTC_Manager_Done (cacheManager);
+				cacheManager = 0;
+				cacheImages = 0;
+				cacheSBits = 0;
+
+			}
+
+		}
+
+		return cacheManager != 0;
+
+	}
+
+
+	static void cache_reset () {
+
+		if (cacheManager) {
+
+			FTC_Manager_Done (cacheManager);
+			cacheManager = 0;
+			cacheImages = 0;
+			cacheSBits = 0;
+
+		}
+
+	}
+
+
+	static FT_Library library_retain () {
+
+		if (!sharedLibrary && FT_Init_FreeType (&sharedLibrary) != 0) {
+
+			sharedLibrary = 0;
+			return 0;
+
+		}
+
+		sharedLibraryRefs++;
+		return sharedLibrary;
+
+	}
+
+
+	static void library_release () {
+
+		if (sharedLibrary && --sharedLibraryRefs == 0) {
+
+			cache_reset ();
+			FT_Done_FreeType (sharedLibrary);
+			sharedLibrary = 0;
+
+		}
+
+	}
+
+
+	static int count_codepoints (const char* characters, int length) {
+
+		// every byte that is not a UTF-8 continuation byte starts a character
+
+		int count = 0;
+
+		for (int i = 0; i < length; i++) {
+
+			if ((characters[i] & 0xC0) != 0x80) count++;
+
+		}
+
+		return count;
+
+	}
+
+
+	struct RenderGlyphsJob {
+
+		int chunkSize;
+		int count;
+		std::vector<uint32_t> counts;
+		std::vector<void*> faces;
+		Font* font;
+		const int* indices;
+		std::vector<Bytes*> output;
+		std::vector<int> sizes;
+
+	};
+
+
+	static int write_glyph_mask (Bytes *bytes, int offset, int index, int width, int height, int left, int top, const unsigned char* buffer, int pitch, int pixelMode, bool mono) {
+
+		if (width == 0 || height == 0 || !buffer || (pixelMode != FT_PIXEL_MODE_GRAY && pixelMode != FT_PIXEL_MODE_MONO)) {
+
+			return 0;
+
+		}
+
+		// A8 rows hold a byte per pixel, mono rows are packed most significant bit first,
+		// and every entry is padded to four bytes so the next GlyphImage header stays aligned
+
+		int stride = mono ? (width + 7) >> 3 : width;
+		uint32_t size = sizeof (GlyphImage) + ((stride * height + 3) & ~3);
+
+		if (bytes->length < size + offset) {
+
+			bytes->Resize (size + offset);
+
+		}
+
+		GlyphImage *data = (GlyphImage*)(bytes->b + offset);
+		memset (data, 0, size);
+
+		data->index = index;
+		data->width = width;
+		data->height = height;
+		data->x = left;
+		data->y = top;
+
+		unsigned char *position = &data->data;
+
+		for (int i = 0; i < height; i++) {
+
+			const unsigned char* row = pitch < 0 ? buffer + (height - 1 - i) * -pitch : buffer + i * pitch;
+			unsigned char* dest = position + i * stride;
+
+			if (mono == (pixelMode == FT_PIXEL_MODE_MONO)) {
+
+				memcpy (dest, row, stride);
+
+			} else if (mono) {
+
+				// embedded gray strikes are thresholded
+
+				for (int j = 0; j < width; j++) {
+
+					if (row[j] >= 128) dest[j >> 3] |= 0x80 >> (j & 7);
+
+				}
+
+			} else {
+
+				for (int j = 0; j < width; j++) {
+
+					dest[j] = (row[j >> 3] & (0x80 >> (j & 7))) ? 0xFF : 0;
+
+				}
+
+			}
+
+		}
+
+		return size;
+
+	}
+
+
+	Font::Font (Resource *resource, int faceIndex) {
+
+		this->library = 0;
+		this->face = 0;
+		this->faceMemory = 0;
+		this->faceIndex = faceIndex;
+		mCharHeight = 0;
+		mDPI = 0;
+		mGlyphTable = 0;
+		mID = nextFontID++;
+		mMetrics = 0;
+		mRenderMode = GLYPH_RENDER_LCD;
+		mScale = 0;
+		mSDFSpread = 8;
+		mSize = 0;
+
+		if (resource) {
+
+			int error;
+			FT_Library library;
+
+			std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
+
+			library = library_retain ();
+
+			if (!library) {
+
+				printf ("Could not initialize FreeType\n");
+
+			} else {
+
+				FT_Face face;
+				FontMemory *faceMemory;
+
+				// files are mapped rather than copied, and every Font (or HarfBuzz blob) of the same file shares the mapping
+
+				if (resource->path) {
+
+					faceMemory = FontMemory::Open (resource->path);
+
+				} else {
+
+					faceMemory = FontMemory::Create (resource->data->b, resource->data->length);
+
+				}
+
+				if (!faceMemory) {
+
+					library_release ();
+					return;
+
+				}
+
+				error = FT_New_Memory_Face (library, faceMemory->data, faceMemory->size, faceIndex, &face);
+
+				if (!error) {
+
+					this->library = library;
+					this->face = face;
+					this->faceMemory = faceMemory;
+
+					/* Set charmap
+					 *
+					 * See http://www.microsoft.com/typography/otspec/name.htm for a list of
+					 * some possible platform-encoding pairs.  We're interested in 0-3 aka 3-1
+					 * - UCS-2.  Otherwise, fail. If a font has some unicode map, but lacks
+					 * UCS-2 - it is a broken or irrelevant font. What exactly Freetype will
+					 * select on face load (it promises most wide unicode, and if that will be
+					 * slower that UCS-2 - left as an excercise to check.
+					 */
+					for (int i = 0; i < ((FT_Face)face)->num_charmaps; i++) {
+
+						FT_UShort pid = ((FT_Face)face)->charmaps[i]->platform_id;
+						FT_UShort eid = ((FT_Face)face)->charmaps[i]->encoding_id;
+
+						if (((pid == 0) && (eid == 3)) || ((pid == 3) && (eid == 1))) {
+
+							FT_Set_Charmap ((FT_Face)face, ((FT_Face)face)->charmaps[i]);
+
+						}
+
+					}
+
+				} else {
+
+					library_release ();
+					faceMemory->Release ();
+
+				}
+
+			}
+
+		}
+
+	}
+
+
+	Font::~Font () {
+
+		if (library) {
+
+			std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
+
+			if (cacheManager) {
+
+				FTC_Manager_RemoveFaceID (cacheManager, (FTC_FaceID)this);
+
+			}
+
+			FT_Done_Face ((FT_Face)face);
+			library_release ();
+			library = 0;
+			face = 0;
+
+		}
+
+		if (faceMemory) {
+
+			faceMemory->Release ();
+			faceMemory = 0;
+
+		}
+
+		delete (std::unordered_map<unsigned long long, std::unordered_map<int, FT_Glyph_Metrics> >*)mMetrics;
+		mMetrics = 0;
+
+		free (mGlyphTable);
+		mGlyphTable = 0;
+
+	}
+
+
+	void* Font::Decompose (bool useCFFIValue, int em) {
+
+		int result, i, j;
+
+		FT_Set_Char_Size ((FT_Face)face, em, em, 72, 72);
+		FT_Set_Transform ((FT_Face)face, 0, NULL);
+		mCharHeight = em;
+		mDPI = 72;
+		mScale = ((FT_Face)face)->size->metrics.y_scale;
+
+		std::vector<glyph*> glyphs;
+
+		FT_Outline_Funcs ofn =
+		{
+			outline_move_to,
+			outline_line_to,
+			outline_conic_to,
+			outline_cubic_to,
+			0, // shift
+			0  // delta
+		};
+
+		// Import every character in face
+		FT_ULong char_code;
+		FT_UInt glyph_index;
+
+		char_code = FT_Get_First_Char ((FT_Face)face, &glyph_index);
+
+		while (glyph_index != 0) {
+
+			if (FT_Load_Glyph ((FT_Face)face, glyph_index, FT_LOAD_NO_BITMAP | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_DEFAULT) == 0) {
+
+				glyph *g = new glyph;
+				result = FT_Outline_Decompose (&((FT_Face)face)->glyph->outline, &ofn, g);
+
+				if (result == 0) {
+
+					g->index = glyph_index;
+					g->char_code = char_code;
+					g->metrics = ((FT_Face)face)->glyph->metrics;
+					glyphs.push_back (g);
+
+				} else {
+
+					delete g;
+
+				}
+
+			}
+
+			char_code = FT_Get_Next_Char ((FT_Face)face, char_code, &glyph_index);
+
+		}
+
+		// Ascending sort by character codes
+		std::sort (glyphs.begin (), glyphs.end (), glyph_sort_predicate ());
+
+		std::vector<kerning>  kern;
+		if (FT_HAS_KERNING (((FT_Face)face))) {
+
+			int n = glyphs.size ();
+			FT_Vector v;
+
+			for (i = 0; i < n; i++) {
+
+				int  l_glyph = glyphs[i]->index;
+
+				for (j = 0; j < n; j++) {
+
+					int r_glyph = glyphs[j]->index;
+
+					FT_Get_Kerning ((FT_Face)face, l_glyph, r_glyph, FT_KERNING_DEFAULT, &v);
+
+					if (v.x != 0 || v.y != 0) {
+
+						kern.push_back (kerning (i, j, v.x, v.y));
+
+					}
+
+				}
+
+			}
+
+		}
+
+		int num_glyphs = glyphs.size ();
+
+		wchar_t* family_name = GetFamilyName ();
+
+		#ifdef LIME_FREETYPE_SWF_METRICS
+
+		// this should more closely match how [Embed] works in AS3 when
+		// embedding a font in a SWF
+
+		int calculatedAscender = 0;
+		int calculatedDescender = 0;
+		int calculatedHeight = 0;
+
+		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
+		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+
+		if (os2 && os2->version != 0xFFFFU) {
+
+			calculatedAscender = (FT_Short)os2->usWinAscent;
+			calculatedDescender = -(FT_Short)os2->usWinDescent;
+			calculatedHeight = calculatedAscender - calculatedDescender;
+
+		} else if (hhea) {
+
+			calculatedAscender = hhea->Ascender;
+			calculatedDescender = hhea->Descender;
+			calculatedHeight = calculatedAscender - calculatedDescender + hhea->Line_Gap;
+
+		} else {
+
+			// should never happen, but let's have a fallback to be safe
+			calculatedAscender = ((FT_Face)face)->ascender;
+			calculatedDescender = ((FT_Face)face)->descender;
+			calculatedHeight = ((FT_Face)face)->height;
+
+		}
+
+		#elif defined(LIME_FREETYPE_LEGACY_METRICS)
+
+		// this is FreeType's font metrics algorithm from 2.9.1
+		// it behaves more like SWF than the new algorithm
+
+		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
+		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+
+		int calculatedAscender = 0;
+		int calculatedDescender = 0;
+		int calculatedHeight = 0;
+
+		if (hhea) {
+
+			calculatedAscender = hhea->Ascender;
+			calculatedDescender = hhea->Descender;
+			calculatedHeight = calculatedAscender - calculatedDescender + hhea->Line_Gap;
+
+		}
+
+        if (!( calculatedAscender || calculatedDescender ))
+        {
+			if (os2 && os2->version != 0xFFFFU)
+			{
+				if (os2->sTypoAscender || os2->sTypoDescender)
+				{
+
+					calculatedAscender = os2->sTypoAscender;
+					calculatedDescender = os2->sTypoDescender;
+					calculatedHeight = calculatedAscender - calculatedDescender + os2->sTypoLineGap;
+
+				}
+				else
+				{
+
+					calculatedAscender = (FT_Short)os2->usWinAscent;
+					calculatedDescender = -(FT_Short)os2->usWinDescent;
+					calculatedHeight = calculatedAscender - calculatedDescender;
+
+				}
+			}
+        }
+
+		if (!calculatedAscender || !calculatedDescender) {
+
+			calculatedAscender = ((FT_Face)face)->ascender;
+			calculatedDescender = ((FT_Face)face)->descender;
+			calculatedHeight = ((FT_Face)face)->height;
+
+		}
+
+		#else
+
+		int calculatedAscender = ((FT_Face)face)->ascender;
+		int calculatedDescender = ((FT_Face)face)->descender;
+		int calculatedHeight = ((FT_Face)face)->height;
+
+		#endif
+
+		if (useCFFIValue) {
+
+			value ret = alloc_empty_object ();
+			alloc_field (ret, val_id ("has_kerning"), alloc_bool (FT_HAS_KERNING (((FT_Face)face))));
+			alloc_field (ret, val_id ("is_fixed_width"), alloc_bool (FT_IS_FIXED_WIDTH (((FT_Face)face))));
+			alloc_field (ret, val_id ("has_glyph_names"), alloc_bool (FT_HAS_GLYPH_NAMES (((FT_Face)face))));
+			alloc_field (ret, val_id ("is_italic"), alloc_bool (((FT_Face)face)->style_flags & FT_STYLE_FLAG_ITALIC));
+			alloc_field (ret, val_id ("is_bold"), alloc_bool (((FT_Face)face)->style_flags & FT_STYLE_FLAG_BOLD));
+			alloc_field (ret, val_id ("num_glyphs"), alloc_int (num_glyphs));
+			alloc_field (ret, val_id ("family_name"), family_name == NULL ? alloc_string (((FT_Face)face)->family_name) : alloc_wstring (family_name));
+			alloc_field (ret, val_id ("style_name"), alloc_string (((FT_Face)face)->style_name));
+			alloc_field (ret, val_id ("em_size"), alloc_int (((FT_Face)face)->units_per_EM));
+			alloc_field (ret, val_id ("ascend"), alloc_int (calculatedAscender));
+			alloc_field (ret, val_id ("descend"), alloc_int (calculatedDescender));
+			alloc_field (ret, val_id ("height"), alloc_int (calculatedHeight));
+
+			delete family_name;
 
 			// 'glyphs' field
 			value neko_glyphs = alloc_array (num_glyphs);
 			for (i = 0; i < glyphs.size (); i++) {
 
-				glyph *g = glyphs[i];
-				int num_points = g->pts.size ();
+				glyph *g = glyphs[i];
+				int num_points = g->pts.size ();
+
+				value points = alloc_array (num_points);
+
+				for (j = 0; j < num_points; j++) {
+
+					val_array_set_i (points, j, alloc_int (g->pts[j]));
+
+				}
+
+				value item = alloc_empty_object ();
+				val_array_set_i (neko_glyphs, i, item);
+				alloc_field (item, val_id ("char_code"), alloc_int (g->char_code));
+				alloc_field (item, val_id ("advance"), alloc_int (g->metrics.horiAdvance));
+				alloc_field (item, val_id ("min_x"), alloc_int (g->metrics.horiBearingX));
+				alloc_field (item, val_id ("max_x"), alloc_int (g->metrics.horiBearingX + g->metrics.width));
+				alloc_field (item, val_id ("min_y"), alloc_int (g->metrics.horiBearingY - g->metrics.height));
+				alloc_field (item, val_id ("max_y"), alloc_int (g->metrics.horiBearingY));
+				alloc_field (item, val_id ("points"), points);
+
+				delete g;
+
+			}
+
+			alloc_field (ret, val_id ("glyphs"), neko_glyphs);
+
+			// 'kerning' field
+			if (FT_HAS_KERNING (((FT_Face)face))) {
+
+				value neko_kerning = alloc_array (kern.size ());
+
+				for (i = 0; i < kern.size(); i++) {
+
+					kerning *k = &kern[i];
+
+					value item = alloc_empty_object();
+					val_array_set_i (neko_kerning,i,item);
+					alloc_field (item, val_id ("left_glyph"), alloc_int (k->l_glyph));
+					alloc_field (item, val_id ("right_glyph"), alloc_int (k->r_glyph));
+					alloc_field (item, val_id ("x"), alloc_int (k->x));
+					alloc_field (item, val_id ("y"), alloc_int (k->y));
+
+				}
+
+				alloc_field (ret, val_id ("kerning"), neko_kerning);
+
+			} else {
+
+				alloc_field (ret, val_id ("kerning"), alloc_null ());
+
+			}
+
+			return ret;
+
+		} else {
+
+			vdynamic* ret = (vdynamic*)hl_alloc_dynobj ();
+			hl_dyn_seti (ret, hl_hash_utf8 ("has_kerning"), &hlt_bool, FT_HAS_KERNING (((FT_Face)face)));
+			hl_dyn_seti (ret, hl_hash_utf8 ("is_fixed_width"), &hlt_bool, FT_IS_FIXED_WIDTH (((FT_Face)face)));
+			hl_dyn_seti (ret, hl_hash_utf8 ("has_glyph_names"), &hlt_bool, FT_HAS_GLYPH_NAMES (((FT_Face)face)));
+			hl_dyn_seti (ret, hl_hash_utf8 ("is_italic"), &hlt_bool, ((FT_Face)face)->style_flags & FT_STYLE_FLAG_ITALIC);
+			hl_dyn_seti (ret, hl_hash_utf8 ("is_bold"), &hlt_bool, ((FT_Face)face)->style_flags & FT_STYLE_FLAG_BOLD);
+			hl_dyn_seti (ret, hl_hash_utf8 ("num_glyphs"), &hlt_i32, num_glyphs);
+
+			char* _family_name = NULL;
+
+			if (family_name != NULL) {
+
+				int length = std::wcslen (family_name);
+				char* result = (char*)malloc (length + 1);
+				std::wcstombs (result, family_name, length);
+				result[length] = '\0';
+				delete family_name;
+
+			} else {
+
+				int length = strlen (((FT_Face)face)->family_name);
+				_family_name = (char*)malloc (length + 1);
+				strcpy (_family_name, ((FT_Face)face)->family_name);
+
+			}
+
+			char* style_name = (char*)malloc(strlen(((FT_Face)face)->style_name) + 1);
+			strcpy(style_name, ((FT_Face)face)->style_name);
+
+			hl_dyn_setp (ret, hl_hash_utf8 ("family_name"), &hlt_bytes, _family_name);
+			hl_dyn_setp (ret, hl_hash_utf8 ("style_name"), &hlt_bytes, style_name);
+			hl_dyn_seti (ret, hl_hash_utf8 ("em_size"), &hlt_i32, ((FT_Face)face)->units_per_EM);
+			hl_dyn_seti (ret, hl_hash_utf8 ("ascend"), &hlt_i32, calculatedAscender);
+			hl_dyn_seti (ret, hl_hash_utf8 ("descend"), &hlt_i32, calculatedDescender);
+			hl_dyn_seti (ret, hl_hash_utf8 ("height"), &hlt_i32, calculatedHeight);
+
+			// 'glyphs' field
+			hl_varray* _glyphs = (hl_varray*)hl_alloc_array (&hlt_dynobj, num_glyphs);
+			vdynamic** _glyphsData = hl_aptr (_glyphs, vdynamic*);
+
+			for (i = 0; i < glyphs.size (); i++) {
+
+				glyph *g = glyphs[i];
+				int num_points = g->pts.size ();
+
+				hl_varray* points = (hl_varray*)hl_alloc_array (&hlt_i32, num_points);
+				int* pointsData = hl_aptr (points, int);
+
+				for (j = 0; j < num_points; j++) {
+
+					*pointsData++ = g->pts[j];
+
+				}
+
+				vdynamic* item = (vdynamic*)hl_alloc_dynobj ();
+				*_glyphsData++ = item;
+				hl_dyn_seti (item, hl_hash_utf8 ("char_code"), &hlt_i32, g->char_code);
+				hl_dyn_seti (item, hl_hash_utf8 ("advance"), &hlt_i32, g->metrics.horiAdvance);
+				hl_dyn_seti (item, hl_hash_utf8 ("min_x"), &hlt_i32, g->metrics.horiBearingX);
+				hl_dyn_seti (item, hl_hash_utf8 ("max_x"), &hlt_i32, g->metrics.horiBearingX + g->metrics.width);
+				hl_dyn_seti (item, hl_hash_utf8 ("min_y"), &hlt_i32, g->metrics.horiBearingY - g->metrics.height);
+				hl_dyn_seti (item, hl_hash_utf8 ("max_y"), &hlt_i32, g->metrics.horiBearingY);
+				hl_dyn_setp (item, hl_hash_utf8 ("points"), &hlt_array, points);
+
+				delete g;
+
+			}
+
+			hl_dyn_setp (ret, hl_hash_utf8 ("glyphs"), &hlt_array, _glyphs);
+
+			// 'kerning' field
+			if (FT_HAS_KERNING (((FT_Face)face))) {
+
+				hl_varray* _kerning = (hl_varray*)hl_alloc_array (&hlt_i32, kern.size ());
+				vdynamic** _kerningData = hl_aptr (_kerning, vdynamic*);
+
+				for (i = 0; i < kern.size(); i++) {
+
+					kerning *k = &kern[i];
+
+					vdynamic* item = (vdynamic*)hl_alloc_dynobj ();
+					*_kerningData++ = item;
+					hl_dyn_seti (item, hl_hash_utf8 ("left_glyph"), &hlt_i32, k->l_glyph);
+					hl_dyn_seti (item, hl_hash_utf8 ("right_glyph"), &hlt_i32, k->r_glyph);
+					hl_dyn_seti (item, hl_hash_utf8 ("x"), &hlt_i32, k->x);
+					hl_dyn_seti (item, hl_hash_utf8 ("y"), &hlt_i32, k->y);
+
+				}
+
+				hl_dyn_setp (ret, hl_hash_utf8 ("kerning"), &hlt_array, _kerning);
+
+			} else {
+
+				hl_dyn_setp (ret, hl_hash_utf8 ("kerning"), &hlt_array, 0);
+
+			}
+
+			return ret;
+
+		}
+
+	}
+
+
+	int Font::DecomposeGlyphs (int em, const int* indices, int count, Bytes* output) {
+
+		return DecomposeOutlines (em, indices, count, 0, output);
+
+	}
+
+
+	int Font::DecomposeOutlines (int em, const int* indices, int count, float tolerance, Bytes* output) {
+
+		FT_Face ftFace = (FT_Face)face;
+
+		FT_Set_Char_Size (ftFace, em, em, 72, 72);
+		FT_Set_Transform (ftFace, 0, NULL);
+		mCharHeight = em;
+		mDPI = 72;
+		mScale = ftFace->size->metrics.y_scale;
+
+		// without indices every mapped character is included, in ascending character code like Decompose
+
+		std::vector<std::pair<FT_ULong, FT_UInt> > glyphList;
+
+		if (indices) {
+
+			for (int i = 0; i < count; i++) {
+
+				glyphList.push_back (std::make_pair ((FT_ULong)0, (FT_UInt)indices[i]));
+
+			}
+
+		} else {
+
+			FT_UInt glyph_index;
+			FT_ULong char_code = FT_Get_First_Char (ftFace, &glyph_index);
+
+			while (glyph_index != 0) {
+
+				glyphList.push_back (std::make_pair (char_code, glyph_index));
+				char_code = FT_Get_Next_Char (ftFace, char_code, &glyph_index);
+
+			}
+
+			std::sort (glyphList.begin (), glyphList.end ());
+
+		}
+
+		FT_Outline_Funcs ofn =
+		{
+			path_move_to,
+			path_line_to,
+			path_conic_to,
+			path_cubic_to,
+			0, // shift
+			0  // delta
+		};
+
+		int numGlyphs = glyphList.size ();
+		outline_path path (tolerance);
+		std::vector<int> records (numGlyphs * 11, 0);
+		std::vector<int> triangles;
+
+		for (int i = 0; i < numGlyphs; i++) {
+
+			int* record = &records[i * 11];
+			int firstContour = path.contours.size () / 2;
+			int firstPoint = path.points.size () / 2;
+			int firstCommand = path.commands.size ();
+			int firstIndex = triangles.size ();
+
+			record[0] = glyphList[i].first;
+			record[1] = glyphList[i].second;
+
+			if (FT_Load_Glyph (ftFace, glyphList[i].second, FT_LOAD_NO_BITMAP | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_DEFAULT) == 0) {
+
+				FT_Glyph_Metrics* metrics = &ftFace->glyph->metrics;
+				record[2] = metrics->horiAdvance;
+				record[3] = metrics->horiBearingX;
+				record[4] = metrics->horiBearingX + metrics->width;
+				record[5] = metrics->horiBearingY - metrics->height;
+				record[6] = metrics->horiBearingY;
+
+				path.start = firstPoint;
+
+				if (ftFace->glyph->format == FT_GLYPH_FORMAT_OUTLINE && FT_Outline_Decompose (&ftFace->glyph->outline, &ofn, &path) == 0) {
+
+					path_close (&path);
+
+					if (tolerance > 0) {
+
+						triangulate_contours (path.points, path.contours, firstContour, &triangles);
+
+					}
+
+				} else {
+
+					path.commands.resize (firstCommand);
+					path.contours.resize (firstContour * 2);
+					path.points.resize (firstPoint * 2);
+
+				}
+
+			}
+
+			record[7] = firstPoint;
+			record[8] = path.points.size () / 2 - firstPoint;
+			record[9] = tolerance > 0 ? firstIndex : firstCommand;
+			record[10] = tolerance > 0 ? triangles.size () - firstIndex : path.commands.size () - firstCommand;
+
+		}
+
+		// [glyphs, points, commands or indices], 11 ints per glyph, Float32 point pairs, then Uint8 commands or Int32 indices
+
+		int numPoints = path.points.size () / 2;
+		int streamLength = tolerance > 0 ? triangles.size () * 4 : path.commands.size ();
+		output->Resize ((3 + numGlyphs * 11) * 4 + numPoints * 8 + streamLength);
+
+		int* data = (int*)output->b;
+		data[0] = numGlyphs;
+		data[1] = numPoints;
+		data[2] = tolerance > 0 ? triangles.size () : path.commands.size ();
+
+		unsigned char* position = output->b + 12;
+
+		if (numGlyphs > 0) {
+
+			memcpy (position, &records[0], numGlyphs * 11 * 4);
+			position += numGlyphs * 11 * 4;
+
+		}
+
+		if (numPoints > 0) {
+
+			memcpy (position, &path.points[0], numPoints * 8);
+			position += numPoints * 8;
+
+		}
+
+		if (streamLength > 0) {
+
+			memcpy (position, tolerance > 0 ? (void*)&triangles[0] : (void*)&path.commands[0], streamLength);
+
+		}
+
+		return numGlyphs;
+
+	}
+
+
+	int Font::GetAscender () {
+
+		#ifdef LIME_FREETYPE_SWF_METRICS
+
+		// this should more closely match how [Embed] works in AS3 when
+		// embedding a font in a SWF
+
+		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
+		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+
+		if (os2 && os2->version != 0xFFFFU) {
+
+			return (FT_Short)os2->usWinAscent;
+
+		} else if (hhea) {
+
+			return hhea->Ascender;
+
+		}
+
+		// should never happen, but let's have a fallback to be safe
+		return ((FT_Face)face)->ascender;
+
+		#elif defined(LIME_FREETYPE_LEGACY_METRICS)
+
+		// this is FreeType's font metrics algorithm from 2.9.1
+		// it behaves more like SWF than the new algorithm
+
+		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
+		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+
+		int calculatedAscender = 0;
+		int calculatedDescender = 0;
+
+		if (hhea) {
+
+			calculatedAscender = hhea->Ascender;
+			calculatedDescender = hhea->Descender;
+		}
+
+        if (!( calculatedAscender || calculatedDescender ))
+        {
+			if (os2 && os2->version != 0xFFFFU)
+			{
+				if (os2->sTypoAscender || os2->sTypoDescender)
+				{
+
+					calculatedAscender = os2->sTypoAscender;
+					calculatedDescender = os2->sTypoDescender;
+
+				}
+				else
+				{
+
+					calculatedAscender = (FT_Short)os2->usWinAscent;
+					calculatedDescender = -(FT_Short)os2->usWinDescent;
+
+				}
+			}
+        }
+
+		if (!calculatedAscender || !calculatedDescender) {
+
+			calculatedAscender = ((FT_Face)face)->ascender;
+			calculatedDescender = ((FT_Face)face)->descender;
+
+		}
+
+		return calculatedAscender;
+
+		#else
+
+		return ((FT_Face)face)->ascender;
+
+		#endif
+
+	}
+
+
+	bool Font::GetCacheScaler (void* scaler) {
+
+		// the cache is skipped if something else (such as Cairo) rescaled the face since SetSize
+
+		if (mCharHeight <= 0 || ((FT_Face)face)->size->metrics.y_scale != mScale) {
+
+			return false;
+
+		}
+
+		FTC_Scaler cacheScaler = (FTC_Scaler)scaler;
+		cacheScaler->face_id = (FTC_FaceID)this;
+		cacheScaler->width = 0;
+		cacheScaler->height = mCharHeight;
+		cacheScaler->pixel = 0;
+		cacheScaler->x_res = mDPI;
+		cacheScaler->y_res = mDPI;
+
+		return true;
+
+	}
+
+
+	int Font::GetDescender () {
+
+		#ifdef LIME_FREETYPE_SWF_METRICS
+
+		// this should more closely match how [Embed] works in AS3 when
+		// embedding a font in a SWF
+
+		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
+		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+
+		if (os2 && os2->version != 0xFFFFU) {
+
+			return -(FT_Short)os2->usWinDescent;
+
+		}
+		else if (hhea) {
+
+			return hhea->Descender;
+
+		}
+
+		// should never happen, but let's have a fallback to be safe
+		return ((FT_Face)face)->descender;
+
+		#elif defined(LIME_FREETYPE_LEGACY_METRICS)
+
+		// this is FreeType's font metrics algorithm from 2.9.1
+		// it behaves more like SWF than the new algorithm
+
+		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
+		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+
+		int calculatedAscender = 0;
+		int calculatedDescender = 0;
+
+		if (hhea) {
+
+			calculatedAscender = hhea->Ascender;
+			calculatedDescender = hhea->Descender;
+
+		}
+
+        if (!( calculatedAscender || calculatedDescender ))
+        {
+			if (os2 && os2->version != 0xFFFFU)
+			{
+				if (os2->sTypoAscender || os2->sTypoDescender)
+				{
+
+					calculatedAscender = os2->sTypoAscender;
+					calculatedDescender = os2->sTypoDescender;
+
+				}
+				else
+				{
+
+					calculatedAscender = (FT_Short)os2->usWinAscent;
+					calculatedDescender = -(FT_Short)os2->usWinDescent;
+
+				}
+			}
+        }
+
+		if (!calculatedAscender || !calculatedDescender) {
+
+			calculatedAscender = ((FT_Face)face)->ascender;
+			calculatedDescender = ((FT_Face)face)->descender;
+
+		}
+
+		return calculatedDescender;
+
+		#else
+
+		return ((FT_Face)face)->descender;
+
+		#endif
+
+	}
+
+
+	wchar_t *Font::GetFamilyName () {
+
+		#ifdef LIME_FREETYPE
+
+		wchar_t *family_name = NULL;
+		FT_SfntName sfnt_name;
+		FT_UInt num_sfnt_names, sfnt_name_index;
+		int len, i;
+
+		if (FT_IS_SFNT (((FT_Face)face))) {
+
+			num_sfnt_names = FT_Get_Sfnt_Name_Count ((FT_Face)face);
+			sfnt_name_index = 0;
+
+			while (sfnt_name_index < num_sfnt_names) {
+
+				if (!FT_Get_Sfnt_Name ((FT_Face)face, sfnt_name_index++, (FT_SfntName *)&sfnt_name) && sfnt_name.name_id == TT_NAME_ID_FULL_NAME) {
+
+					if (sfnt_name.platform_id == TT_PLATFORM_MACINTOSH) {
+
+						len = sfnt_name.string_len;
+						family_name = new wchar_t[len + 1];
+						#if defined(ANDROID) && !defined(HXCPP_CLANG)
+						// Fix some devices (Android 4.x or older) that have a bad stdc implementation
+						_mbsrtowcs (family_name, (const char**)&sfnt_name.string, len, 0);
+						#else
+						mbstowcs (family_name, (const char*)sfnt_name.string, len);
+						#endif
+						family_name[len] = L'\0';
+						return family_name;
+
+					} else if ((sfnt_name.platform_id == TT_PLATFORM_MICROSOFT) && (sfnt_name.encoding_id == TT_MS_ID_UNICODE_CS)) {
+
+						len = sfnt_name.string_len / 2;
+						family_name = (wchar_t*)malloc ((len + 1) * sizeof (wchar_t));
+
+						for (i = 0; i < len; i++) {
+
+							family_name[i] = ((wchar_t)sfnt_name.string[i * 2 + 1]) | (((wchar_t)sfnt_name.string[i * 2]) << 8);
+
+						}
+
+						family_name[len] = L'\0';
+						return family_name;
+
+					}
+
+				}
+
+			}
+
+		}
+
+		#endif
+
+		return NULL;
+
+	}
+
+
+	int Font::GetGlyphIndex (const char* character) {
+
+		long charCode = readNextChar (character);
+
+		return FT_Get_Char_Index ((FT_Face)face, charCode);
+
+	}
+
+
+	void* Font::GetGlyphIndices (bool useCFFIValue, const char* characters) {
+
+		int length = characters ? strlen (characters) : 0;
+		int count = count_codepoints (characters, length);
+
+		if (useCFFIValue) {
+
+			std::vector<int> glyphs (count);
+
+			if (count > 0) {
+
+				GetGlyphIndices (characters, length, &glyphs[0]);
+
+			}
+
+			value indices = alloc_array (count);
+
+			for (int i = 0; i < count; i++) {
+
+				val_array_set_i (indices, i, alloc_int (glyphs[i]));
+
+			}
+
+			return indices;
+
+		} else {
+
+			hl_varray* indices = (hl_varray*)hl_alloc_array (&hlt_i32, count);
+
+			if (count > 0) {
+
+				GetGlyphIndices (characters, length, hl_aptr (indices, int));
+
+			}
+
+			return indices;
+
+		}
+
+	}
+
+
+	int Font::GetGlyphIndices (const char* characters, Bytes* indices) {
+
+		// packed Int32 indices, one per character
+
+		int length = characters ? strlen (characters) : 0;
+		int count = count_codepoints (characters, length);
+
+		indices->Resize (count * 4);
+
+		if (count > 0) {
+
+			GetGlyphIndices (characters, length, (int*)indices->b);
+
+		}
+
+		return count;
+
+	}
+
+
+	int Font::GetGlyphIndices (const char* characters, int length, int* indices) {
+
+		// writes one index per character, malformed lead bytes map to glyph 0 and stray continuation bytes are skipped,
+		// which is exactly the count from count_codepoints. Without a table every lookup goes through FreeType
+
+		unsigned short* table = GetGlyphTable ();
+		const unsigned char* bytes = (const unsigned char*)characters;
+		int count = 0;
+		int i = 0;
+
+		while (i < length) {
+
+			#if defined (__SSE2__) || (defined (__ARM_NEON) && defined (__aarch64__))
+
+			// runs of ASCII are checked sixteen bytes at a time and mapped straight through the table
+
+			while (table && i + 16 <= length) {
+
+				#ifdef __SSE2__
+				bool ascii = _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i*)(bytes + i))) == 0;
+				#else
+				bool ascii = vmaxvq_u8 (vld1q_u8 (bytes + i)) < 0x80;
+				#endif
+
+				if (!ascii) break;
+
+				for (int j = 0; j < 16; j++) {
+
+					indices[count + j] = table[bytes[i + j]];
+
+				}
+
+				count += 16;
+				i += 16;
+
+			}
+
+			if (i >= length) break;
+
+			#endif
+
+			unsigned char c = bytes[i];
+
+			if (c < 0x80) {
+
+				indices[count++] = table ? table[c] : FT_Get_Char_Index ((FT_Face)face, c);
+				i++;
+
+			} else if ((c & 0xC0) == 0x80) {
+
+				i++;
+
+			} else {
+
+				const char* position = characters + i;
+				unsigned long character = readNextChar (position);
+
+				if (character == (unsigned long)-1) {
+
+					indices[count++] = 0;
+					i++;
+
+				} else {
+
+					indices[count++] = (table && character < 0x10000 && table[character] != 0xFFFF) ? table[character] : FT_Get_Char_Index ((FT_Face)face, character);
+					i = position - characters;
+
+				}
+
+			}
+
+		}
+
+		return count;
+
+	}
+
+
+	void* Font::GetGlyphMetrics (bool useCFFIValue, int index) {
+
+		FT_Glyph_Metrics metrics;
+		bool loaded = LoadGlyphMetrics (index, &metrics, GetMetricsCache ());
+
+		if (useCFFIValue) {
+
+			initialize ();
+
+			if (loaded) {
+
+				value result = alloc_empty_object ();
+
+				alloc_field (result, id_height, alloc_int (metrics.height));
+				alloc_field (result, id_horizontalBearingX, alloc_int (metrics.horiBearingX));
+				alloc_field (result, id_horizontalBearingY, alloc_int (metrics.horiBearingY));
+				alloc_field (result, id_horizontalAdvance, alloc_int (metrics.horiAdvance));
+				alloc_field (result, id_verticalBearingX, alloc_int (metrics.vertBearingX));
+				alloc_field (result, id_verticalBearingY, alloc_int (metrics.vertBearingY));
+				alloc_field (result, id_verticalAdvance, alloc_int (metrics.vertAdvance));
+
+				return result;
+
+			}
+
+			return alloc_null ();
+
+		} else {
+
+			if (loaded) {
+
+				const int id_height = hl_hash_utf8 ("height");
+				const int id_horizontalBearingX = hl_hash_utf8 ("horizontalBearingX");
+				const int id_horizontalBearingY = hl_hash_utf8 ("horizontalBearingY");
+				const int id_horizontalAdvance = hl_hash_utf8 ("horizontalAdvance");
+				const int id_verticalBearingX = hl_hash_utf8 ("verticalBearingX");
+				const int id_verticalBearingY = hl_hash_utf8 ("verticalBearingY");
+				const int id_verticalAdvance = hl_hash_utf8 ("verticalAdvance");
+
+				vdynamic* result = (vdynamic*)hl_alloc_dynobj ();
+
+				hl_dyn_seti (result, id_height, &hlt_i32, metrics.height);
+				hl_dyn_seti (result, id_horizontalBearingX, &hlt_i32, metrics.horiBearingX);
+				hl_dyn_seti (result, id_horizontalBearingY, &hlt_i32, metrics.horiBearingY);
+				hl_dyn_seti (result, id_horizontalAdvance, &hlt_i32, metrics.horiAdvance);
+				hl_dyn_seti (result, id_verticalBearingX, &hlt_i32, metrics.vertBearingX);
+				hl_dyn_seti (result, id_verticalBearingY, &hlt_i32, metrics.vertBearingY);
+				hl_dyn_seti (result, id_verticalAdvance, &hlt_i32, metrics.vertAdvance);
+
+				return result;
+
+			}
+
+			return 0;
+
+		}
+
+	}
+
+
+	int Font::GetGlyphMetrics (const int* indices, int count, int* metrics) {
+
+		// eight values per glyph, in 26.6 like the single glyph query: horizontal and vertical advance,
+		// horizontal bearing x and y, vertical bearing x and y, width and height, missing glyphs are zero
+
+		void* cache = GetMetricsCache ();
+		FT_Glyph_Metrics glyphMetrics;
+		int loaded = 0;
+
+		for (int i = 0; i < count; i++) {
+
+			int* data = metrics + i * 8;
+
+			if (LoadGlyphMetrics (indices[i], &glyphMetrics, cache)) {
+
+				data[0] = glyphMetrics.horiAdvance;
+				data[1] = glyphMetrics.vertAdvance;
+				data[2] = glyphMetrics.horiBearingX;
+				data[3] = glyphMetrics.horiBearingY;
+				data[4] = glyphMetrics.vertBearingX;
+				data[5] = glyphMetrics.vertBearingY;
+				data[6] = glyphMetrics.width;
+				data[7] = glyphMetrics.height;
+				loaded++;
+
+			} else {
+
+				memset (data, 0, 8 * sizeof (int));
+
+			}
+
+		}
+
+		return loaded;
+
+	}
+
+
+	unsigned short* Font::GetGlyphTable () {
+
+		// a direct-mapped table of the basic multilingual plane, built once from the charmap,
+		// 0xFFFF marks the rare index that does not fit and is looked up through FreeType instead
+
+		if (!mGlyphTable) {
+
+			mGlyphTable = (unsigned short*)calloc (0x10000, sizeof (unsigned short));
+
+			if (!mGlyphTable) {
+
+				return 0;
+
+			}
+
+			FT_UInt index;
+			FT_ULong character = FT_Get_First_Char ((FT_Face)face, &index);
+
+			while (index != 0) {
+
+				if (character < 0x10000) {
+
+					mGlyphTable[character] = index < 0xFFFF ? index : 0xFFFF;
+
+				}
+
+				character = FT_Get_Next_Char ((FT_Face)face, character, &index);
+
+			}
+
+		}
+
+		return mGlyphTable;
+
+	}
+
+
+	int Font::GetHeight () {
+
+		#ifdef LIME_FREETYPE_SWF_METRICS
+
+		// this should more closely match how [Embed] works in AS3 when
+		// embedding a font in a SWF
+
+		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
+		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+
+		if (os2 && os2->version != 0xFFFFU) {
+
+			int calculatedAscender = (FT_Short)os2->usWinAscent;
+			int calculatedDescender = -(FT_Short)os2->usWinDescent;
+			return calculatedAscender - calculatedDescender;
+
+		} else if (hhea) {
+
+			int calculatedAscender = hhea->Ascender;
+			int calculatedDescender = hhea->Descender;
+			return calculatedAscender - calculatedDescender + hhea->Line_Gap;
+
+		}
+
+		// should never happen, but let's have a fallback to be safe
+		return ((FT_Face)face)->height;
+
+		#elif defined(LIME_FREETYPE_LEGACY_METRICS)
+
+		// this is FreeType's font metrics algorithm from 2.9.1
+		// it behaves more like SWF than the new algorithm
+
+		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
+		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+
+		int calculatedAscender = 0;
+		int calculatedDescender = 0;
+		int calculatedHeight = 0;
+
+		if (hhea) {
+
+			calculatedAscender = hhea->Ascender;
+			calculatedDescender = hhea->Descender;
+			calculatedHeight = calculatedAscender - calculatedDescender + hhea->Line_Gap;
+
+		}
+
+        if (!( calculatedAscender || calculatedDescender ))
+        {
+			if (os2 && os2->version != 0xFFFFU)
+			{
+				if (os2->sTypoAscender || os2->sTypoDescender)
+				{
+
+					calculatedAscender = os2->sTypoAscender;
+					calculatedDescender = os2->sTypoDescender;
+					calculatedHeight = calculatedAscender - calculatedDescender + os2->sTypoLineGap;
+
+				}
+				else
+				{
+
+					calculatedAscender = (FT_Short)os2->usWinAscent;
+					calculatedDescender = -(FT_Short)os2->usWinDescent;
+					calculatedHeight = calculatedAscender - calculatedDescender;
+
+				}
+			}
+        }
+
+        if (!calculatedHeight) {
+
+			calculatedHeight = ((FT_Face)face)->height;
+
+		}
+
+		return calculatedHeight;
+
+		#else
+
+		return ((FT_Face)face)->height;
+
+		#endif
+
+	}
+
+
+	unsigned long long Font::GetID () {
+
+		// unique for the life of the process, unlike the address a later Font may be allocated at
+
+		return mID;
+
+	}
+
+
+	void* Font::GetMetricsCache () {
+
+		// metrics only depend on the scale of the face, so each scale that has been used keeps its own table
+
+		typedef std::unordered_map<int, FT_Glyph_Metrics> GlyphMetricsMap;
+		typedef std::unordered_map<unsigned long long, GlyphMetricsMap> ScaleMetricsMap;
+
+		if (!mMetrics) {
+
+			mMetrics = new ScaleMetricsMap ();
+
+		}
+
+		FT_Size_Metrics* sizeMetrics = &((FT_Face)face)->size->metrics;
+		unsigned long long scale = ((unsigned long long)(unsigned int)sizeMetrics->y_scale << 32) | (unsigned int)sizeMetrics->x_scale;
+		return &(*(ScaleMetricsMap*)mMetrics)[scale];
+
+	}
+
+
+	int Font::GetNumGlyphs () {
+
+		return ((FT_Face)face)->num_glyphs;
+
+	}
 
-				value points = alloc_array (num_points);
 
-				for (j = 0; j < num_points; j++) {
+	GlyphRenderMode Font::GetRenderMode () {
 
-					val_array_set_i (points, j, alloc_int (g->pts[j]));
+		return mRenderMode;
 
-				}
+	}
 
-				value item = alloc_empty_object ();
-				val_array_set_i (neko_glyphs, i, item);
-				alloc_field (item, val_id ("char_code"), alloc_int (g->char_code));
-				alloc_field (item, val_id ("advance"), alloc_int (g->metrics.horiAdvance));
-				alloc_field (item, val_id ("min_x"), alloc_int (g->metrics.horiBearingX));
-				alloc_field (item, val_id ("max_x"), alloc_int (g->metrics.horiBearingX + g->metrics.width));
-				alloc_field (item, val_id ("min_y"), alloc_int (g->metrics.horiBearingY - g->metrics.height));
-				alloc_field (item, val_id ("max_y"), alloc_int (g->metrics.horiBearingY));
-				alloc_field (item, val_id ("points"), points);
 
-				delete g;
+	int Font::GetSDFSpread () {
 
-			}
+		return mSDFSpread;
 
-			alloc_field (ret, val_id ("glyphs"), neko_glyphs);
+	}
 
-			// 'kerning' field
-			if (FT_HAS_KERNING (((FT_Face)face))) {
 
-				value neko_kerning = alloc_array (kern.size ());
+	int Font::GetUnderlinePosition () {
 
-				for (i = 0; i < kern.size(); i++) {
+		return ((FT_Face)face)->underline_position;
 
-					kerning *k = &kern[i];
+	}
 
-					value item = alloc_empty_object();
-					val_array_set_i (neko_kerning,i,item);
-					alloc_field (item, val_id ("left_glyph"), alloc_int (k->l_glyph));
-					alloc_field (item, val_id ("right_glyph"), alloc_int (k->r_glyph));
-					alloc_field (item, val_id ("x"), alloc_int (k->x));
-					alloc_field (item, val_id ("y"), alloc_int (k->y));
 
-				}
+	int Font::GetUnderlineThickness () {
 
-				alloc_field (ret, val_id ("kerning"), neko_kerning);
+		return ((FT_Face)face)->underline_thickness;
 
-			} else {
+	}
 
-				alloc_field (ret, val_id ("kerning"), alloc_null ());
 
-			}
+	int Font::GetUnitsPerEM () {
 
-			return ret;
+		return ((FT_Face)face)->units_per_EM;
 
-		} else {
+	}
 
-			vdynamic* ret = (vdynamic*)hl_alloc_dynobj ();
-			hl_dyn_seti (ret, hl_hash_utf8 ("has_kerning"), &hlt_bool, FT_HAS_KERNING (((FT_Face)face)));
-			hl_dyn_seti (ret, hl_hash_utf8 ("is_fixed_width"), &hlt_bool, FT_IS_FIXED_WIDTH (((FT_Face)face)));
-			hl_dyn_seti (ret, hl_hash_utf8 ("has_glyph_names"), &hlt_bool, FT_HAS_GLYPH_NAMES (((FT_Face)face)));
-			hl_dyn_seti (ret, hl_hash_utf8 ("is_italic"), &hlt_bool, ((FT_Face)face)->style_flags & FT_STYLE_FLAG_ITALIC);
-			hl_dyn_seti (ret, hl_hash_utf8 ("is_bold"), &hlt_bool, ((FT_Face)face)->style_flags & FT_STYLE_FLAG_BOLD);
-			hl_dyn_seti (ret, hl_hash_utf8 ("num_glyphs"), &hlt_i32, num_glyphs);
 
-			char* _family_name = NULL;
+	void* Font::LoadGlyph (int index, int flags, void* renderFace) {
 
-			if (family_name != NULL) {
+		// returns a copy the caller releases with FT_Done_Glyph, a worker's face is loaded directly since the cache is locked
 
-				int length = std::wcslen (family_name);
-				char* result = (char*)malloc (length + 1);
-				std::wcstombs (result, family_name, length);
-				result[length] = '\0';
-				delete family_name;
+		FT_Glyph glyph = 0;
+		FTC_ScalerRec scaler;
 
-			} else {
+		if (renderFace) {
 
-				int length = strlen (((FT_Face)face)->family_name);
-				_family_name = (char*)malloc (length + 1);
-				strcpy (_family_name, ((FT_Face)face)->family_name);
+			if (FT_Load_Glyph ((FT_Face)renderFace, index, flags) == 0) {
+
+				FT_Get_Glyph (((FT_Face)renderFace)->glyph, &glyph);
 
 			}
 
-			char* style_name = (char*)malloc(strlen(((FT_Face)face)->style_name) + 1);
-			strcpy(style_name, ((FT_Face)face)->style_name);
+			return glyph;
 
-			hl_dyn_setp (ret, hl_hash_utf8 ("family_name"), &hlt_bytes, _family_name);
-			hl_dyn_setp (ret, hl_hash_utf8 ("style_name"), &hlt_bytes, style_name);
-			hl_dyn_seti (ret, hl_hash_utf8 ("em_size"), &hlt_i32, ((FT_Face)face)->units_per_EM);
-			hl_dyn_seti (ret, hl_hash_utf8 ("ascend"), &hlt_i32, calculatedAscender);
-			hl_dyn_seti (ret, hl_hash_utf8 ("descend"), &hlt_i32, calculatedDescender);
-			hl_dyn_seti (ret, hl_hash_utf8 ("height"), &hlt_i32, calculatedHeight);
+		}
 
-			// 'glyphs' field
-			hl_varray* _glyphs = (hl_varray*)hl_alloc_array (&hlt_dynobj, num_glyphs);
-			vdynamic** _glyphsData = hl_aptr (_glyphs, vdynamic*);
+		if (GetCacheScaler (&scaler)) {
 
-			for (i = 0; i < glyphs.size (); i++) {
+			std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
 
-				glyph *g = glyphs[i];
-				int num_points = g->pts.size ();
+			if (cache_open ()) {
 
-				hl_varray* points = (hl_varray*)hl_alloc_array (&hlt_i32, num_points);
-				int* pointsData = hl_aptr (points, int);
+				FT_Glyph cached;
 
-				for (j = 0; j < num_points; j++) {
+				if (FTC_ImageCache_LookupScaler (cacheImages, &scaler, flags, index, &cached, NULL) == 0) {
 
-					*pointsData++ = g->pts[j];
+					FT_Glyph_Copy (cached, &glyph);
 
 				}
 
-				vdynamic* item = (vdynamic*)hl_alloc_dynobj ();
-				*_glyphsData++ = item;
-				hl_dyn_seti (item, hl_hash_utf8 ("char_code"), &hlt_i32, g->char_code);
-				hl_dyn_seti (item, hl_hash_utf8 ("advance"), &hlt_i32, g->metrics.horiAdvance);
-				hl_dyn_seti (item, hl_hash_utf8 ("min_x"), &hlt_i32, g->metrics.horiBearingX);
-				hl_dyn_seti (item, hl_hash_utf8 ("max_x"), &hlt_i32, g->metrics.horiBearingX + g->metrics.width);
-				hl_dyn_seti (item, hl_hash_utf8 ("min_y"), &hlt_i32, g->metrics.horiBearingY - g->metrics.height);
-				hl_dyn_seti (item, hl_hash_utf8 ("max_y"), &hlt_i32, g->metrics.horiBearingY);
-				hl_dyn_setp (item, hl_hash_utf8 ("points"), &hlt_array, points);
-
-				delete g;
+				return glyph;
 
 			}
 
-			hl_dyn_setp (ret, hl_hash_utf8 ("glyphs"), &hlt_array, _glyphs);
+		}
 
-			// 'kerning' field
-			if (FT_HAS_KERNING (((FT_Face)face))) {
+		if (FT_Load_Glyph ((FT_Face)face, index, flags) == 0) {
 
-				hl_varray* _kerning = (hl_varray*)hl_alloc_array (&hlt_i32, kern.size ());
-				vdynamic** _kerningData = hl_aptr (_kerning, vdynamic*);
+			FT_Get_Glyph (((FT_Face)face)->glyph, &glyph);
 
-				for (i = 0; i < kern.size(); i++) {
+		}
 
-					kerning *k = &kern[i];
+		return glyph;
 
-					vdynamic* item = (vdynamic*)hl_alloc_dynobj ();
-					*_kerningData++ = item;
-					hl_dyn_seti (item, hl_hash_utf8 ("left_glyph"), &hlt_i32, k->l_glyph);
-					hl_dyn_seti (item, hl_hash_utf8 ("right_glyph"), &hlt_i32, k->r_glyph);
-					hl_dyn_seti (item, hl_hash_utf8 ("x"), &hlt_i32, k->x);
-					hl_dyn_seti (item, hl_hash_utf8 ("y"), &hlt_i32, k->y);
+	}
 
-				}
 
-				hl_dyn_setp (ret, hl_hash_utf8 ("kerning"), &hlt_array, _kerning);
+	bool Font::LoadGlyphMetrics (int index, void* metrics, void* metricsCache) {
 
-			} else {
+		typedef std::unordered_map<int, FT_Glyph_Metrics> GlyphMetricsMap;
 
-				hl_dyn_setp (ret, hl_hash_utf8 ("kerning"), &hlt_array, 0);
+		GlyphMetricsMap* cache = (GlyphMetricsMap*)metricsCache;
+		GlyphMetricsMap::iterator it = cache->find (index);
 
-			}
+		if (it != cache->end ()) {
 
-			return ret;
+			*(FT_Glyph_Metrics*)metrics = it->second;
+			return true;
 
 		}
 
-	}
+		if (FT_Load_Glyph ((FT_Face)face, index, FT_LOAD_NO_BITMAP | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_DEFAULT) != 0) {
 
+			return false;
 
-	int Font::GetAscender () {
+		}
 
-		#ifdef LIME_FREETYPE_SWF_METRICS
+		*(FT_Glyph_Metrics*)metrics = ((FT_Face)face)->glyph->metrics;
+		(*cache)[index] = ((FT_Face)face)->glyph->metrics;
+		return true;
 
-		// this should more closely match how [Embed] works in AS3 when
-		// embedding a font in a SWF
+	}
 
-		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
-		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
 
-		if (os2 && os2->version != 0xFFFFU) {
+	void* Font::NewFace () {
 
-			return (FT_Short)os2->usWinAscent;
+		// opens another face over the same memory, the caller owns it
 
-		} else if (hhea) {
+		if (!library || !faceMemory) {
 
-			return hhea->Ascender;
+			return 0;
 
 		}
 
-		// should never happen, but let's have a fallback to be safe
-		return ((FT_Face)face)->ascender;
+		std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
 
-		#elif defined(LIME_FREETYPE_LEGACY_METRICS)
+		FT_Face newFace;
 
-		// this is FreeType's font metrics algorithm from 2.9.1
-		// it behaves more like SWF than the new algorithm
+		if (FT_New_Memory_Face ((FT_Library)library, faceMemory->data, faceMemory->size, faceIndex, &newFace) != 0) {
 
-		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
-		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+			return 0;
 
-		int calculatedAscender = 0;
-		int calculatedDescender = 0;
+		}
 
-		if (hhea) {
+		int charmap = ((FT_Face)face)->charmap ? FT_Get_Charmap_Index (((FT_Face)face)->charmap) : -1;
+
+		if (charmap >= 0 && charmap < newFace->num_charmaps) {
+
+			FT_Set_Charmap (newFace, newFace->charmaps[charmap]);
 
-			calculatedAscender = hhea->Ascender;
-			calculatedDescender = hhea->Descender;
 		}
 
-        if (!( calculatedAscender || calculatedDescender ))
-        {
-			if (os2 && os2->version != 0xFFFFU)
-			{
-				if (os2->sTypoAscender || os2->sTypoDescender)
-				{
+		return newFace;
 
-					calculatedAscender = os2->sTypoAscender;
-					calculatedDescender = os2->sTypoDescender;
+	}
 
-				}
-				else
-				{
 
-					calculatedAscender = (FT_Short)os2->usWinAscent;
-					calculatedDescender = -(FT_Short)os2->usWinDescent;
+	void Font::ReleaseFace (void* face) {
 
-				}
-			}
-        }
+		if (!face) {
 
-		if (!calculatedAscender || !calculatedDescender) {
+			return;
 
-			calculatedAscender = ((FT_Face)face)->ascender;
-			calculatedDescender = ((FT_Face)face)->descender;
+		}
+
+		std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
+
+		FontMemory* memory = (FontMemory*)((FT_Face)face)->generic.data;
+
+		FT_Done_Face ((FT_Face)face);
+		library_release ();
+
+		if (memory) {
+
+			memory->Release ();
 
 		}
 
-		return calculatedAscender;
+	}
 
-		#else
 
-		return ((FT_Face)face)->ascender;
+	int Font::RenderGlyph (int index, Bytes *bytes, int offset) {
 
-		#endif
+		return RenderGlyphFace (index, bytes, offset, 0);
 
 	}
 
 
-	int Font::GetDescender () {
+	int Font::RenderGlyphFace (int index, Bytes *bytes, int offset, void* renderFace) {
 
-		#ifdef LIME_FREETYPE_SWF_METRICS
+		switch (mRenderMode) {
 
-		// this should more closely match how [Embed] works in AS3 when
-		// embedding a font in a SWF
+			case GLYPH_RENDER_A8:
+			case GLYPH_RENDER_MONO:
 
-		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
-		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+				return RenderGlyphMask (index, bytes, offset, renderFace);
 
-		if (os2 && os2->version != 0xFFFFU) {
+			case GLYPH_RENDER_SDF:
 
-			return -(FT_Short)os2->usWinDescent;
+				return RenderGlyphSDF (index, bytes, offset, renderFace);
 
-		}
-		else if (hhea) {
+			default:
 
-			return hhea->Descender;
+				return RenderGlyphLCD (index, bytes, offset, renderFace);
 
 		}
 
-		// should never happen, but let's have a fallback to be safe
-		return ((FT_Face)face)->descender;
+	}
 
-		#elif defined(LIME_FREETYPE_LEGACY_METRICS)
 
-		// this is FreeType's font metrics algorithm from 2.9.1
-		// it behaves more like SWF than the new algorithm
+	int Font::RenderGlyphLCD(int index, Bytes *bytes, int offset, void* renderFace)
+	{
+		FT_Glyph glyph = (FT_Glyph)LoadGlyph(index, FT_LOAD_FORCE_AUTOHINT | FT_LOAD_DEFAULT, renderFace);
+		int size = 0;
 
-		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
-		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+		if (glyph)
+		{
+			//The hinted outline comes from the glyph cache, only the LCD rasterization is done here
+			if (FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_LCD, 0, 1) == 0)
+			{
+				FT_BitmapGlyph bitmapGlyph = (FT_BitmapGlyph)glyph;
+				FT_Bitmap bitmap = bitmapGlyph->bitmap;
 
-		int calculatedAscender = 0;
-		int calculatedDescender = 0;
+				int height = bitmap.rows;
+				int width = bitmap.width / 3; //Due to each pixel now has 3 components (R, G, B)
+				int pitch = bitmap.pitch;
 
-		if (hhea) {
+				if (width == 0 || height == 0)
+				{
+					FT_Done_Glyph(glyph);
+					return 0;
+				}
 
-			calculatedAscender = hhea->Ascender;
-			calculatedDescender = hhea->Descender;
+				//We calculate the size needed for the glyph image, including metadata and 24-bit RGB color data
+				size = sizeof(GlyphImage) + (width * height * 4);
 
-		}
+				if (bytes->length < size + offset)
+				{
+					bytes->Resize(size + offset);
+				}
 
-        if (!( calculatedAscender || calculatedDescender ))
-        {
-			if (os2 && os2->version != 0xFFFFU)
-			{
-				if (os2->sTypoAscender || os2->sTypoDescender)
+				GlyphImage *data = (GlyphImage *)(bytes->b + offset);
+
+				//We should initialize the GlyphImage struct here with zero to avoid uninitialized values
+				memset(data, 0, sizeof(GlyphImage));
+
+				data->index = index;
+				data->width = width;
+				data->height = height;
+				data->x = bitmapGlyph->left;
+				data->y = bitmapGlyph->top;
+
+				unsigned char *position = &data->data;
+
+				//Copy the bitmap data row by row, copying each RGB triplet and adding padding for 32-bit alignment
+				for (int i = 0; i < height; i++)
 				{
+					for (int j = 0; j < width; j++)
+					{
+						unsigned char r = bitmap.buffer[i * pitch + j * 3 + 0];
+						unsigned char g = bitmap.buffer[i * pitch + j * 3 + 1];
+						unsigned char b = bitmap.buffer[i * pitch + j * 3 + 2];
+						unsigned char a = (r + g + b) / 3;
+
+						//Red
+						position[(i * width + j) * 4 + 0] = r;
+						//Green
+						position[(i * width + j) * 4 + 1] = g;
+						//Blue
+						position[(i * width + j) * 4 + 2] = b;
+						//Alpha
+						position[(i * width + j) * 4 + 3] = a;
+					}
+				}
+			}
+
+			FT_Done_Glyph(glyph);
+		}
+
+		return size;
+	}
 
-					calculatedAscender = os2->sTypoAscender;
-					calculatedDescender = os2->sTypoDescender;
 
-				}
-				else
-				{
+	int Font::RenderGlyphMask (int index, Bytes *bytes, int offset, void* renderFace) {
 
-					calculatedAscender = (FT_Short)os2->usWinAscent;
-					calculatedDescender = -(FT_Short)os2->usWinDescent;
+		bool mono = (mRenderMode == GLYPH_RENDER_MONO);
+		FT_Int32 flags = FT_LOAD_FORCE_AUTOHINT | (mono ? FT_LOAD_TARGET_MONO : FT_LOAD_DEFAULT);
+		FTC_ScalerRec scaler;
 
-				}
-			}
-        }
+		if (!renderFace && GetCacheScaler (&scaler)) {
 
-		if (!calculatedAscender || !calculatedDescender) {
+			std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
 
-			calculatedAscender = ((FT_Face)face)->ascender;
-			calculatedDescender = ((FT_Face)face)->descender;
+			FTC_SBit sbit;
 
-		}
+			// glyphs too large for an sbit are marked with a width of 255 and no buffer, those are rasterized below
 
-		return calculatedDescender;
+			if (cache_open () && FTC_SBitCache_LookupScaler (cacheSBits, &scaler, flags, index, &sbit, NULL) == 0 && (sbit->buffer || sbit->width != 255)) {
 
-		#else
+				return write_glyph_mask (bytes, offset, index, sbit->width, sbit->height, sbit->left, sbit->top, sbit->buffer, sbit->pitch, sbit->format, mono);
 
-		return ((FT_Face)face)->descender;
+			}
 
-		#endif
+		}
 
-	}
+		FT_Glyph glyph = (FT_Glyph)LoadGlyph (index, flags, renderFace);
+		int size = 0;
 
+		if (glyph) {
 
-	wchar_t *Font::GetFamilyName () {
+			if (FT_Glyph_To_Bitmap (&glyph, mono ? FT_RENDER_MODE_MONO : FT_RENDER_MODE_NORMAL, 0, 1) == 0) {
 
-		#ifdef LIME_FREETYPE
+				FT_BitmapGlyph bitmapGlyph = (FT_BitmapGlyph)glyph;
+				FT_Bitmap* bitmap = &bitmapGlyph->bitmap;
+				size = write_glyph_mask (bytes, offset, index, bitmap->width, bitmap->rows, bitmapGlyph->left, bitmapGlyph->top, bitmap->buffer, bitmap->pitch, bitmap->pixel_mode, mono);
 
-		wchar_t *family_name = NULL;
-		FT_SfntName sfnt_name;
-		FT_UInt num_sfnt_names, sfnt_name_index;
-		int len, i;
+			}
 
-		if (FT_IS_SFNT (((FT_Face)face))) {
+			FT_Done_Glyph (glyph);
 
-			num_sfnt_names = FT_Get_Sfnt_Name_Count ((FT_Face)face);
-			sfnt_name_index = 0;
+		}
 
-			while (sfnt_name_index < num_sfnt_names) {
+		return size;
 
-				if (!FT_Get_Sfnt_Name ((FT_Face)face, sfnt_name_index++, (FT_SfntName *)&sfnt_name) && sfnt_name.name_id == TT_NAME_ID_FULL_NAME) {
+	}
 
-					if (sfnt_name.platform_id == TT_PLATFORM_MACINTOSH) {
 
-						len = sfnt_name.string_len;
-						family_name = new wchar_t[len + 1];
-						#if defined(ANDROID) && !defined(HXCPP_CLANG)
-						// Fix some devices (Android 4.x or older) that have a bad stdc implementation
-						_mbsrtowcs (family_name, (const char**)&sfnt_name.string, len, 0);
-						#else
-						mbstowcs (family_name, (const char*)sfnt_name.string, len);
-						#endif
-						family_name[len] = L'\0';
-						return family_name;
+	int Font::RenderGlyphSDF (int index, Bytes *bytes, int offset, void* renderFace) {
 
-					} else if ((sfnt_name.platform_id == TT_PLATFORM_MICROSOFT) && (sfnt_name.encoding_id == TT_MS_ID_UNICODE_CS)) {
+		// the spread is a property of the shared renderers, so it is applied and used under the library lock,
+		// workers render while RenderGlyphs holds that lock for them
 
-						len = sfnt_name.string_len / 2;
-						family_name = (wchar_t*)malloc ((len + 1) * sizeof (wchar_t));
+		std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex, std::defer_lock);
 
-						for (i = 0; i < len; i++) {
+		if (!renderFace) {
 
-							family_name[i] = ((wchar_t)sfnt_name.string[i * 2 + 1]) | (((wchar_t)sfnt_name.string[i * 2]) << 8);
+			lock.lock ();
+			FT_Property_Set ((FT_Library)library, "sdf", "spread", &mSDFSpread);
+			FT_Property_Set ((FT_Library)library, "bsdf", "spread", &mSDFSpread);
 
-						}
+		}
 
-						family_name[len] = L'\0';
-						return family_name;
+		FT_Face target = renderFace ? (FT_Face)renderFace : (FT_Face)face;
+		int size = 0;
 
-					}
+		if (!FT_IS_SCALABLE (target)) {
 
-				}
+			// bitmap-only faces go through the 'bsdf' renderer, which only works on a glyph slot
 
-			}
+			if (FT_Load_Glyph (target, index, FT_LOAD_DEFAULT) == 0 && FT_Render_Glyph (target->glyph, FT_RENDER_MODE_SDF) == 0) {
 
-		}
+				FT_GlyphSlot slot = target->glyph;
+				size = write_glyph_mask (bytes, offset, index, slot->bitmap.width, slot->bitmap.rows, slot->bitmap_left, slot->bitmap_top, slot->bitmap.buffer, slot->bitmap.pitch, slot->bitmap.pixel_mode, false);
 
-		#endif
+			}
 
-		return NULL;
+			return size;
 
-	}
+		}
 
+		// distance fields are scaled when drawn, so the outline is left unhinted
 
-	int Font::GetGlyphIndex (const char* character) {
+		FT_Glyph glyph = (FT_Glyph)LoadGlyph (index, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP, renderFace);
 
-		long charCode = readNextChar (character);
+		if (glyph) {
 
-		return FT_Get_Char_Index ((FT_Face)face, charCode);
+			if (FT_Glyph_To_Bitmap (&glyph, FT_RENDER_MODE_SDF, 0, 1) == 0) {
 
-	}
+				FT_BitmapGlyph bitmapGlyph = (FT_BitmapGlyph)glyph;
+				FT_Bitmap* bitmap = &bitmapGlyph->bitmap;
+				size = write_glyph_mask (bytes, offset, index, bitmap->width, bitmap->rows, bitmapGlyph->left, bitmapGlyph->top, bitmap->buffer, bitmap->pitch, bitmap->pixel_mode, false);
 
+			}
 
-	void* Font::GetGlyphIndices (bool useCFFIValue, const char* characters) {
+			FT_Done_Glyph (glyph);
 
-		if (useCFFIValue) {
+		}
 
-			value indices = alloc_array (0);
-			unsigned long character;
-			int index;
+		return size;
 
-			while (*characters != 0) {
+	}
 
-				character = readNextChar (characters);
-				index = FT_Get_Char_Index ((FT_Face)face, character);
-				val_array_push (indices, alloc_int (index));
 
-			}
+	int Font::RenderGlyphs (value indices, Bytes *bytes) {
 
-			return indices;
+		int numIndices = val_array_size (indices);
+		std::vector<int> glyphs (numIndices);
 
-		} else {
+		for (int i = 0; i < numIndices; i++) {
 
-			unsigned long character;
-			int index;
-			int count = 0;
+			glyphs[i] = val_int (val_array_i (indices, i));
 
-			// TODO: Determine array size first
+		}
 
-			while (*characters != 0) {
+		return RenderGlyphs (numIndices > 0 ? &glyphs[0] : 0, numIndices, bytes, 1);
 
-				character = readNextChar (characters);
-				count++;
+	}
 
-			}
 
-			hl_varray* indices = (hl_varray*)hl_alloc_array (&hlt_i32, count);
-			int* indicesData = hl_aptr (indices, int);
+	int Font::RenderGlyphs (const int* indices, int count, Bytes *bytes, int numThreads) {
 
-			while (*characters != 0) {
+		// every worker renders a contiguous run of the indices with a face of its own, the runs are then
+		// joined in order, so the packed output is the same as rendering the list serially
 
-				character = readNextChar (characters);
-				*indicesData++ = FT_Get_Char_Index ((FT_Face)face, character);
+		int offset = 0;
+		int totalOffset = 4;
+		uint32_t total = 0;
 
-			}
+		if (numThreads <= 0) {
 
-			return indices;
+			numThreads = Parallel::GetConcurrency ();
 
 		}
 
-	}
+		// opening a face costs about as much as rendering a few dozen glyphs
 
+		int numWorkers = std::min (numThreads, count / 32);
+		FTC_ScalerRec scaler;
+		RenderGlyphsJob job;
 
-	void* Font::GetGlyphMetrics (bool useCFFIValue, int index) {
+		if (numWorkers > 1 && GetCacheScaler (&scaler)) {
 
-		if (useCFFIValue) {
+			std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
 
-			initialize ();
+			for (int i = 0; i < numWorkers; i++) {
 
-			if (FT_Load_Glyph ((FT_Face)face, index, FT_LOAD_NO_BITMAP | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_DEFAULT) == 0) {
+				FT_Face workerFace = (FT_Face)NewFace ();
 
-				value metrics = alloc_empty_object ();
+				if (!workerFace) {
 
-				alloc_field (metrics, id_height, alloc_int (((FT_Face)face)->glyph->metrics.height));
-				alloc_field (metrics, id_horizontalBearingX, alloc_int (((FT_Face)face)->glyph->metrics.horiBearingX));
-				alloc_field (metrics, id_horizontalBearingY, alloc_int (((FT_Face)face)->glyph->metrics.horiBearingY));
-				alloc_field (metrics, id_horizontalAdvance, alloc_int (((FT_Face)face)->glyph->metrics.horiAdvance));
-				alloc_field (metrics, id_verticalBearingX, alloc_int (((FT_Face)face)->glyph->metrics.vertBearingX));
-				alloc_field (metrics, id_verticalBearingY, alloc_int (((FT_Face)face)->glyph->metrics.vertBearingY));
-				alloc_field (metrics, id_verticalAdvance, alloc_int (((FT_Face)face)->glyph->metrics.vertAdvance));
+					break;
 
-				return metrics;
+				}
 
-			}
+				FT_Set_Char_Size (workerFace, 0, scaler.height, scaler.x_res, scaler.y_res);
+				job.faces.push_back (workerFace);
 
-			return alloc_null ();
+			}
 
-		} else {
+			numWorkers = job.faces.size ();
 
-			if (FT_Load_Glyph ((FT_Face)face, index, FT_LOAD_NO_BITMAP | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_DEFAULT) == 0) {
+			if (numWorkers <= 1) {
 
-				const int id_height = hl_hash_utf8 ("height");
-				const int id_horizontalBearingX = hl_hash_utf8 ("horizontalBearingX");
-				const int id_horizontalBearingY = hl_hash_utf8 ("horizontalBearingY");
-				const int id_horizontalAdvance = hl_hash_utf8 ("horizontalAdvance");
-				const int id_verticalBearingX = hl_hash_utf8 ("verticalBearingX");
-				const int id_verticalBearingY = hl_hash_utf8 ("verticalBearingY");
-				const int id_verticalAdvance = hl_hash_utf8 ("verticalAdvance");
+				for (size_t i = 0; i < job.faces.size (); i++) {
 
-				vdynamic* metrics = (vdynamic*)hl_alloc_dynobj ();
+					FT_Done_Face ((FT_Face)job.faces[i]);
 
-				hl_dyn_seti (metrics, id_height, &hlt_i32, ((FT_Face)face)->glyph->metrics.height);
-				hl_dyn_seti (metrics, id_horizontalBearingX, &hlt_i32, ((FT_Face)face)->glyph->metrics.horiBearingX);
-				hl_dyn_seti (metrics, id_horizontalBearingY, &hlt_i32, ((FT_Face)face)->glyph->metrics.horiBearingY);
-				hl_dyn_seti (metrics, id_horizontalAdvance, &hlt_i32, ((FT_Face)face)->glyph->metrics.horiAdvance);
-				hl_dyn_seti (metrics, id_verticalBearingX, &hlt_i32, ((FT_Face)face)->glyph->metrics.vertBearingX);
-				hl_dyn_seti (metrics, id_verticalBearingY, &hlt_i32, ((FT_Face)face)->glyph->metrics.vertBearingY);
-				hl_dyn_seti (metrics, id_verticalAdvance, &hlt_i32, ((FT_Face)face)->glyph->metrics.vertAdvance);
+				}
 
-				return metrics;
+				job.faces.clear ();
 
 			}
 
-			return 0;
-
 		}
 
-	}
+		if (job.faces.empty ()) {
 
+			for (int i = 0; i < count; i++) {
 
-	int Font::GetHeight () {
+				offset = RenderGlyph (indices[i], bytes, totalOffset);
 
-		#ifdef LIME_FREETYPE_SWF_METRICS
+				if (offset > 0) {
 
-		// this should more closely match how [Embed] works in AS3 when
-		// embedding a font in a SWF
+					totalOffset += offset;
+					total++;
 
-		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
-		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+				}
 
-		if (os2 && os2->version != 0xFFFFU) {
+			}
 
-			int calculatedAscender = (FT_Short)os2->usWinAscent;
-			int calculatedDescender = -(FT_Short)os2->usWinDescent;
-			return calculatedAscender - calculatedDescender;
+			if (total > 0) {
 
-		} else if (hhea) {
+				*(uint32_t*)(bytes->b) = total;
 
-			int calculatedAscender = hhea->Ascender;
-			int calculatedDescender = hhea->Descender;
-			return calculatedAscender - calculatedDescender + hhea->Line_Gap;
+			}
+
+			return totalOffset;
 
 		}
 
-		// should never happen, but let's have a fallback to be safe
-		return ((FT_Face)face)->height;
+		job.chunkSize = (count + numWorkers - 1) / numWorkers;
+		job.count = count;
+		job.counts.resize (numWorkers, 0);
+		job.font = this;
+		job.indices = indices;
+		job.sizes.resize (numWorkers, 0);
 
-		#elif defined(LIME_FREETYPE_LEGACY_METRICS)
+		for (int i = 0; i < numWorkers; i++) {
 
-		// this is FreeType's font metrics algorithm from 2.9.1
-		// it behaves more like SWF than the new algorithm
+			job.output.push_back (new Bytes ());
 
-		TT_OS2* os2 = (TT_OS2*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_os2);
-		TT_HoriHeader* hhea = (TT_HoriHeader*)FT_Get_Sfnt_Table(((FT_Face)face), ft_sfnt_hhea);
+		}
 
-		int calculatedAscender = 0;
-		int calculatedDescender = 0;
-		int calculatedHeight = 0;
+		std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex, std::defer_lock);
 
-		if (hhea) {
+		if (mRenderMode == GLYPH_RENDER_SDF) {
 
-			calculatedAscender = hhea->Ascender;
-			calculatedDescender = hhea->Descender;
-			calculatedHeight = calculatedAscender - calculatedDescender + hhea->Line_Gap;
+			lock.lock ();
+			FT_Property_Set ((FT_Library)library, "sdf", "spread", &mSDFSpread);
+			FT_Property_Set ((FT_Library)library, "bsdf", "spread", &mSDFSpread);
 
 		}
 
-        if (!( calculatedAscender || calculatedDescender ))
-        {
-			if (os2 && os2->version != 0xFFFFU)
-			{
-				if (os2->sTypoAscender || os2->sTypoDescender)
-				{
-
-					calculatedAscender = os2->sTypoAscender;
-					calculatedDescender = os2->sTypoDescender;
-					calculatedHeight = calculatedAscender - calculatedDescender + os2->sTypoLineGap;
+		Parallel::For (numWorkers, numWorkers, RenderGlyphsTask, &job);
 
-				}
-				else
-				{
+		if (lock.owns_lock ()) {
 
-					calculatedAscender = (FT_Short)os2->usWinAscent;
-					calculatedDescender = -(FT_Short)os2->usWinDescent;
-					calculatedHeight = calculatedAscender - calculatedDescender;
+			lock.unlock ();
 
-				}
-			}
-        }
+		}
 
-        if (!calculatedHeight) {
+		for (int i = 0; i < numWorkers; i++) {
 
-			calculatedHeight = ((FT_Face)face)->height;
+			totalOffset += job.sizes[i];
+			total += job.counts[i];
 
 		}
 
-		return calculatedHeight;
+		if (total > 0) {
 
-		#else
+			if (bytes->length < totalOffset) {
 
-		return ((FT_Face)face)->height;
+				bytes->Resize (totalOffset);
 
-		#endif
+			}
 
-	}
+			*(uint32_t*)(bytes->b) = total;
+			offset = 4;
 
+			for (int i = 0; i < numWorkers; i++) {
 
-	int Font::GetNumGlyphs () {
+				if (job.sizes[i] > 0) {
 
-		return ((FT_Face)face)->num_glyphs;
+					memcpy (bytes->b + offset, job.output[i]->b, job.sizes[i]);
+					offset += job.sizes[i];
 
-	}
+				}
 
+			}
 
-	int Font::GetUnderlinePosition () {
+		}
 
-		return ((FT_Face)face)->underline_position;
+		std::unique_lock<std::recursive_mutex> faceLock (sharedLibraryMutex);
 
-	}
+		for (int i = 0; i < numWorkers; i++) {
 
+			job.output[i]->Resize (0);
+			delete job.output[i];
+			FT_Done_Face ((FT_Face)job.faces[i]);
 
-	int Font::GetUnderlineThickness () {
+		}
 
-		return ((FT_Face)face)->underline_thickness;
+		return totalOffset;
 
 	}
 
 
-	int Font::GetUnitsPerEM () {
+	void Font::RenderGlyphsTask (int index, void* userData) {
 
-		return ((FT_Face)face)->units_per_EM;
+		RenderGlyphsJob* job = (RenderGlyphsJob*)userData;
 
-	}
+		int start = index * job->chunkSize;
+		int end = std::min (start + job->chunkSize, job->count);
+		int offset = 0;
+		int size;
 
+		for (int i = start; i < end; i++) {
 
-	int Font::RenderGlyph(int index, Bytes *bytes, int offset)
-	{
-		if (FT_Load_Glyph((FT_Face)face, index, FT_LOAD_FORCE_AUTOHINT | FT_LOAD_DEFAULT) == 0)
-		{
-			if (FT_Render_Glyph(((FT_Face)face)->glyph, FT_RENDER_MODE_LCD) == 0)
-			{
-				FT_Bitmap bitmap = ((FT_Face)face)->glyph->bitmap;
+			size = job->font->RenderGlyphFace (job->indices[i], job->output[index], offset, job->faces[index]);
 
-				int height = bitmap.rows;
-				int width = bitmap.width / 3; //Due to each pixel now has 3 components (R, G, B)
-				int pitch = bitmap.pitch;
+			if (size > 0) {
 
-				if (width == 0 || height == 0)
-					return 0;
+				offset += size;
+				job->counts[index]++;
 
-				//We calculate the size needed for the glyph image, including metadata and 24-bit RGB color data
-				uint32_t size = sizeof(GlyphImage) + (width * height * 4);
+			}
 
-				if (bytes->length < size + offset)
-				{
-					bytes->Resize(size + offset);
-				}
+		}
 
-				GlyphImage *data = (GlyphImage *)(bytes->b + offset);
+		job->sizes[index] = offset;
 
-				//We should initialize the GlyphImage struct here with zero to avoid uninitialized values
-				memset(data, 0, sizeof(GlyphImage));
+	}
 
-				data->index = index;
-				data->width = width;
-				data->height = height;
-				data->x = ((FT_Face)face)->glyph->bitmap_left;
-				data->y = ((FT_Face)face)->glyph->bitmap_top;
 
-				unsigned char *position = &data->data;
+	void Font::SetCacheBudget (int bytes) {
 
-				//Copy the bitmap data row by row, copying each RGB triplet and adding padding for 32-bit alignment
-				for (int i = 0; i < height; i++)
-				{
-					for (int j = 0; j < width; j++)
-					{
-						unsigned char r = bitmap.buffer[i * pitch + j * 3 + 0];
-						unsigned char g = bitmap.buffer[i * pitch + j * 3 + 1];
-						unsigned char b = bitmap.buffer[i * pitch + j * 3 + 2];
-						unsigned char a = (r + g + b) / 3;
+		// the cache is rebuilt lazily with the new budget
 
-						//Red
-						position[(i * width + j) * 4 + 0] = r;
-						//Green
-						position[(i * width + j) * 4 + 1] = g;
-						//Blue
-						position[(i * width + j) * 4 + 2] = b;
-						//Alpha
-						position[(i * width + j) * 4 + 3] = a;
-					}
-				}
+		std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
 
-				return size;
-			}
-		}
+		cacheBudget = bytes > 0 ? bytes : 0;
+		cache_reset ();
 
-		return 0;
 	}
 
 
-	int Font::RenderGlyphs (value indices, Bytes *bytes) {
+	void* Font::RetainFace () {
 
-		int offset = 0;
-		int totalOffset = 4;
-		uint32_t count = 0;
+		// like NewFace, but the face holds references to the library and the font memory, so it
+		// stays valid after this Font is destroyed. It must be closed with ReleaseFace
 
-		int numIndices = val_array_size (indices);
+		std::unique_lock<std::recursive_mutex> lock (sharedLibraryMutex);
 
-		for (int i = 0; i < numIndices; i++) {
+		FT_Face newFace = (FT_Face)NewFace ();
 
-			offset = RenderGlyph (val_int (val_array_i (indices, i)), bytes, totalOffset);
+		if (!newFace) {
 
-			if (offset > 0) {
+			return 0;
 
-				totalOffset += offset;
-				count++;
+		}
 
-			}
+		library_retain ();
+		newFace->generic.data = faceMemory->Retain ();
+		newFace->generic.finalizer = 0;
 
-		}
+		return newFace;
 
-		if (count > 0) {
+	}
 
-			*(uint32_t*)(bytes->b) = count;
 
-		}
+	void Font::SetRenderMode (GlyphRenderMode mode) {
 
-		return totalOffset;
+		mRenderMode = mode;
+
+	}
+
+
+	void Font::SetSDFSpread (int spread) {
+
+		// the distance in pixels that maps to the full 0-255 range, FreeType accepts 2 to 32
+
+		mSDFSpread = spread < 2 ? 2 : (spread > 32 ? 32 : spread);
 
 	}
 
+
 	void Font::SetSize(size_t size, size_t dpi)
 	{
 		//We changed the function signature to include a dpi argument which changes this from
@@ -1374,9 +2744,19 @@ namespace lime {
 			hdpi,								//Horizontal DPI
 			vdpi								//Vertical DPI
 		);
+		mCharHeight = static_cast<int>(size * 64);
+		mDPI = dpi;
+		mScale = ((FT_Face)face)->size->metrics.y_scale;
 		mSize = size;
 
 	}
 
 
+	int Font::TriangulateGlyphs (int em, const int* indices, int count, float tolerance, Bytes* output) {
+
+		return DecomposeOutlines (em, indices, count, tolerance > 0 ? tolerance : 16, output);
+
+	}
+
+
 }
@@ -0,0 +1,260 @@
+#include <text/FontMemory.h>
+#include <system/System.h>
+#include <map>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined (HX_WINDOWS) && !defined (HX_WINRT)
+#include <windows.h>
+#include <io.h>
+#elif !defined (HX_WINDOWS)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+namespace lime {
+
+
+	static std::map<std::string, FontMemory*> openFiles;
+	static std::mutex openFilesMutex;
+
+
+	static void* map_file (FILE* file, size_t* size) {
+
+		// the mapping stays valid after the file is closed, pages are only read in as FreeType touches them
+
+		#if defined (HX_WINDOWS) && !defined (HX_WINRT)
+
+		HANDLE handle = (HANDLE)_get_osfhandle (_fileno (file));
+		LARGE_INTEGER length;
+
+		if (handle == INVALID_HANDLE_VALUE || !GetFileSizeEx (handle, &length) || length.QuadPart <= 0 || (unsigned long long)length.QuadPart > (size_t)-1) {
+
+			return 0;
+
+		}
+
+		HANDLE mapping = CreateFileMappingW (handle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (!mapping) {
+
+			return 0;
+
+		}
+
+		void* view = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle (mapping);
+
+		if (!view) {
+
+			return 0;
+
+		}
+
+		*size = (size_t)length.QuadPart;
+		return view;
+
+		#elif !defined (HX_WINDOWS)
+
+		int fd = fileno (file);
+		struct stat info;
+
+		if (fd < 0 || fstat (fd, &info) != 0 || info.st_size <= 0) {
+
+			return 0;
+
+		}
+
+		void* view = mmap (NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (view == MAP_FAILED) {
+
+			return 0;
+
+		}
+
+		*size = info.st_size;
+		return view;
+
+		#else
+
+		return 0;
+
+		#endif
+
+	}
+
+
+	static void unmap_file (const unsigned char* data, size_t size) {
+
+		#if defined (HX_WINDOWS) && !defined (HX_WINRT)
+		UnmapViewOfFile (data);
+		#elif !defined (HX_WINDOWS)
+		munmap ((void*)data, size);
+		#endif
+
+	}
+
+
+	FontMemory::FontMemory () {
+
+		data = 0;
+		mapped = false;
+		refs = 1;
+		size = 0;
+
+	}
+
+
+	FontMemory::~FontMemory () {
+
+		if (mapped) {
+
+			unmap_file (data, size);
+
+		} else {
+
+			free ((void*)data);
+
+		}
+
+	}
+
+
+	FontMemory* FontMemory::Create (const unsigned char* data, size_t size) {
+
+		// bytes owned by the GC can move or be collected, so these are copied once and shared from then on
+
+		if (!data || size == 0) {
+
+			return 0;
+
+		}
+
+		unsigned char* copy = (unsigned char*)malloc (size);
+
+		if (!copy) {
+
+			return 0;
+
+		}
+
+		memcpy (copy, data, size);
+
+		FontMemory* memory = new FontMemory ();
+		memory->data = copy;
+		memory->size = size;
+		return memory;
+
+	}
+
+
+	FontMemory* FontMemory::Open (const char* path) {
+
+		if (!path) {
+
+			return 0;
+
+		}
+
+		std::unique_lock<std::mutex> lock (openFilesMutex);
+
+		std::map<std::string, FontMemory*>::iterator it = openFiles.find (path);
+
+		if (it != openFiles.end ()) {
+
+			it->second->refs++;
+			return it->second;
+
+		}
+
+		FILE_HANDLE* file = lime::fopen (path, "rb");
+
+		if (!file) {
+
+			return 0;
+
+		}
+
+		FontMemory* memory = new FontMemory ();
+
+		if (file->isFile ()) {
+
+			memory->data = (const unsigned char*)map_file (file->getFile (), &memory->size);
+			memory->mapped = (memory->data != 0);
+
+		}
+
+		if (!memory->mapped) {
+
+			// packaged assets (such as on Android) and platforms without mappings are read into memory
+
+			lime::fseek (file, 0, SEEK_END);
+			long length = lime::ftell (file);
+			lime::fseek (file, 0, SEEK_SET);
+
+			unsigned char* buffer = length > 0 ? (unsigned char*)malloc (length) : 0;
+
+			if (buffer && lime::fread (buffer, 1, length, file) == (size_t)length) {
+
+				memory->data = buffer;
+				memory->size = length;
+
+			} else {
+
+				free (buffer);
+
+			}
+
+		}
+
+		lime::fclose (file);
+
+		if (!memory->data) {
+
+			delete memory;
+			return 0;
+
+		}
+
+		memory->path = path;
+		openFiles[memory->path] = memory;
+		return memory;
+
+	}
+
+
+	void FontMemory::Release () {
+
+		std::unique_lock<std::mutex> lock (openFilesMutex);
+
+		if (--refs > 0) {
+
+			return;
+
+		}
+
+		if (!path.empty ()) {
+
+			openFiles.erase (path);
+
+		}
+
+		delete this;
+
+	}
+
+
+	FontMemory* FontMemory::Retain () {
+
+		std::unique_lock<std::mutex> lock (openFilesMutex);
+
+		refs++;
+		return this;
+
+	}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,590 @@
+#include <text/GlyphAtlas.h>
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+
+#ifdef LIME_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#endif
+
+
+namespace lime {
+
+
+	bool GlyphAtlasKey::operator== (const GlyphAtlasKey& other) const {
+
+		return font == other.font && index == other.index && mode == other.mode && scale == other.scale;
+
+	}
+
+
+	size_t GlyphAtlasKeyHash::operator() (const GlyphAtlasKey& key) const {
+
+		size_t hash = (size_t)key.font;
+		hash ^= (size_t)key.index + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= (size_t)key.mode + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= (size_t)key.scale + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		return hash;
+
+	}
+
+
+	GlyphAtlasPage::GlyphAtlasPage (int width, int height, int bitsPerPixel) {
+
+		// allocated on the calling (GC) thread, so CFFI ids are never initialized elsewhere
+
+		buffer = new ImageBuffer (alloc_null ());
+		buffer->data = new ArrayBufferView (alloc_null ());
+		buffer->Resize (width, height, bitsPerPixel);
+		buffer->premultiplied = true;
+		buffer->transparent = true;
+		memset (buffer->data->buffer->b, 0, buffer->data->byteLength);
+
+		dirty.page = 0;
+		dirty.x = 0;
+		dirty.y = 0;
+		dirty.width = 0;
+		dirty.height = 0;
+		lastFrame = 0;
+
+		GlyphAtlasNode node = { width, 0, 0 };
+		skyline.push_back (node);
+
+	}
+
+
+	GlyphAtlasPage::~GlyphAtlasPage () {
+
+		if (buffer) {
+
+			if (buffer->data) {
+
+				buffer->data->buffer->Resize (0);
+
+			}
+
+			delete buffer;
+
+		}
+
+	}
+
+
+	GlyphAtlas::GlyphAtlas (int pageWidth, int pageHeight, int maxPages, int bitsPerPixel, int padding) {
+
+		this->bitsPerPixel = bitsPerPixel == 8 ? 8 : 32;
+		this->maxPages = maxPages > 0 ? maxPages : 1;
+		this->padding = padding > 0 ? padding : 0;
+		this->pageHeight = pageHeight;
+		this->pageWidth = pageWidth;
+		evictions = 0;
+		frame = 1;
+		scratch = new Bytes ();
+
+	}
+
+
+	GlyphAtlas::~GlyphAtlas () {
+
+		for (size_t i = 0; i < pages.size (); i++) {
+
+			delete pages[i];
+
+		}
+
+		scratch->Resize (0);
+		delete scratch;
+
+	}
+
+
+	GlyphAtlasEntry* GlyphAtlas::AddGlyph (Font* font, int index) {
+
+		#ifdef LIME_FREETYPE
+		if (!font || !font->face) {
+
+			return 0;
+
+		}
+
+		GlyphRenderMode mode = font->GetRenderMode ();
+
+		GlyphAtlasKey key;
+		key.font = font->GetID ();
+		key.index = index;
+		key.mode = (mode == GLYPH_RENDER_SDF) ? (mode | (font->GetSDFSpread () << 8)) : mode;
+		key.scale = ((FT_Face)font->face)->size->metrics.y_scale;
+
+		std::unordered_map<GlyphAtlasKey, GlyphAtlasEntry, GlyphAtlasKeyHash>::iterator it = entries.find (key);
+
+		if (it != entries.end ()) {
+
+			if (it->second.page >= 0) {
+
+				pages[it->second.page]->lastFrame = frame;
+
+			}
+
+			return &it->second;
+
+		}
+
+		GlyphAtlasEntry entry;
+		memset (&entry, 0, sizeof (entry));
+		entry.page = -1;
+
+		// empty glyphs (such as spaces) are kept without a page, so they are a single lookup as well
+
+		if (font->RenderGlyph (index, scratch, 0) > 0) {
+
+			GlyphImage* image = (GlyphImage*)scratch->b;
+			int width = image->width + padding;
+			int height = image->height + padding;
+
+			if (width > pageWidth || height > pageHeight) {
+
+				return 0;
+
+			}
+
+			int page = -1;
+			int x = 0;
+			int y = 0;
+
+			for (size_t i = 0; i < pages.size (); i++) {
+
+				if (Pack (pages[i], width, height, &x, &y)) {
+
+					page = i;
+					break;
+
+				}
+
+			}
+
+			if (page < 0 && (int)pages.size () < maxPages) {
+
+				pages.push_back (new GlyphAtlasPage (pageWidth, pageHeight, bitsPerPixel));
+				page = pages.size () - 1;
+				Pack (pages[page], width, height, &x, &y);
+
+			}
+
+			if (page < 0) {
+
+				// a skyline cannot reuse single holes, so the least recently used page is emptied,
+				// pages drawn from since the last flush are still on screen and are never chosen
+
+				for (size_t i = 0; i < pages.size (); i++) {
+
+					if (pages[i]->lastFrame < frame && (page < 0 || pages[i]->lastFrame < pages[page]->lastFrame)) {
+
+						page = i;
+
+					}
+
+				}
+
+				if (page < 0) {
+
+					return 0;
+
+				}
+
+				Reset (pages[page]);
+				evictions++;
+				Pack (pages[page], width, height, &x, &y);
+
+			}
+
+			GlyphAtlasPage* target = pages[page];
+			Blit (target, x, y, image, mode);
+
+			if (target->dirty.width == 0) {
+
+				target->dirty.x = x;
+				target->dirty.y = y;
+				target->dirty.width = image->width;
+				target->dirty.height = image->height;
+
+			} else {
+
+				int right = std::max (target->dirty.x + target->dirty.width, x + (int)image->width);
+				int bottom = std::max (target->dirty.y + target->dirty.height, y + (int)image->height);
+				target->dirty.x = std::min (target->dirty.x, x);
+				target->dirty.y = std::min (target->dirty.y, y);
+				target->dirty.width = right - target->dirty.x;
+				target->dirty.height = bottom - target->dirty.y;
+
+			}
+
+			target->keys.push_back (key);
+			target->lastFrame = frame;
+
+			entry.page = page;
+			entry.x = x;
+			entry.y = y;
+			entry.width = image->width;
+			entry.height = image->height;
+			entry.offsetX = (int)image->x;
+			entry.offsetY = (int)image->y;
+
+		}
+
+		return &(entries[key] = entry);
+		#else
+		return 0;
+		#endif
+
+	}
+
+
+	int GlyphAtlas::AddGlyphs (Font* font, ArrayBufferView* indices, ArrayBufferView* rects) {
+
+		// Int32 indices in, seven Int32 values out per glyph: page, x, y, width, height, offsetX, offsetY,
+		// page is -1 for empty glyphs and for glyphs that did not fit, the number that did not fit is returned
+
+		if (!indices || !rects || !indices->buffer || !rects->buffer) {
+
+			return 0;
+
+		}
+
+		const int* indicesData = (const int*)indices->buffer->b;
+		int* rectsData = (int*)rects->buffer->b;
+		int count = std::min (indices->byteLength / 4, rects->byteLength / 28);
+		int missing = 0;
+
+		for (int i = 0; i < count; i++) {
+
+			GlyphAtlasEntry* entry = AddGlyph (font, indicesData[i]);
+			int* rect = rectsData + i * 7;
+
+			if (entry) {
+
+				rect[0] = entry->page;
+				rect[1] = entry->x;
+				rect[2] = entry->y;
+				rect[3] = entry->width;
+				rect[4] = entry->height;
+				rect[5] = entry->offsetX;
+				rect[6] = entry->offsetY;
+
+			} else {
+
+				memset (rect, 0, 28);
+				rect[0] = -1;
+				missing++;
+
+			}
+
+		}
+
+		return missing;
+
+	}
+
+
+	void GlyphAtlas::Blit (GlyphAtlasPage* page, int x, int y, GlyphImage* image, GlyphRenderMode mode) {
+
+		// masks are stored as premultiplied white, LCD glyphs keep their subpixel colors on 32-bit pages
+
+		ImageBuffer* buffer = page->buffer;
+		int stride = buffer->Stride ();
+		int width = image->width;
+		int height = image->height;
+		const unsigned char* source = &image->data;
+
+		for (int row = 0; row < height; row++) {
+
+			unsigned char* dest = buffer->data->buffer->b + (y + row) * stride + x * (bitsPerPixel >> 3);
+
+			for (int column = 0; column < width; column++) {
+
+				unsigned char value;
+
+				if (mode == GLYPH_RENDER_LCD) {
+
+					const unsigned char* pixel = source + (row * width + column) * 4;
+
+					if (bitsPerPixel == 32) {
+
+						dest[0] = pixel[0];
+						dest[1] = pixel[1];
+						dest[2] = pixel[2];
+						dest[3] = pixel[3];
+						dest += 4;
+						continue;
+
+					}
+
+					value = pixel[3];
+
+				} else if (mode == GLYPH_RENDER_MONO) {
+
+					value = (source[row * ((width + 7) >> 3) + (column >> 3)] & (0x80 >> (column & 7))) ? 0xFF : 0;
+
+				} else {
+
+					value = source[row * width + column];
+
+				}
+
+				if (bitsPerPixel == 32) {
+
+					dest[0] = value;
+					dest[1] = value;
+					dest[2] = value;
+					dest[3] = value;
+					dest += 4;
+
+				} else {
+
+					*dest++ = value;
+
+				}
+
+			}
+
+		}
+
+	}
+
+
+	void GlyphAtlas::Clear () {
+
+		for (size_t i = 0; i < pages.size (); i++) {
+
+			Reset (pages[i]);
+
+		}
+
+		entries.clear ();
+
+	}
+
+
+	void GlyphAtlas::Flush (std::vector<GlyphAtlasRect>* dirty) {
+
+		// hands out the regions to upload, and starts a new frame for eviction
+
+		for (size_t i = 0; i < pages.size (); i++) {
+
+			GlyphAtlasPage* page = pages[i];
+
+			if (page->dirty.width > 0) {
+
+				page->dirty.page = i;
+
+				if (dirty) {
+
+					dirty->push_back (page->dirty);
+
+				}
+
+				page->dirty.width = 0;
+				page->dirty.height = 0;
+
+			}
+
+		}
+
+		frame++;
+
+	}
+
+
+	int GlyphAtlas::GetEvictions () {
+
+		return evictions;
+
+	}
+
+
+	ImageBuffer* GlyphAtlas::GetPage (int page) {
+
+		return (page >= 0 && page < (int)pages.size ()) ? pages[page]->buffer : 0;
+
+	}
+
+
+	int GlyphAtlas::GetPageCount () {
+
+		return pages.size ();
+
+	}
+
+
+	bool GlyphAtlas::Pack (GlyphAtlasPage* page, int width, int height, int* x, int* y) {
+
+		// skyline bottom-left: the lowest resting place wins, ties go to the narrowest node
+
+		std::vector<GlyphAtlasNode>& skyline = page->skyline;
+
+		int bestIndex = -1;
+		int bestTop = INT_MAX;
+		int bestWidth = INT_MAX;
+		int bestX = 0;
+		int bestY = 0;
+
+		for (size_t i = 0; i < skyline.size (); i++) {
+
+			if (skyline[i].x + width > pageWidth) {
+
+				break;
+
+			}
+
+			int top = 0;
+			int remaining = width;
+
+			for (size_t j = i; remaining > 0; j++) {
+
+				if (skyline[j].y > top) top = skyline[j].y;
+				remaining -= skyline[j].width;
+
+			}
+
+			if (top + height > pageHeight) {
+
+				continue;
+
+			}
+
+			if (top + height < bestTop || (top + height == bestTop && skyline[i].width < bestWidth)) {
+
+				bestIndex = i;
+				bestTop = top + height;
+				bestWidth = skyline[i].width;
+				bestX = skyline[i].x;
+				bestY = top;
+
+			}
+
+		}
+
+		if (bestIndex < 0) {
+
+			return false;
+
+		}
+
+		GlyphAtlasNode node = { width, bestX, bestY + height };
+		skyline.insert (skyline.begin () + bestIndex, node);
+
+		for (size_t i = bestIndex + 1; i < skyline.size ();) {
+
+			int end = skyline[i - 1].x + skyline[i - 1].width;
+
+			if (skyline[i].x >= end) {
+
+				break;
+
+			}
+
+			int shrink = end - skyline[i].x;
+			skyline[i].x += shrink;
+			skyline[i].width -= shrink;
+
+			if (skyline[i].width > 0) {
+
+				break;
+
+			}
+
+			skyline.erase (skyline.begin () + i);
+
+		}
+
+		for (size_t i = 0; i + 1 < skyline.size ();) {
+
+			if (skyline[i].y == skyline[i + 1].y) {
+
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase (skyline.begin () + i + 1);
+
+			} else {
+
+				i++;
+
+			}
+
+		}
+
+		*x = bestX;
+		*y = bestY;
+		return true;
+
+	}
+
+
+	void GlyphAtlas::RemoveFont (Font* font) {
+
+		// keys hold the font's id rather than its address, so this only frees the space its glyphs use
+
+		unsigned long long id = font->GetID ();
+
+		for (std::unordered_map<GlyphAtlasKey, GlyphAtlasEntry, GlyphAtlasKeyHash>::iterator it = entries.begin (); it != entries.end ();) {
+
+			if (it->first.font == id) {
+
+				it = entries.erase (it);
+
+			} else {
+
+				it++;
+
+			}
+
+		}
+
+		for (size_t i = 0; i < pages.size (); i++) {
+
+			std::vector<GlyphAtlasKey>& keys = pages[i]->keys;
+
+			for (size_t j = 0; j < keys.size ();) {
+
+				if (keys[j].font == id) {
+
+					keys[j] = keys.back ();
+					keys.pop_back ();
+
+				} else {
+
+					j++;
+
+				}
+
+			}
+
+		}
+
+	}
+
+
+	void GlyphAtlas::Reset (GlyphAtlasPage* page) {
+
+		for (size_t i = 0; i < page->keys.size (); i++) {
+
+			entries.erase (page->keys[i]);
+
+		}
+
+		page->keys.clear ();
+		page->skyline.clear ();
+
+		GlyphAtlasNode node = { pageWidth, 0, 0 };
+		page->skyline.push_back (node);
+
+		memset (page->buffer->data->buffer->b, 0, page->buffer->data->byteLength);
+
+		page->dirty.x = 0;
+		page->dirty.y = 0;
+		page->dirty.width = pageWidth;
+		page->dirty.height = pageHeight;
+
+	}
+
+
+}
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <system/CFFIPointer.h>
 #include <system/Mutex.h>
 #include <text/Font.h>
+#include <text/FontMemory.h>
+#include <text/ShapeCache.h>
+#include <text/TextLayout.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <hb.h>
@@ -106,6 +109,40 @@ namespace lime {
 	}
 
 
+	void gc_shape_cache (value handle) {
+
+		ShapeCache* cache = (ShapeCache*)val_data (handle);
+		delete cache;
+		val_gc (handle, 0);
+
+	}
+
+
+	void hl_gc_shape_cache (HL_CFFIPointer* handle) {
+
+		ShapeCache* cache = (ShapeCache*)handle->ptr;
+		delete cache;
+
+	}
+
+
+	void gc_text_layout (value handle) {
+
+		TextLayout* layout = (TextLayout*)val_data (handle);
+		delete layout;
+		val_gc (handle, 0);
+
+	}
+
+
+	void hl_gc_text_layout (HL_CFFIPointer* handle) {
+
+		TextLayout* layout = (TextLayout*)handle->ptr;
+		delete layout;
+
+	}
+
+
 	value lime_hb_blob_create (double data, int length, int memoryMode) {
 
 		hb_blob_t* blob = hb_blob_create ((const char*)(uintptr_t)data, length, (hb_memory_mode_t)memoryMode, 0, 0);
@@ -122,6 +159,62 @@ namespace lime {
 	}
 
 
+	static void font_memory_release (void* userData) {
+
+		((FontMemory*)userData)->Release ();
+
+	}
+
+
+	static hb_blob_t* blob_create_from_font_memory (FontMemory* memory) {
+
+		// the blob holds a reference, so the mapping outlives whichever of the Font or the blob is released first
+
+		if (!memory) {
+
+			return hb_blob_get_empty ();
+
+		}
+
+		return hb_blob_create ((const char*)memory->data, memory->size, HB_MEMORY_MODE_READONLY, memory, font_memory_release);
+
+	}
+
+
+	value lime_hb_blob_create_from_file (HxString path) {
+
+		hb_blob_t* blob = blob_create_from_font_memory (FontMemory::Open (hxs_utf8 (path, nullptr)));
+		return CFFIPointer (blob, gc_hb_blob);
+
+	}
+
+
+	HL_PRIM HL_CFFIPointer* HL_NAME(hl_hb_blob_create_from_file) (hl_vstring* path) {
+
+		hb_blob_t* blob = blob_create_from_font_memory (path ? FontMemory::Open (hl_to_utf8 ((const uchar*)path->bytes)) : 0);
+		return HLCFFIPointer (blob, (hl_finalizer)hl_gc_hb_blob);
+
+	}
+
+
+	value lime_hb_blob_create_from_font (value font) {
+
+		Font* _font = (Font*)val_data (font);
+		hb_blob_t* blob = blob_create_from_font_memory (_font->faceMemory ? _font->faceMemory->Retain () : 0);
+		return CFFIPointer (blob, gc_hb_blob);
+
+	}
+
+
+	HL_PRIM HL_CFFIPointer* HL_NAME(hl_hb_blob_create_from_font) (HL_CFFIPointer* font) {
+
+		Font* _font = (Font*)font->ptr;
+		hb_blob_t* blob = blob_create_from_font_memory (_font->faceMemory ? _font->faceMemory->Retain () : 0);
+		return HLCFFIPointer (blob, (hl_finalizer)hl_gc_hb_blob);
+
+	}
+
+
 	value lime_hb_blob_create_sub_blob (value parent, int offset, int length) {
 
 		hb_blob_t* blob = hb_blob_create_sub_blob ((hb_blob_t*)val_data (parent), offset, length);
@@ -475,6 +568,22 @@ namespace lime {
 	}
 
 
+	double lime_hb_buffer_get_glyph_infos_data (value buffer) {
+
+		// HarfBuzz's own array, 20 bytes per glyph starting with the HBGlyphInfo fields, valid until the buffer changes
+
+		return (uintptr_t)hb_buffer_get_glyph_infos ((hb_buffer_t*)val_data (buffer), NULL);
+
+	}
+
+
+	HL_PRIM double HL_NAME(hl_hb_buffer_get_glyph_infos_data) (HL_CFFIPointer* buffer) {
+
+		return (uintptr_t)hb_buffer_get_glyph_infos ((hb_buffer_t*)buffer->ptr, NULL);
+
+	}
+
+
 	value lime_hb_buffer_get_glyph_positions (value buffer, value bytes) {
 
 		unsigned int length = 0;
@@ -538,6 +647,22 @@ namespace lime {
 	}
 
 
+	double lime_hb_buffer_get_glyph_positions_data (value buffer) {
+
+		// HarfBuzz's own array, 20 bytes per glyph starting with the HBGlyphPosition fields, valid until the buffer changes
+
+		return (uintptr_t)hb_buffer_get_glyph_positions ((hb_buffer_t*)val_data (buffer), NULL);
+
+	}
+
+
+	HL_PRIM double HL_NAME(hl_hb_buffer_get_glyph_positions_data) (HL_CFFIPointer* buffer) {
+
+		return (uintptr_t)hb_buffer_get_glyph_positions ((hb_buffer_t*)buffer->ptr, NULL);
+
+	}
+
+
 	value lime_hb_buffer_get_language (value buffer) {
 
 		hb_language_t language = hb_buffer_get_language ((hb_buffer_t*)val_data (buffer));
@@ -2013,6 +2138,205 @@ namespace lime {
 	}
 
 
+	void lime_hb_shape_cache_clear (value cache) {
+
+		((ShapeCache*)val_data (cache))->Clear ();
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_hb_shape_cache_clear) (HL_CFFIPointer* cache) {
+
+		((ShapeCache*)cache->ptr)->Clear ();
+
+	}
+
+
+	value lime_hb_shape_cache_create (int memoryBudget) {
+
+		ShapeCache* cache = new ShapeCache (memoryBudget);
+		return CFFIPointer (cache, gc_shape_cache);
+
+	}
+
+
+	HL_PRIM HL_CFFIPointer* HL_NAME(hl_hb_shape_cache_create) (int memoryBudget) {
+
+		ShapeCache* cache = new ShapeCache (memoryBudget);
+		return HLCFFIPointer (cache, (hl_finalizer)hl_gc_shape_cache);
+
+	}
+
+
+	int lime_hb_shape_cache_get_entries (value cache) {
+
+		return ((ShapeCache*)val_data (cache))->GetEntries ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_hb_shape_cache_get_entries) (HL_CFFIPointer* cache) {
+
+		return ((ShapeCache*)cache->ptr)->GetEntries ();
+
+	}
+
+
+	int lime_hb_shape_cache_get_evictions (value cache) {
+
+		return ((ShapeCache*)val_data (cache))->GetEvictions ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_hb_shape_cache_get_evictions) (HL_CFFIPointer* cache) {
+
+		return ((ShapeCache*)cache->ptr)->GetEvictions ();
+
+	}
+
+
+	int lime_hb_shape_cache_get_hits (value cache) {
+
+		return ((ShapeCache*)val_data (cache))->GetHits ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_hb_shape_cache_get_hits) (HL_CFFIPointer* cache) {
+
+		return ((ShapeCache*)cache->ptr)->GetHits ();
+
+	}
+
+
+	int lime_hb_shape_cache_get_memory_usage (value cache) {
+
+		return ((ShapeCache*)val_data (cache))->GetMemoryUsage ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_hb_shape_cache_get_memory_usage) (HL_CFFIPointer* cache) {
+
+		return ((ShapeCache*)cache->ptr)->GetMemoryUsage ();
+
+	}
+
+
+	int lime_hb_shape_cache_get_misses (value cache) {
+
+		return ((ShapeCache*)val_data (cache))->GetMisses ();
+
+	}
+
+
+	HL_PRIM int HL_NAME(hl_hb_shape_cache_get_misses) (HL_CFFIPointer* cache) {
+
+		return ((ShapeCache*)cache->ptr)->GetMisses ();
+
+	}
+
+
+	void lime_hb_shape_cache_set_memory_budget (value cache, int memoryBudget) {
+
+		((ShapeCache*)val_data (cache))->SetMemoryBudget (memoryBudget);
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_hb_shape_cache_set_memory_budget) (HL_CFFIPointer* cache, int memoryBudget) {
+
+		((ShapeCache*)cache->ptr)->SetMemoryBudget (memoryBudget);
+
+	}
+
+
+	bool lime_hb_shape_cache_shape (value cache, value font, value buffer, value features) {
+
+		int length = !val_is_null (features) ? val_array_size (features) : 0;
+		double* _features = !val_is_null (features) ? val_array_double (features) : NULL;
+		return ((ShapeCache*)val_data (cache))->Shape (val_data (font), val_data (buffer), (const hb_feature_t*)(uintptr_t*)_features, length);
+
+	}
+
+
+	HL_PRIM bool HL_NAME(hl_hb_shape_cache_shape) (HL_CFFIPointer* cache, HL_CFFIPointer* font, HL_CFFIPointer* buffer, hl_varray* features) {
+
+		int length = features ? features->size : 0;
+		double* _features = features ? hl_aptr (features, double) : NULL;
+		return ((ShapeCache*)cache->ptr)->Shape (font->ptr, buffer->ptr, (const hb_feature_t*)(uintptr_t*)_features, length);
+
+	}
+
+
+	void lime_text_layout_add_font (value handle, value font) {
+
+		TextLayout* layout = (TextLayout*)val_data (handle);
+		layout->AddFont ((Font*)val_data (font));
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_text_layout_add_font) (HL_CFFIPointer* handle, HL_CFFIPointer* font) {
+
+		TextLayout* layout = (TextLayout*)handle->ptr;
+		layout->AddFont ((Font*)font->ptr);
+
+	}
+
+
+	void lime_text_layout_clear_fonts (value handle) {
+
+		TextLayout* layout = (TextLayout*)val_data (handle);
+		layout->ClearFonts ();
+
+	}
+
+
+	HL_PRIM void HL_NAME(hl_text_layout_clear_fonts) (HL_CFFIPointer* handle) {
+
+		TextLayout* layout = (TextLayout*)handle->ptr;
+		layout->ClearFonts ();
+
+	}
+
+
+	value lime_text_layout_create () {
+
+		TextLayout* layout = new TextLayout ();
+		return CFFIPointer (layout, gc_text_layout);
+
+	}
+
+
+	HL_PRIM HL_CFFIPointer* HL_NAME(hl_text_layout_create) () {
+
+		TextLayout* layout = new TextLayout ();
+		return HLCFFIPointer (layout, (hl_finalizer)hl_gc_text_layout);
+
+	}
+
+
+	value lime_text_layout_layout (value handle, HxString text, int size, int width, int align, value data) {
+
+		TextLayout* layout = (TextLayout*)val_data (handle);
+		Bytes bytes (data);
+		layout->Layout (hxs_utf8 (text, nullptr), size, width, (TextLayoutAlign)align, &bytes);
+		return bytes.Value (data);
+
+	}
+
+
+	HL_PRIM Bytes* HL_NAME(hl_text_layout_layout) (HL_CFFIPointer* handle, hl_vstring* text, int size, int width, int align, Bytes* data) {
+
+		TextLayout* layout = (TextLayout*)handle->ptr;
+		layout->Layout (text ? (char*)hl_to_utf8 ((const uchar*)text->bytes) : NULL, size, width, (TextLayoutAlign)align, data);
+		return data;
+
+	}
+
+
 	//hb_blob_destroy
 	//hb_blob_get_user_data
 	//hb_blob_reference
@@ -2050,6 +2374,8 @@ namespace lime {
 
 
 	DEFINE_PRIME3 (lime_hb_blob_create);
+	DEFINE_PRIME1 (lime_hb_blob_create_from_file);
+	DEFINE_PRIME1 (lime_hb_blob_create_from_font);
 	DEFINE_PRIME3 (lime_hb_blob_create_sub_blob);
 	DEFINE_PRIME1 (lime_hb_blob_get_data);
 	DEFINE_PRIME1 (lime_hb_blob_get_data_writable);
@@ -2071,7 +2397,9 @@ namespace lime {
 	DEFINE_PRIME0 (lime_hb_buffer_get_empty);
 	DEFINE_PRIME1 (lime_hb_buffer_get_flags);
 	DEFINE_PRIME2 (lime_hb_buffer_get_glyph_infos);
+	DEFINE_PRIME1 (lime_hb_buffer_get_glyph_infos_data);
 	DEFINE_PRIME2 (lime_hb_buffer_get_glyph_positions);
+	DEFINE_PRIME1 (lime_hb_buffer_get_glyph_positions_data);
 	DEFINE_PRIME1 (lime_hb_buffer_get_language);
 	DEFINE_PRIME1 (lime_hb_buffer_get_length);
 	DEFINE_PRIME1 (lime_hb_buffer_get_replacement_codepoint);
@@ -2159,6 +2487,19 @@ namespace lime {
 	DEFINE_PRIME2v (lime_hb_set_symmetric_difference);
 	DEFINE_PRIME2v (lime_hb_set_union);
 	DEFINE_PRIME3v (lime_hb_shape);
+	DEFINE_PRIME1v (lime_hb_shape_cache_clear);
+	DEFINE_PRIME1 (lime_hb_shape_cache_create);
+	DEFINE_PRIME1 (lime_hb_shape_cache_get_entries);
+	DEFINE_PRIME1 (lime_hb_shape_cache_get_evictions);
+	DEFINE_PRIME1 (lime_hb_shape_cache_get_hits);
+	DEFINE_PRIME1 (lime_hb_shape_cache_get_memory_usage);
+	DEFINE_PRIME1 (lime_hb_shape_cache_get_misses);
+	DEFINE_PRIME2v (lime_hb_shape_cache_set_memory_budget);
+	DEFINE_PRIME4 (lime_hb_shape_cache_shape);
+	DEFINE_PRIME2v (lime_text_layout_add_font);
+	DEFINE_PRIME1v (lime_text_layout_clear_fonts);
+	DEFINE_PRIME0 (lime_text_layout_create);
+	DEFINE_PRIME6 (lime_text_layout_layout);
 
 
 	#define _TBYTES _OBJ (_I32 _BYTES)
@@ -2167,6 +2508,8 @@ namespace lime {
 
 
 	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_hb_blob_create, _F64 _I32 _I32);
+	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_hb_blob_create_from_file, _STRING);
+	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_hb_blob_create_from_font, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_hb_blob_create_sub_blob, _TCFFIPOINTER _I32 _I32);
 	DEFINE_HL_PRIM (_F64, hl_hb_blob_get_data, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_F64, hl_hb_blob_get_data_writable, _TCFFIPOINTER);
@@ -2188,7 +2531,9 @@ namespace lime {
 	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_hb_buffer_get_empty, _NO_ARG);
 	DEFINE_HL_PRIM (_I32, hl_hb_buffer_get_flags, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_TBYTES, hl_hb_buffer_get_glyph_infos, _TCFFIPOINTER _TBYTES);
+	DEFINE_HL_PRIM (_F64, hl_hb_buffer_get_glyph_infos_data, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_TBYTES, hl_hb_buffer_get_glyph_positions, _TCFFIPOINTER _TBYTES);
+	DEFINE_HL_PRIM (_F64, hl_hb_buffer_get_glyph_positions_data, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_hb_buffer_get_language, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_I32, hl_hb_buffer_get_length, _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_I32, hl_hb_buffer_get_replacement_codepoint, _TCFFIPOINTER);
@@ -2276,6 +2621,19 @@ namespace lime {
 	DEFINE_HL_PRIM (_VOID, hl_hb_set_symmetric_difference, _TCFFIPOINTER _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_VOID, hl_hb_set_union, _TCFFIPOINTER _TCFFIPOINTER);
 	DEFINE_HL_PRIM (_VOID, hl_hb_shape, _TCFFIPOINTER _TCFFIPOINTER _ARR);
+	DEFINE_HL_PRIM (_VOID, hl_hb_shape_cache_clear, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_hb_shape_cache_create, _I32);
+	DEFINE_HL_PRIM (_I32, hl_hb_shape_cache_get_entries, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_hb_shape_cache_get_evictions, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_hb_shape_cache_get_hits, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_hb_shape_cache_get_memory_usage, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_I32, hl_hb_shape_cache_get_misses, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_VOID, hl_hb_shape_cache_set_memory_budget, _TCFFIPOINTER _I32);
+	DEFINE_HL_PRIM (_BOOL, hl_hb_shape_cache_shape, _TCFFIPOINTER _TCFFIPOINTER _TCFFIPOINTER _ARR);
+	DEFINE_HL_PRIM (_VOID, hl_text_layout_add_font, _TCFFIPOINTER _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_VOID, hl_text_layout_clear_fonts, _TCFFIPOINTER);
+	DEFINE_HL_PRIM (_TCFFIPOINTER, hl_text_layout_create, _NO_ARG);
+	DEFINE_HL_PRIM (_TBYTES, hl_text_layout_layout, _TCFFIPOINTER _STRING _I32 _I32 _I32 _TBYTES);
 
 
 }
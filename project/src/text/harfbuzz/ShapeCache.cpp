@@ -0,0 +1,319 @@
+#include <text/ShapeCache.h>
+#include <hb.h>
+#include <atomic>
+#include <string.h>
+
+
+namespace lime {
+
+
+	static hb_user_data_key_t fontIDKey;
+	static std::atomic<unsigned long long> nextFontID (1);
+
+
+	static void AppendKey (std::string* key, const void* data, int length) {
+
+		key->append ((const char*)data, length);
+
+	}
+
+
+	static void DestroyFontID (void* data) {
+
+		delete (unsigned long long*)data;
+
+	}
+
+
+	static unsigned long long GetFontID (hb_font_t* font) {
+
+		// fonts are told apart by an id stored on the font itself, so a new font
+		// that reuses the address of a destroyed one never hits its old entries
+
+		unsigned long long* id = (unsigned long long*)hb_font_get_user_data (font, &fontIDKey);
+
+		if (!id) {
+
+			id = new unsigned long long (nextFontID++);
+
+			if (!hb_font_set_user_data (font, &fontIDKey, id, DestroyFontID, false)) {
+
+				delete id;
+				id = (unsigned long long*)hb_font_get_user_data (font, &fontIDKey);
+
+			}
+
+		}
+
+		return id ? *id : 0;
+
+	}
+
+
+	static bool BuildKey (hb_font_t* font, hb_buffer_t* buffer, const hb_feature_t* features, int numFeatures, std::string* key) {
+
+		if (hb_buffer_get_content_type (buffer) != HB_BUFFER_CONTENT_TYPE_UNICODE || hb_buffer_get_length (buffer) == 0) {
+
+			return false;
+
+		}
+
+		unsigned long long fontID = GetFontID (font);
+
+		if (!fontID) {
+
+			return false;
+
+		}
+
+		unsigned int length = 0;
+		hb_glyph_info_t* infos = hb_buffer_get_glyph_infos (buffer, &length);
+
+		int fontData[7];
+		hb_font_get_scale (font, &fontData[0], &fontData[1]);
+		hb_font_get_ppem (font, (unsigned int*)&fontData[2], (unsigned int*)&fontData[3]);
+		fontData[4] = (int)hb_font_get_serial (font);
+		fontData[5] = numFeatures;
+		fontData[6] = (int)length;
+
+		hb_segment_properties_t props;
+		hb_buffer_get_segment_properties (buffer, &props);
+
+		unsigned int bufferData[7];
+		bufferData[0] = props.direction;
+		bufferData[1] = props.script;
+		bufferData[2] = hb_buffer_get_flags (buffer);
+		bufferData[3] = hb_buffer_get_cluster_level (buffer);
+		bufferData[4] = hb_buffer_get_invisible_glyph (buffer);
+		bufferData[5] = hb_buffer_get_replacement_codepoint (buffer);
+		bufferData[6] = hb_buffer_get_not_found_glyph (buffer);
+
+		// languages are interned by HarfBuzz, so the pointer identifies one
+
+		key->reserve (sizeof (fontID) + sizeof (fontData) + sizeof (bufferData) + sizeof (hb_language_t) + numFeatures * sizeof (hb_feature_t) + length * 8);
+		AppendKey (key, &fontID, sizeof (fontID));
+		AppendKey (key, fontData, sizeof (fontData));
+		AppendKey (key, bufferData, sizeof (bufferData));
+		AppendKey (key, &props.language, sizeof (hb_language_t));
+
+		if (numFeatures > 0) {
+
+			AppendKey (key, features, numFeatures * sizeof (hb_feature_t));
+
+		}
+
+		for (unsigned int i = 0; i < length; i++) {
+
+			AppendKey (key, &infos[i].codepoint, 4);
+			AppendKey (key, &infos[i].cluster, 4);
+
+		}
+
+		return true;
+
+	}
+
+
+	ShapeCache::ShapeCache (int memoryBudget) {
+
+		this->memoryBudget = memoryBudget;
+		evictions = 0;
+		hits = 0;
+		memoryUsage = 0;
+		misses = 0;
+
+	}
+
+
+	ShapeCache::~ShapeCache () {
+
+		Clear ();
+
+	}
+
+
+	void ShapeCache::Clear () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		for (std::list<ShapeCacheEntry*>::iterator it = lru.begin (); it != lru.end (); it++) {
+
+			delete *it;
+
+		}
+
+		entries.clear ();
+		lru.clear ();
+		memoryUsage = 0;
+
+	}
+
+
+	int ShapeCache::GetEntries () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return (int)entries.size ();
+
+	}
+
+
+	int ShapeCache::GetEvictions () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return evictions;
+
+	}
+
+
+	int ShapeCache::GetHits () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return hits;
+
+	}
+
+
+	int ShapeCache::GetMemoryBudget () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return memoryBudget;
+
+	}
+
+
+	int ShapeCache::GetMemoryUsage () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return memoryUsage;
+
+	}
+
+
+	int ShapeCache::GetMisses () {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		return misses;
+
+	}
+
+
+	void ShapeCache::SetMemoryBudget (int memoryBudget) {
+
+		std::unique_lock<std::mutex> lock (mutex);
+		this->memoryBudget = memoryBudget;
+		Trim ();
+
+	}
+
+
+	bool ShapeCache::Shape (void* _font, void* _buffer, const void* _features, int numFeatures) {
+
+		hb_font_t* font = (hb_font_t*)_font;
+		hb_buffer_t* buffer = (hb_buffer_t*)_buffer;
+		const hb_feature_t* features = (const hb_feature_t*)_features;
+
+		std::string key;
+
+		if (!BuildKey (font, buffer, features, numFeatures, &key)) {
+
+			hb_shape (font, buffer, features, numFeatures);
+			return false;
+
+		}
+
+		{
+
+			std::unique_lock<std::mutex> lock (mutex);
+			std::unordered_map<std::string, ShapeCacheEntry*>::iterator it = entries.find (key);
+
+			if (it != entries.end ()) {
+
+				ShapeCacheEntry* entry = it->second;
+				lru.splice (lru.begin (), lru, entry->lru);
+				hits++;
+
+				// leave the buffer exactly as hb_shape would, so glyph infos and positions read back the same
+
+				if (hb_buffer_set_length (buffer, entry->length)) {
+
+					hb_buffer_set_content_type (buffer, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+					hb_glyph_info_t* infos = hb_buffer_get_glyph_infos (buffer, NULL);
+					hb_glyph_position_t* positions = hb_buffer_get_glyph_positions (buffer, NULL);
+
+					if (entry->length > 0) {
+
+						const char* glyphs = entry->glyphs.data ();
+						memcpy (infos, glyphs, entry->length * sizeof (hb_glyph_info_t));
+						memcpy (positions, glyphs + entry->length * sizeof (hb_glyph_info_t), entry->length * sizeof (hb_glyph_position_t));
+
+					}
+
+				}
+
+				return true;
+
+			}
+
+			misses++;
+
+		}
+
+		// shape outside the lock, only the insert needs it
+
+		hb_shape (font, buffer, features, numFeatures);
+
+		unsigned int length = 0;
+		hb_glyph_info_t* infos = hb_buffer_get_glyph_infos (buffer, &length);
+		hb_glyph_position_t* positions = hb_buffer_get_glyph_positions (buffer, NULL);
+
+		ShapeCacheEntry* entry = new ShapeCacheEntry ();
+		entry->length = (int)length;
+		entry->glyphs.reserve (length * (sizeof (hb_glyph_info_t) + sizeof (hb_glyph_position_t)));
+		entry->glyphs.append ((const char*)infos, length * sizeof (hb_glyph_info_t));
+		entry->glyphs.append ((const char*)positions, length * sizeof (hb_glyph_position_t));
+		entry->size = (int)(sizeof (ShapeCacheEntry) + key.size () * 2 + entry->glyphs.size ());
+		entry->key.swap (key);
+
+		std::unique_lock<std::mutex> lock (mutex);
+
+		if ((memoryBudget > 0 && entry->size > memoryBudget) || entries.count (entry->key)) {
+
+			delete entry;
+			return false;
+
+		}
+
+		entries[entry->key] = entry;
+		lru.push_front (entry);
+		entry->lru = lru.begin ();
+		memoryUsage += entry->size;
+		Trim ();
+
+		return false;
+
+	}
+
+
+	void ShapeCache::Trim () {
+
+		if (memoryBudget <= 0) {
+
+			return;
+
+		}
+
+		while (memoryUsage > memoryBudget && !lru.empty ()) {
+
+			ShapeCacheEntry* entry = lru.back ();
+			lru.pop_back ();
+			entries.erase (entry->key);
+			memoryUsage -= entry->size;
+			evictions++;
+			delete entry;
+
+		}
+
+	}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,980 @@
+#include <text/TextLayout.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <hb.h>
+#include <hb-ft.h>
+#include <algorithm>
+#include <string.h>
+
+
+namespace lime {
+
+
+	// line break classes from UAX #14, only those the pair rules below tell apart
+
+	enum {
+
+		LB_AL,
+		LB_BA,
+		LB_BB,
+		LB_CL,
+		LB_CM,
+		LB_CP,
+		LB_EX,
+		LB_GL,
+		LB_HY,
+		LB_ID,
+		LB_IN,
+		LB_IS,
+		LB_NS,
+		LB_NU,
+		LB_OP,
+		LB_PO,
+		LB_PR,
+		LB_QU,
+		LB_SP,
+		LB_WJ,
+		LB_ZW
+
+	};
+
+
+	enum {
+
+		BIDI_L,
+		BIDI_R,
+		BIDI_EN,
+		BIDI_N,
+		BIDI_NSM
+
+	};
+
+
+	static int bidi_type (hb_script_t script, hb_unicode_general_category_t category) {
+
+		if (category == HB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK || category == HB_UNICODE_GENERAL_CATEGORY_ENCLOSING_MARK) {
+
+			return BIDI_NSM;
+
+		}
+
+		if (category == HB_UNICODE_GENERAL_CATEGORY_DECIMAL_NUMBER) {
+
+			return BIDI_EN;
+
+		}
+
+		if (script == HB_SCRIPT_COMMON || script == HB_SCRIPT_INHERITED || script == HB_SCRIPT_UNKNOWN) {
+
+			return BIDI_N;
+
+		}
+
+		return hb_script_get_horizontal_direction (script) == HB_DIRECTION_RTL ? BIDI_R : BIDI_L;
+
+	}
+
+
+	static int break_class (unsigned int c, hb_unicode_general_category_t category) {
+
+		switch (c) {
+
+			case 0x0009: case 0x00AD: case 0x058A: case 0x1680: case 0x2010: case 0x2012: case 0x2013: case 0x205F: case 0x3000:
+				return LB_BA;
+
+			case 0x0020:
+				return LB_SP;
+
+			case 0x0021: case 0x003F: case 0xFF01: case 0xFF1F:
+				return LB_EX;
+
+			case 0x0022: case 0x0027: case 0x00AB: case 0x00BB: case 0x2018: case 0x2019: case 0x201C: case 0x201D: case 0x2039: case 0x203A:
+				return LB_QU;
+
+			case 0x0024: case 0x002B: case 0x005C: case 0x00A3: case 0x00A5: case 0x00B1: case 0x20AC:
+				return LB_PR;
+
+			case 0x0025: case 0x00A2: case 0x00B0: case 0x2030: case 0x2031: case 0x2032: case 0x2033:
+				return LB_PO;
+
+			case 0x0028: case 0x005B: case 0x007B: case 0x00A1: case 0x00BF: case 0x3008: case 0x300A: case 0x300C: case 0x300E: case 0x3010: case 0x3014: case 0xFF08: case 0xFF3B: case 0xFF5B:
+				return LB_OP;
+
+			case 0x0029: case 0x005D:
+				return LB_CP;
+
+			case 0x007D: case 0x3001: case 0x3002: case 0x3009: case 0x300B: case 0x300D: case 0x300F: case 0x3011: case 0x3015: case 0xFF09: case 0xFF0C: case 0xFF0E: case 0xFF3D: case 0xFF5D:
+				return LB_CL;
+
+			case 0x002C: case 0x002E: case 0x003A: case 0x003B: case 0x037E: case 0x0589: case 0x060C: case 0x060D: case 0x2044:
+				return LB_IS;
+
+			case 0x002D:
+				return LB_HY;
+
+			case 0x00A0: case 0x0F0C: case 0x2007: case 0x2011: case 0x202F:
+				return LB_GL;
+
+			case 0x00B4: case 0x02C8: case 0x02CC:
+				return LB_BB;
+
+			case 0x200B:
+				return LB_ZW;
+
+			case 0x200D:
+				return LB_CM;
+
+			case 0x2060: case 0xFEFF:
+				return LB_WJ;
+
+			case 0x2024: case 0x2025: case 0x2026:
+				return LB_IN;
+
+			// small kana and iteration marks, which stay with the character before them
+
+			case 0x3005: case 0x303B: case 0x3041: case 0x3043: case 0x3045: case 0x3047: case 0x3049: case 0x3063: case 0x3083: case 0x3085: case 0x3087: case 0x308E: case 0x3095: case 0x3096: case 0x309D: case 0x309E:
+			case 0x30A1: case 0x30A3: case 0x30A5: case 0x30A7: case 0x30A9: case 0x30C3: case 0x30E3: case 0x30E5: case 0x30E7: case 0x30EE: case 0x30F5: case 0x30F6: case 0x30FB: case 0x30FC: case 0x30FD: case 0x30FE:
+			case 0xFF1A: case 0xFF1B:
+				return LB_NS;
+
+		}
+
+		if ((c >= 0x2000 && c <= 0x2006) || (c >= 0x2008 && c <= 0x200A)) return LB_BA;
+		if (c >= 0x31F0 && c <= 0x31FF) return LB_NS;
+
+		switch (category) {
+
+			case HB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK:
+			case HB_UNICODE_GENERAL_CATEGORY_SPACING_MARK:
+			case HB_UNICODE_GENERAL_CATEGORY_ENCLOSING_MARK:
+			case HB_UNICODE_GENERAL_CATEGORY_CONTROL:
+				return LB_CM;
+
+			case HB_UNICODE_GENERAL_CATEGORY_DECIMAL_NUMBER:
+				return LB_NU;
+
+			default:
+				break;
+
+		}
+
+		// ideographs, kana, hangul, fullwidth forms and pictographs can be broken around on either side
+
+		if ((c >= 0x2E80 && c <= 0x30FF) || (c >= 0x3400 && c <= 0x4DBF) || (c >= 0x4E00 && c <= 0x9FFF) || (c >= 0xA000 && c <= 0xA4CF) || (c >= 0xAC00 && c <= 0xD7A3) || (c >= 0xF900 && c <= 0xFAFF) || (c >= 0xFE30 && c <= 0xFE4F) || (c >= 0xFF00 && c <= 0xFF60) || (c >= 0xFFE0 && c <= 0xFFE6) || (c >= 0x1F000 && c <= 0x1FAFF) || (c >= 0x20000 && c <= 0x3FFFD)) {
+
+			return LB_ID;
+
+		}
+
+		return LB_AL;
+
+	}
+
+
+	static bool can_break (int before, int after, int beforeSpaces) {
+
+		// the pair rules of UAX #14 in priority order, beforeSpaces is the class before any run of spaces
+
+		if (beforeSpaces == LB_ZW) return after != LB_SP && after != LB_ZW;
+		if (after == LB_SP || after == LB_ZW) return false;
+		if (before == LB_WJ || after == LB_WJ) return false;
+		if (before == LB_GL) return false;
+		if (after == LB_GL && before != LB_SP && before != LB_BA && before != LB_HY) return false;
+		if (after == LB_CL || after == LB_CP || after == LB_EX || after == LB_IS) return false;
+		if (beforeSpaces == LB_OP) return false;
+		if (beforeSpaces == LB_QU && after == LB_OP) return false;
+		if ((beforeSpaces == LB_CL || beforeSpaces == LB_CP) && after == LB_NS) return false;
+		if (before == LB_SP) return true;
+		if (before == LB_QU || after == LB_QU) return false;
+		if (after == LB_BA || after == LB_HY || after == LB_NS || after == LB_IN) return false;
+		if (before == LB_BB) return false;
+
+		switch (before) {
+
+			case LB_AL: return after != LB_AL && after != LB_NU && after != LB_PR && after != LB_PO && after != LB_OP;
+			case LB_CP: return after != LB_AL && after != LB_NU;
+			case LB_HY: return after != LB_NU;
+			case LB_IS: return after != LB_AL && after != LB_NU;
+			case LB_NU: return after != LB_AL && after != LB_NU && after != LB_PR && after != LB_PO && after != LB_OP;
+			case LB_PO: return after != LB_AL && after != LB_NU;
+			case LB_PR: return after != LB_AL && after != LB_NU && after != LB_ID && after != LB_OP;
+			default: return true;
+
+		}
+
+	}
+
+
+	static unsigned int decode_utf8 (const unsigned char* text, int length, int* position) {
+
+		// malformed bytes are read one at a time as U+FFFD
+
+		int i = *position;
+		unsigned int c = text[i];
+		int size = (c >= 0xC2 && c <= 0xDF) ? 2 : (c >= 0xE0 && c <= 0xEF) ? 3 : (c >= 0xF0 && c <= 0xF4) ? 4 : 1;
+
+		if (c < 0x80 || size == 1 || i + size > length) {
+
+			*position = i + 1;
+			return c < 0x80 ? c : 0xFFFD;
+
+		}
+
+		unsigned int codepoint = c & (0x7F >> size);
+
+		for (int j = 1; j < size; j++) {
+
+			if ((text[i + j] & 0xC0) != 0x80) {
+
+				*position = i + 1;
+				return 0xFFFD;
+
+			}
+
+			codepoint = (codepoint << 6) | (text[i + j] & 0x3F);
+
+		}
+
+		if ((size == 3 && (codepoint < 0x800 || (codepoint >= 0xD800 && codepoint <= 0xDFFF))) || (size == 4 && (codepoint < 0x10000 || codepoint > 0x10FFFF))) {
+
+			*position = i + 1;
+			return 0xFFFD;
+
+		}
+
+		*position = i + size;
+		return codepoint;
+
+	}
+
+
+	static bool is_paragraph_separator (unsigned int codepoint) {
+
+		return codepoint == 0x0A || codepoint == 0x0B || codepoint == 0x0C || codepoint == 0x0D || codepoint == 0x85 || codepoint == 0x2028 || codepoint == 0x2029;
+
+	}
+
+
+	TextLayout::TextLayout () {
+
+		buffer = hb_buffer_create ();
+
+	}
+
+
+	TextLayout::~TextLayout () {
+
+		ClearFonts ();
+		hb_buffer_destroy ((hb_buffer_t*)buffer);
+
+	}
+
+
+	void TextLayout::AddFont (Font* font) {
+
+		// fonts are tried in the order they were added. Layout sizes a face of its own, which keeps
+		// the library and font memory alive, so the Font keeps its size and may be destroyed first
+
+		if (!font || !font->face) {
+
+			return;
+
+		}
+
+		FT_Face face = (FT_Face)font->RetainFace ();
+
+		if (!face) {
+
+			return;
+
+		}
+
+		faces.push_back (face);
+		hbFonts.push_back (hb_ft_font_create (face, NULL));
+
+	}
+
+
+	void TextLayout::BreakLines (int glyphStart, int width, bool rtl, int textStart, int textEnd) {
+
+		int glyphEnd = glyphs.size ();
+		int lineStart = glyphStart;
+		int lastBreak = -1;
+		int x = 0;
+
+		std::vector<int> breaks;
+		breaks.push_back (glyphStart);
+
+		for (int i = glyphStart; i < glyphEnd; i++) {
+
+			TextLayoutGlyph* glyph = &glyphs[i];
+			bool clusterStart = (i == glyphStart || glyph->cluster != glyphs[i - 1].cluster);
+
+			if (i > lineStart && clusterStart && chars[glyph->character].breakBefore) {
+
+				lastBreak = i;
+
+			}
+
+			x += glyph->advance;
+
+			// trailing spaces hang past the edge instead of wrapping
+
+			if (width > 0 && x > width && chars[glyph->character].breakClass != LB_SP) {
+
+				int breakAt = lastBreak;
+
+				if (breakAt <= lineStart) {
+
+					// nothing to break at, so the line is split between clusters
+
+					breakAt = -1;
+
+					for (int j = i; j > lineStart; j--) {
+
+						if (glyphs[j].cluster != glyphs[j - 1].cluster) {
+
+							breakAt = j;
+							break;
+
+						}
+
+					}
+
+				}
+
+				if (breakAt > lineStart) {
+
+					breaks.push_back (breakAt);
+					lineStart = breakAt;
+					lastBreak = -1;
+					x = 0;
+
+					for (int j = breakAt; j <= i; j++) {
+
+						x += glyphs[j].advance;
+
+					}
+
+				}
+
+			}
+
+		}
+
+		breaks.push_back (glyphEnd);
+
+		for (size_t i = 0; i + 1 < breaks.size (); i++) {
+
+			TextLayoutLine line;
+			line.glyphStart = breaks[i];
+			line.glyphEnd = breaks[i + 1];
+			line.paragraphEnd = (i + 2 == breaks.size ());
+			line.rtl = rtl;
+			line.textStart = (i == 0) ? textStart : chars[glyphs[line.glyphStart].character].utf16;
+			line.textEnd = line.paragraphEnd ? textEnd : chars[glyphs[line.glyphEnd].character].utf16;
+			lines.push_back (line);
+
+		}
+
+	}
+
+
+	void TextLayout::ClearFonts () {
+
+		for (size_t i = 0; i < hbFonts.size (); i++) {
+
+			hb_font_destroy ((hb_font_t*)hbFonts[i]);
+			Font::ReleaseFace (faces[i]);
+
+		}
+
+		faces.clear ();
+		hbFonts.clear ();
+
+	}
+
+
+	void TextLayout::Itemize (int charStart, int charEnd, bool* rtl) {
+
+		// resolves bidi levels, scripts, fonts and break opportunities for one paragraph, then splits it into runs
+
+		hb_unicode_funcs_t* unicode = hb_unicode_funcs_get_default ();
+		int count = charEnd - charStart;
+
+		std::vector<int> types (count);
+		std::vector<hb_script_t> scripts (count);
+		std::vector<hb_unicode_general_category_t> categories (count);
+
+		int paragraphLevel = -1;
+
+		for (int i = 0; i < count; i++) {
+
+			unsigned int codepoint = chars[charStart + i].codepoint;
+			scripts[i] = hb_unicode_script (unicode, codepoint);
+			categories[i] = hb_unicode_general_category (unicode, codepoint);
+			types[i] = bidi_type (scripts[i], categories[i]);
+
+			if (paragraphLevel < 0 && (types[i] == BIDI_L || types[i] == BIDI_R)) {
+
+				paragraphLevel = (types[i] == BIDI_R) ? 1 : 0;
+
+			}
+
+		}
+
+		if (paragraphLevel < 0) paragraphLevel = 0;
+		*rtl = (paragraphLevel == 1);
+
+		// marks take the type before them, and numbers after left-to-right text are left-to-right
+
+		int edge = paragraphLevel ? BIDI_R : BIDI_L;
+		int lastStrong = edge;
+
+		for (int i = 0; i < count; i++) {
+
+			if (types[i] == BIDI_NSM) {
+
+				types[i] = i > 0 ? types[i - 1] : edge;
+
+			}
+
+			if (types[i] == BIDI_L || types[i] == BIDI_R) {
+
+				lastStrong = types[i];
+
+			} else if (types[i] == BIDI_EN && lastStrong == BIDI_L) {
+
+				types[i] = BIDI_L;
+
+			}
+
+		}
+
+		// neutrals between text of the same direction take it, others take the paragraph direction
+
+		for (int i = 0; i < count;) {
+
+			if (types[i] != BIDI_N) {
+
+				i++;
+				continue;
+
+			}
+
+			int j = i;
+			while (j < count && types[j] == BIDI_N) j++;
+
+			int before = i > 0 ? (types[i - 1] == BIDI_L ? BIDI_L : BIDI_R) : edge;
+			int after = j < count ? (types[j] == BIDI_L ? BIDI_L : BIDI_R) : edge;
+			int type = (before == after) ? before : edge;
+
+			for (; i < j; i++) {
+
+				types[i] = type;
+
+			}
+
+		}
+
+		hb_script_t lastScript = HB_SCRIPT_INVALID;
+		hb_script_t firstScript = HB_SCRIPT_INVALID;
+
+		for (int i = 0; i < count; i++) {
+
+			if (scripts[i] != HB_SCRIPT_COMMON && scripts[i] != HB_SCRIPT_INHERITED && scripts[i] != HB_SCRIPT_UNKNOWN) {
+
+				lastScript = scripts[i];
+				if (firstScript == HB_SCRIPT_INVALID) firstScript = scripts[i];
+
+			}
+
+			TextLayoutChar* character = &chars[charStart + i];
+
+			if (paragraphLevel == 0) {
+
+				character->level = (types[i] == BIDI_L) ? 0 : (types[i] == BIDI_R ? 1 : 2);
+
+			} else {
+
+				character->level = (types[i] == BIDI_R) ? 1 : 2;
+
+			}
+
+			character->script = lastScript;
+
+		}
+
+		for (int i = 0; i < count && chars[charStart + i].script == HB_SCRIPT_INVALID; i++) {
+
+			chars[charStart + i].script = (firstScript != HB_SCRIPT_INVALID) ? firstScript : HB_SCRIPT_COMMON;
+
+		}
+
+		// the first font with the glyph wins, marks and shared characters stay with the font before them if it can
+
+		for (int i = 0; i < count; i++) {
+
+			TextLayoutChar* character = &chars[charStart + i];
+			int previous = i > 0 ? chars[charStart + i - 1].font : -1;
+			bool attached = (types[i] == BIDI_NSM || categories[i] == HB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK || categories[i] == HB_UNICODE_GENERAL_CATEGORY_SPACING_MARK || categories[i] == HB_UNICODE_GENERAL_CATEGORY_ENCLOSING_MARK || categories[i] == HB_UNICODE_GENERAL_CATEGORY_FORMAT || categories[i] == HB_UNICODE_GENERAL_CATEGORY_CONTROL || (character->codepoint >= 0xFE00 && character->codepoint <= 0xFE0F) || (character->codepoint >= 0xE0100 && character->codepoint <= 0xE01EF));
+			bool shared = (scripts[i] == HB_SCRIPT_COMMON || scripts[i] == HB_SCRIPT_INHERITED);
+
+			character->font = -1;
+
+			if (previous >= 0 && (attached || (shared && FT_Get_Char_Index ((FT_Face)faces[previous], character->codepoint) != 0))) {
+
+				character->font = previous;
+
+			} else {
+
+				for (size_t j = 0; j < faces.size (); j++) {
+
+					if (FT_Get_Char_Index ((FT_Face)faces[j], character->codepoint) != 0) {
+
+						character->font = j;
+						break;
+
+					}
+
+				}
+
+			}
+
+			if (character->font < 0) {
+
+				character->font = previous >= 0 ? previous : 0;
+
+			}
+
+		}
+
+		// break opportunities, combining marks take the class of the character they follow
+
+		int before = -1;
+		int beforeSpaces = -1;
+
+		for (int i = 0; i < count; i++) {
+
+			TextLayoutChar* character = &chars[charStart + i];
+			int breakClass = break_class (character->codepoint, categories[i]);
+
+			if (breakClass == LB_CM) {
+
+				breakClass = (before < 0 || before == LB_SP || before == LB_ZW) ? LB_AL : before;
+				character->breakClass = breakClass;
+				character->breakBefore = (before == LB_SP);
+
+			} else {
+
+				character->breakClass = breakClass;
+				character->breakBefore = (before >= 0) && can_break (before, breakClass, beforeSpaces);
+
+			}
+
+			before = breakClass;
+
+			if (breakClass != LB_SP) {
+
+				beforeSpaces = breakClass;
+
+			}
+
+		}
+
+		for (int i = charStart; i < charEnd; i++) {
+
+			TextLayoutChar* character = &chars[i];
+
+			if (i == charStart || character->font != runs.back ().font || character->script != runs.back ().script || character->level != runs.back ().level) {
+
+				TextLayoutRun run;
+				run.end = i + 1;
+				run.font = character->font;
+				run.glyphEnd = 0;
+				run.glyphStart = 0;
+				run.level = character->level;
+				run.script = character->script;
+				run.start = i;
+				runs.push_back (run);
+
+			} else {
+
+				runs.back ().end = i + 1;
+
+			}
+
+		}
+
+	}
+
+
+	int TextLayout::Layout (const char* text, int size, int width, TextLayoutAlign align, Bytes* output) {
+
+		chars.clear ();
+		glyphs.clear ();
+		lines.clear ();
+		runs.clear ();
+
+		if (!text || faces.empty ()) {
+
+			return Write (width, align, output);
+
+		}
+
+		for (size_t i = 0; i < faces.size (); i++) {
+
+			FT_Set_Char_Size ((FT_Face)faces[i], 0, size * 64, 72, 72);
+			hb_ft_font_changed ((hb_font_t*)hbFonts[i]);
+
+		}
+
+		const unsigned char* bytes = (const unsigned char*)text;
+		int length = strlen (text);
+		int position = 0;
+		int utf16 = 0;
+
+		while (position < length) {
+
+			TextLayoutChar character;
+			character.offset = position;
+			character.utf16 = utf16;
+			character.codepoint = decode_utf8 (bytes, length, &position);
+			character.breakBefore = false;
+			character.breakClass = LB_AL;
+			character.font = 0;
+			character.level = 0;
+			character.script = HB_SCRIPT_COMMON;
+			chars.push_back (character);
+
+			utf16 += (character.codepoint >= 0x10000) ? 2 : 1;
+
+		}
+
+		int count = chars.size ();
+		int i = 0;
+
+		while (true) {
+
+			int start = i;
+
+			while (i < count && !is_paragraph_separator (chars[i].codepoint)) i++;
+
+			bool rtl = false;
+			int runStart = runs.size ();
+			int glyphStart = glyphs.size ();
+
+			Itemize (start, i, &rtl);
+			Shape (text, length, runStart);
+			BreakLines (glyphStart, width * 64, rtl, start < count ? chars[start].utf16 : utf16, i < count ? chars[i].utf16 : utf16);
+
+			if (i >= count) break;
+
+			if (chars[i].codepoint == 0x0D && i + 1 < count && chars[i + 1].codepoint == 0x0A) i++;
+			i++;
+
+		}
+
+		return Write (width, align, output);
+
+	}
+
+
+	void TextLayout::Shape (const char* text, int length, int runStart) {
+
+		hb_buffer_t* hbBuffer = (hb_buffer_t*)buffer;
+
+		for (size_t i = runStart; i < runs.size (); i++) {
+
+			TextLayoutRun* run = &runs[i];
+			int start = chars[run->start].offset;
+			int end = (run->end < (int)chars.size ()) ? chars[run->end].offset : length;
+			bool rtl = (run->level & 1);
+
+			// the whole string is passed so shaping sees the context around the run
+
+			hb_buffer_clear_contents (hbBuffer);
+			hb_buffer_add_utf8 (hbBuffer, text, length, start, end - start);
+			hb_buffer_set_direction (hbBuffer, rtl ? HB_DIRECTION_RTL : HB_DIRECTION_LTR);
+			hb_buffer_set_script (hbBuffer, (hb_script_t)run->script);
+			hb_buffer_set_language (hbBuffer, hb_language_get_default ());
+			hb_shape ((hb_font_t*)hbFonts[run->font], hbBuffer, NULL, 0);
+
+			unsigned int glyphCount = 0;
+			hb_glyph_info_t* info = hb_buffer_get_glyph_infos (hbBuffer, &glyphCount);
+			hb_glyph_position_t* positions = hb_buffer_get_glyph_positions (hbBuffer, &glyphCount);
+
+			// glyphs are kept in logical order for line breaking, right-to-left runs are reversed back when written
+
+			run->glyphStart = glyphs.size ();
+			int character = run->start;
+
+			for (unsigned int j = 0; j < glyphCount; j++) {
+
+				unsigned int k = rtl ? glyphCount - 1 - j : j;
+
+				while (character + 1 < run->end && chars[character + 1].offset <= (int)info[k].cluster) character++;
+				while (character > run->start && chars[character].offset > (int)info[k].cluster) character--;
+
+				TextLayoutGlyph glyph;
+				glyph.advance = positions[k].x_advance;
+				glyph.character = character;
+				glyph.cluster = info[k].cluster;
+				glyph.font = run->font;
+				glyph.index = info[k].codepoint;
+				glyph.offsetX = positions[k].x_offset;
+				glyph.offsetY = positions[k].y_offset;
+				glyph.run = i;
+				glyphs.push_back (glyph);
+
+			}
+
+			run->glyphEnd = glyphs.size ();
+
+		}
+
+	}
+
+
+	int TextLayout::Write (int width, TextLayoutAlign align, Bytes* output) {
+
+		// Int32 values, in 26.6 for positions and sizes:
+		// header: line count, glyph count, width, height
+		// lines: first glyph, glyph count, x, baseline y, width, ascent, descent, text start, text end
+		// glyphs, left to right within each line: font, glyph index, text index, x, y, advance
+		// text indices count UTF-16 code units
+
+		int maxWidth = 0;
+
+		for (size_t i = 0; i < lines.size (); i++) {
+
+			TextLayoutLine* line = &lines[i];
+			line->ascent = 0;
+			line->descent = 0;
+			line->height = 0;
+			line->width = 0;
+
+			int contentEnd = line->glyphEnd;
+
+			while (contentEnd > line->glyphStart && chars[glyphs[contentEnd - 1].character].breakClass == LB_SP) contentEnd--;
+
+			for (int j = line->glyphStart; j < contentEnd; j++) {
+
+				line->width += glyphs[j].advance;
+
+			}
+
+			// empty lines still take the height of the first font
+
+			for (int j = line->glyphStart; j == line->glyphStart || j < line->glyphEnd; j++) {
+
+				int font = j < line->glyphEnd ? glyphs[j].font : 0;
+				FT_Size_Metrics* metrics = &((FT_Face)faces[font])->size->metrics;
+
+				line->ascent = std::max (line->ascent, (int)metrics->ascender);
+				line->descent = std::max (line->descent, (int)-metrics->descender);
+				line->height = std::max (line->height, (int)metrics->height);
+
+			}
+
+			line->height = std::max (line->height, line->ascent + line->descent);
+			maxWidth = std::max (maxWidth, line->width);
+
+		}
+
+		int boxWidth = width > 0 ? width * 64 : maxWidth;
+		int totalHeight = 0;
+
+		for (size_t i = 0; i < lines.size (); i++) {
+
+			totalHeight += lines[i].height;
+
+		}
+
+		output->Resize ((4 + lines.size () * 9 + glyphs.size () * 6) * 4);
+
+		int* data = (int*)output->b;
+		int* lineData = data + 4;
+		int* glyphData = lineData + lines.size () * 9;
+
+		data[0] = lines.size ();
+		data[1] = glyphs.size ();
+		data[2] = boxWidth;
+		data[3] = totalHeight;
+
+		std::vector<TextLayoutRun> slices;
+		int outputGlyph = 0;
+		int top = 0;
+
+		for (size_t i = 0; i < lines.size (); i++) {
+
+			TextLayoutLine* line = &lines[i];
+			int baseline = top + line->ascent;
+			top += line->height;
+
+			int contentEnd = line->glyphEnd;
+			int trailingWidth = 0;
+
+			while (contentEnd > line->glyphStart && chars[glyphs[contentEnd - 1].character].breakClass == LB_SP) {
+
+				contentEnd--;
+				trailingWidth += glyphs[contentEnd].advance;
+
+			}
+
+			// pieces of runs on this line, with trailing spaces at the paragraph level, reordered for display
+
+			slices.clear ();
+
+			for (int j = line->glyphStart; j < contentEnd; j++) {
+
+				TextLayoutRun* run = &runs[glyphs[j].run];
+
+				if (j == line->glyphStart || glyphs[j].run != glyphs[j - 1].run) {
+
+					TextLayoutRun slice = *run;
+					slice.glyphStart = j;
+					slice.glyphEnd = j + 1;
+					slices.push_back (slice);
+
+				} else {
+
+					slices.back ().glyphEnd = j + 1;
+
+				}
+
+			}
+
+			if (contentEnd < line->glyphEnd) {
+
+				TextLayoutRun slice;
+				slice.glyphStart = contentEnd;
+				slice.glyphEnd = line->glyphEnd;
+				slice.level = line->rtl ? 1 : 0;
+				slices.push_back (slice);
+
+			}
+
+			int maxLevel = 0;
+			int minOddLevel = 0x7FFFFFFF;
+
+			for (size_t j = 0; j < slices.size (); j++) {
+
+				maxLevel = std::max (maxLevel, slices[j].level);
+				if (slices[j].level & 1) minOddLevel = std::min (minOddLevel, slices[j].level);
+
+			}
+
+			for (int level = maxLevel; level >= minOddLevel; level--) {
+
+				for (size_t j = 0; j < slices.size ();) {
+
+					if (slices[j].level < level) {
+
+						j++;
+						continue;
+
+					}
+
+					size_t k = j;
+					while (k < slices.size () && slices[k].level >= level) k++;
+					std::reverse (slices.begin () + j, slices.begin () + k);
+					j = k;
+
+				}
+
+			}
+
+			TextLayoutAlign lineAlign = align;
+
+			if (lineAlign == TEXT_ALIGN_JUSTIFY && (line->paragraphEnd || width <= 0)) {
+
+				lineAlign = TEXT_ALIGN_START;
+
+			}
+
+			if (lineAlign == TEXT_ALIGN_START) lineAlign = line->rtl ? TEXT_ALIGN_RIGHT : TEXT_ALIGN_LEFT;
+			if (lineAlign == TEXT_ALIGN_END) lineAlign = line->rtl ? TEXT_ALIGN_LEFT : TEXT_ALIGN_RIGHT;
+
+			int x = 0;
+			int spaces = 0;
+			int extra = 0;
+
+			if (lineAlign == TEXT_ALIGN_RIGHT) {
+
+				x = boxWidth - line->width;
+
+			} else if (lineAlign == TEXT_ALIGN_CENTER) {
+
+				x = (boxWidth - line->width) / 2;
+
+			} else if (lineAlign == TEXT_ALIGN_JUSTIFY) {
+
+				for (int j = line->glyphStart; j < contentEnd; j++) {
+
+					if (chars[glyphs[j].character].breakClass == LB_SP) spaces++;
+
+				}
+
+				extra = spaces > 0 ? boxWidth - line->width : 0;
+
+			}
+
+			lineData[0] = outputGlyph;
+			lineData[1] = line->glyphEnd - line->glyphStart;
+			lineData[2] = x;
+			lineData[3] = baseline;
+			lineData[4] = spaces > 0 ? line->width + extra : line->width;
+			lineData[5] = line->ascent;
+			lineData[6] = line->descent;
+			lineData[7] = line->textStart;
+			lineData[8] = line->textEnd;
+			lineData += 9;
+
+			// right-to-left trailing spaces end up on the left, outside of the aligned text
+
+			int pen = line->rtl ? x - trailingWidth : x;
+			int spaceIndex = 0;
+
+			for (size_t j = 0; j < slices.size (); j++) {
+
+				TextLayoutRun* slice = &slices[j];
+				bool reversed = (slice->level & 1);
+
+				for (int k = 0; k < slice->glyphEnd - slice->glyphStart; k++) {
+
+					TextLayoutGlyph* glyph = &glyphs[reversed ? slice->glyphEnd - 1 - k : slice->glyphStart + k];
+
+					glyphData[0] = glyph->font;
+					glyphData[1] = glyph->index;
+					glyphData[2] = chars[glyph->character].utf16;
+					glyphData[3] = pen + glyph->offsetX;
+					glyphData[4] = baseline - glyph->offsetY;
+					glyphData[5] = glyph->advance;
+					glyphData += 6;
+
+					pen += glyph->advance;
+
+					if (spaces > 0 && chars[glyph->character].breakClass == LB_SP && (int)(glyph - &glyphs[0]) < contentEnd) {
+
+						// the extra width is spread evenly, with the remainder going to the first spaces
+
+						pen += extra / spaces + (spaceIndex < extra % spaces ? 1 : 0);
+						spaceIndex++;
+
+					}
+
+				}
+
+			}
+
+			outputGlyph += line->glyphEnd - line->glyphStart;
+
+		}
+
+		return lines.size ();
+
+	}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include <utils/BufferPool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+
+#define BUFFER_POOL_ALIGNMENT 64
+#define BUFFER_POOL_PAGE_SIZE 4096
+
+
+namespace lime {
+
+
+	struct BufferHeader {
+
+		void* allocation;
+		size_t capacity;
+
+	};
+
+
+	static std::unordered_set<void*> allocations;
+	static size_t bytesRetained = 0;
+	static std::map<size_t, std::vector<void*> > freeBlocks;
+	static int hits = 0;
+	static int misses = 0;
+	static std::mutex mutex;
+	static size_t retention = 32 * 1024 * 1024;
+
+
+	static size_t GetSizeClass (size_t size) {
+
+		// powers of two for small blocks, whole pages above that, so that
+		// same-sized textures always land in the same class
+
+		if (size <= BUFFER_POOL_ALIGNMENT) {
+
+			return BUFFER_POOL_ALIGNMENT;
+
+		} else if (size < BUFFER_POOL_PAGE_SIZE) {
+
+			size_t capacity = BUFFER_POOL_ALIGNMENT;
+			while (capacity < size) capacity <<= 1;
+			return capacity;
+
+		} else {
+
+			return (size + BUFFER_POOL_PAGE_SIZE - 1) & ~(size_t)(BUFFER_POOL_PAGE_SIZE - 1);
+
+		}
+
+	}
+
+
+	static inline BufferHeader* GetHeader (const void* data) {
+
+		return (BufferHeader*)((uintptr_t)data - BUFFER_POOL_ALIGNMENT);
+
+	}
+
+
+	static void Trim (size_t limit) {
+
+		// largest blocks go first, they are the least likely to be reused
+
+		while (bytesRetained > limit && !freeBlocks.empty ()) {
+
+			std::map<size_t, std::vector<void*> >::iterator largest = --freeBlocks.end ();
+			void* data = largest->second.back ();
+			largest->second.pop_back ();
+			bytesRetained -= largest->first;
+
+			if (largest->second.empty ()) {
+
+				freeBlocks.erase (largest);
+
+			}
+
+			allocations.erase (data);
+			free (GetHeader (data)->allocation);
+
+		}
+
+	}
+
+
+	void* BufferPool::Allocate (size_t size) {
+
+		if (size == 0) return NULL;
+
+		size_t capacity = GetSizeClass (size);
+
+		mutex.lock ();
+
+		std::map<size_t, std::vector<void*> >::iterator it = freeBlocks.find (capacity);
+
+		if (it != freeBlocks.end ()) {
+
+			void* data = it->second.back ();
+			it->second.pop_back ();
+
+			if (it->second.empty ()) {
+
+				freeBlocks.erase (it);
+
+			}
+
+			bytesRetained -= capacity;
+			hits++;
+			mutex.unlock ();
+
+			return data;
+
+		}
+
+		misses++;
+		mutex.unlock ();
+
+		// the header sits in the alignment padding just before the data
+
+		void* allocation = malloc (capacity + BUFFER_POOL_ALIGNMENT * 2);
+
+		if (!allocation) return NULL;
+
+		uintptr_t data = ((uintptr_t)allocation + BUFFER_POOL_ALIGNMENT * 2 - 1) & ~(uintptr_t)(BUFFER_POOL_ALIGNMENT - 1);
+		BufferHeader* header = GetHeader ((void*)data);
+		header->allocation = allocation;
+		header->capacity = capacity;
+
+		// only addresses handed out here are trusted to have a header
+
+		mutex.lock ();
+		allocations.insert ((void*)data);
+		mutex.unlock ();
+
+		return (void*)data;
+
+	}
+
+
+	void BufferPool::Clear () {
+
+		std::lock_guard<std::mutex> lock (mutex);
+		Trim (0);
+
+	}
+
+
+	size_t BufferPool::GetBytesRetained () {
+
+		std::lock_guard<std::mutex> lock (mutex);
+		return bytesRetained;
+
+	}
+
+
+	size_t BufferPool::GetCapacity (const void* data) {
+
+		if (!data) return 0;
+
+		std::lock_guard<std::mutex> lock (mutex);
+		return allocations.count ((void*)data) ? GetHeader (data)->capacity : 0;
+
+	}
+
+
+	int BufferPool::GetHits () {
+
+		std::lock_guard<std::mutex> lock (mutex);
+		return hits;
+
+	}
+
+
+	int BufferPool::GetMisses () {
+
+		std::lock_guard<std::mutex> lock (mutex);
+		return misses;
+
+	}
+
+
+	size_t BufferPool::GetRetention () {
+
+		std::lock_guard<std::mutex> lock (mutex);
+		return retention;
+
+	}
+
+
+	bool BufferPool::Release (void* data) {
+
+		// false for memory the pool did not allocate, which stays with the caller
+
+		if (!data) return true;
+
+		BufferHeader* header = GetHeader (data);
+
+		mutex.lock ();
+
+		if (!allocations.count (data)) {
+
+			mutex.unlock ();
+			return false;
+
+		}
+
+		if (bytesRetained + header->capacity <= retention) {
+
+			freeBlocks[header->capacity].push_back (data);
+			bytesRetained += header->capacity;
+			mutex.unlock ();
+			return true;
+
+		}
+
+		allocations.erase (data);
+		mutex.unlock ();
+
+		free (header->allocation);
+		return true;
+
+	}
+
+
+	void BufferPool::SetRetention (size_t bytes) {
+
+		std::lock_guard<std::mutex> lock (mutex);
+		retention = bytes;
+		Trim (retention);
+
+	}
+
+
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <system/Mutex.h>
 #include <system/System.h>
+#include <utils/BufferPool.h>
 #include <utils/Bytes.h>
 #include <map>
 
@@ -70,7 +71,7 @@ namespace lime {
 
 			if (usingValue.find (this) == usingValue.end () && b) {
 
-				free (b);
+				if (!BufferPool::Release (b)) free (b);
 
 			}
 
@@ -117,10 +118,10 @@ namespace lime {
 
 		if (size != length || (length > 0 && !b)) {
 
-			mutex.Lock ();
-
 			if (size <= 0) {
 
+				mutex.Lock ();
+
 				if (b) {
 
 					if (usingValue.find (this) != usingValue.end ()) {
@@ -129,7 +130,7 @@ namespace lime {
 
 					} else {
 
-						free (b);
+						if (!BufferPool::Release (b)) free (b);
 
 					}
 
@@ -138,25 +139,48 @@ namespace lime {
 
 				}
 
+				mutex.Unlock ();
+
 			} else {
 
-				unsigned char* data = (unsigned char*)malloc (sizeof (char) * size);
+				mutex.Lock ();
+				bool owned = (b && usingValue.find (this) == usingValue.end ());
+				mutex.Unlock ();
 
-				if (b) {
+				if (owned) {
 
-					if (length) {
+					// pooled blocks are rounded up to a size class, so most resizes fit in place
 
-						memcpy (data, b, length < size ? length : size);
+					size_t capacity = BufferPool::GetCapacity (b);
+
+					if ((size_t)size <= capacity && (size_t)size >= capacity / 2) {
+
+						length = size;
+						return;
 
 					}
 
+				}
+
+				unsigned char* data = (unsigned char*)BufferPool::Allocate (size);
+
+				if (b && length) {
+
+					memcpy (data, b, length < size ? length : size);
+
+				}
+
+				mutex.Lock ();
+
+				if (b) {
+
 					if (usingValue.find (this) != usingValue.end ()) {
 
 						usingValue.erase (this);
 
 					} else {
 
-						free (b);
+						if (!BufferPool::Release (b)) free (b);
 
 					}
 
@@ -169,9 +193,9 @@ namespace lime {
 				b = data;
 				length = size;
 
-			}
+				mutex.Unlock ();
 
-			mutex.Unlock ();
+			}
 
 		}
 